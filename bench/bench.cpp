@@ -0,0 +1,181 @@
+#include "bench.h"
+
+#include "sensorlogger.h"
+#include "numberformat.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+
+volatile double benchSink = 0;
+
+benchRunner::benchRunner(const benchOptions &options)
+{
+	_options = options;
+}
+
+const benchOptions& benchRunner::options() const
+{
+	return _options;
+}
+
+bool benchRunner::selected(const std::string &suite) const
+{
+	return (_options.filter.size() == 0) || (suite.find(_options.filter) != std::string::npos);
+}
+
+benchResult& benchRunner::record(const std::string &suite, const std::string &name, uint64_t iterations, double seconds)
+{
+	benchResult result;
+	result.suite      = suite;
+	result.name       = name;
+	result.iterations = iterations;
+	result.seconds    = seconds;
+	_results.push_back(result);
+
+	std::cerr << suite << "/" << name << ": " << (seconds * 1e9 / static_cast<double>(std::max(iterations, static_cast<uint64_t>(1)))) << " ns/op" << std::endl;
+
+	return _results.back();
+}
+
+static void appendJSONString(std::string &out, const std::string &s)
+{
+	out += '"';
+	for(size_t i=0; i<s.size(); ++i)
+	{
+		if((s[i] == '"') || (s[i] == '\\'))
+			out += '\\';
+		out += s[i];
+	}
+	out += '"';
+}
+
+std::string benchRunner::toJSON() const
+{
+	numberFormat f;
+	f.setShortest();
+
+	std::string out = "{\n  \"sensorlogger_version\": ";
+	appendJSONString(out, SENSORLOGGER_VERSION);
+	out += ",\n  \"results\": [";
+
+	for(size_t i=0; i<_results.size(); ++i)
+	{
+		const benchResult &r = _results.at(i);
+		double perOp = r.seconds / static_cast<double>(std::max(r.iterations, static_cast<uint64_t>(1)));
+
+		out += (i > 0) ? ",\n    {" : "\n    {";
+		out += "\"suite\": ";
+		appendJSONString(out, r.suite);
+		out += ", \"name\": ";
+		appendJSONString(out, r.name);
+		out += ", \"iterations\": " + std::to_string(r.iterations);
+		out += ", \"seconds\": " + f.format(r.seconds);
+		out += ", \"ns_per_op\": " + f.format(perOp * 1e9);
+
+		for(size_t m=0; m<r.metrics.size(); ++m)
+		{
+			out += ", ";
+			appendJSONString(out, r.metrics.at(m).first);
+			out += ": " + f.format(r.metrics.at(m).second);
+		}
+
+		out += "}";
+	}
+
+	out += "\n  ]\n}\n";
+	return out;
+}
+
+benchSensor::benchSensor(logger* root, const std::string &sensorID, uint64_t restPeriod)
+{
+	setPointerToLogger(root);
+	setSensorID(sensorID);
+	setMinimumRestPeriod(restPeriod);
+}
+
+sensor_type benchSensor::type() const
+{
+	return sensor_json;
+}
+
+bool benchSensor::measure(uint64_t currentTimestamp)
+{
+	return false;
+}
+
+static void usage()
+{
+	std::cerr << "sensorlogger_bench [--filter suite] [--min-time s] [--sensors n] [--rate Hz] [--duration s] [--mqtt-duration s] [--output file]" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+	benchOptions options;
+	options.minTime  = 0.2;
+	options.nSensors = 20;
+	options.rate     = 1.0;
+	options.duration = 86400;
+	options.mqttDuration = 5;
+
+	for(int i=1; i<argc; ++i)
+	{
+		std::string arg = argv[i];
+		if((i+1) >= argc)
+		{
+			usage();
+			return 1;
+		}
+
+		std::string value = argv[++i];
+		if(arg == "--filter")
+			options.filter = value;
+		else if(arg == "--min-time")
+			options.minTime = atof(value.c_str());
+		else if(arg == "--sensors")
+			options.nSensors = static_cast<size_t>(atol(value.c_str()));
+		else if(arg == "--rate")
+			options.rate = atof(value.c_str());
+		else if(arg == "--duration")
+			options.duration = atof(value.c_str());
+		else if(arg == "--mqtt-duration")
+			options.mqttDuration = atof(value.c_str());
+		else if(arg == "--output")
+			options.output = value;
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	benchRunner runner(options);
+
+	if(runner.selected("storage"))
+		benchStorage(runner);
+
+	if(runner.selected("json"))
+		benchJSON(runner);
+
+	if(runner.selected("logbook"))
+		benchLogbook(runner);
+
+	if(runner.selected("pipeline"))
+		benchPipeline(runner);
+
+	if(runner.selected("mqtt"))
+		benchMQTT(runner);
+
+	std::string results = runner.toJSON();
+	std::cout << results;
+
+	if(options.output.size() > 0)
+	{
+		std::ofstream out(options.output.c_str());
+		out << results;
+	}
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+// Benchmarks for Sensorlogger's measurement, statistics and logbook code.
+// Each benchmark runs its operation in batches until a minimum time has
+// passed and reports the time per operation. Results are collected and
+// printed as JSON, so that they can be compared between versions.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+
+#include "sensor.h"
+
+struct benchResult
+{
+	std::string suite;
+	std::string name;
+	uint64_t    iterations;
+	double      seconds;
+	std::vector<std::pair<std::string, double>> metrics;  // additional results
+};
+
+struct benchOptions
+{
+	std::string filter;    // only suites that contain this text
+	double   minTime;      // s per micro-benchmark
+	size_t   nSensors;     // for the macro benchmarks
+	double   rate;         // samples per second and sensor
+	double   duration;     // s of virtual time for the pipeline benchmark
+	double   mqttDuration; // s of real time for the MQTT benchmark
+	std::string output;    // file for the JSON results, empty: stdout only
+};
+
+class benchRunner
+{
+private:
+	benchOptions _options;
+	std::vector<benchResult> _results;
+
+public:
+	benchRunner(const benchOptions &options);
+
+	const benchOptions& options() const;
+	bool selected(const std::string &suite) const;
+
+	// Calls op(n) with growing n until it takes at least the minimum time;
+	// op has to run its operation n times. The result may be extended
+	// with additional metrics until the next benchmark runs.
+	template<typename F>
+	benchResult& run(const std::string &suite, const std::string &name, F op)
+	{
+		uint64_t n = 1;
+		double seconds = 0;
+		while(true)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			op(n);
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if((seconds >= _options.minTime) || (n >= (UINT64_C(1) << 40)))
+				break;
+
+			// Aim a bit above the minimum time with the next batch:
+			if(seconds > 0)
+				n = std::max(n * 2, static_cast<uint64_t>(1.2 * _options.minTime / seconds * static_cast<double>(n)));
+			else
+				n *= 100;
+		}
+
+		return record(suite, name, n, seconds);
+	}
+
+	benchResult& record(const std::string &suite, const std::string &name, uint64_t iterations, double seconds);
+
+	std::string toJSON() const;
+};
+
+// Keeps the compiler from optimizing benchmarked calculations away.
+extern volatile double benchSink;
+
+// Sensor without a data source; the benchmarks add its measurements.
+class benchSensor : public sensor
+{
+public:
+	benchSensor(logger* root, const std::string &sensorID, uint64_t restPeriod);
+
+	sensor_type type() const;
+	bool measure(uint64_t currentTimestamp);
+};
+
+// Suites:
+void benchStorage(benchRunner &runner);
+void benchJSON(benchRunner &runner);
+void benchLogbook(benchRunner &runner);
+void benchPipeline(benchRunner &runner);
+void benchMQTT(benchRunner &runner);
+
+#endif
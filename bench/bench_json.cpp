@@ -0,0 +1,75 @@
+#include "bench.h"
+
+#include "json.h"
+
+// Typical MQTT payload of a sensor that reports several values:
+static const char* mqttPayload =
+	"{\"Time\": \"2022-10-03T12:00:00\", \"SI7021\": {\"Temperature\": 21.4, \"Humidity\": 48.2, \"DewPoint\": 10.0}, \"TempUnit\": \"C\"}";
+
+// Sensorlogger configuration with a few sensors and logbooks:
+static std::string configDocument()
+{
+	std::string doc = "{\"general\": {\"logfile\": \"/home/username/sensorlogger.log\", \"loglevel\": \"info\", \"default_rest_period\": {\"value\": 1, \"unit\": \"min\"}}, \"sensors\": [";
+	for(int i=0; i<20; ++i)
+	{
+		if(i > 0)
+			doc += ", ";
+
+		doc += "{\"sensor_id\": \"sensor_" + std::to_string(i) + "\", \"mqtt_subscribe\": \"home/sensor/" + std::to_string(i) + "\", \"json_key\": [\"SI7021\", \"Temperature\"], \"rest_period\": {\"value\": 30, \"unit\": \"s\"}, \"factor\": 1.0, \"offset\": 0}";
+	}
+
+	doc += "], \"logbooks\": [{\"filename\": \"/home/username/weather.txt\", \"cycle_time\": {\"value\": 15, \"unit\": \"min\"}, \"max_entries\": 2000, \"columns\": [";
+	for(int i=0; i<20; ++i)
+	{
+		if(i > 0)
+			doc += ", ";
+
+		doc += "{\"title\": \"T" + std::to_string(i) + "\", \"unit\": \"°C\", \"sensor_id\": \"sensor_" + std::to_string(i) + "\", \"operation\": \"mean\", \"evaluation_period\": {\"value\": 1, \"unit\": \"h\"}, \"mqtt_publish\": \"home/stats/" + std::to_string(i) + "\"}";
+	}
+	doc += "]}]}";
+
+	return doc;
+}
+
+// Web API response with a long array of readings:
+static std::string seriesDocument()
+{
+	std::string doc = "{\"station\": \"Example\", \"readings\": [";
+	for(int i=0; i<500; ++i)
+	{
+		if(i > 0)
+			doc += ", ";
+
+		doc += "{\"t\": " + std::to_string(1664798400 + i * 60) + ", \"temperature\": " + std::to_string(15.0 + (i % 40) * 0.1) + ", \"wind\": {\"speed\": 3.2, \"direction\": 270}}";
+	}
+	doc += "]}";
+
+	return doc;
+}
+
+static void benchDocument(benchRunner &runner, const std::string &name, const std::string &document, const std::vector<std::string> &keys)
+{
+	benchResult &r = runner.run("json", name, [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+		{
+			json doc;
+			doc.setContent(document);
+			doc.parse();
+
+			jsonNode* node = doc.root();
+			for(size_t i=0; i<keys.size(); ++i)
+				node = node->element(keys.at(i));
+
+			benchSink = static_cast<double>(node->nElements());
+		}
+	});
+
+	r.metrics.push_back(std::make_pair("bytes", static_cast<double>(document.size())));
+}
+
+void benchJSON(benchRunner &runner)
+{
+	benchDocument(runner, "parse_mqtt_payload", mqttPayload, {"SI7021", "Temperature"});
+	benchDocument(runner, "parse_config", configDocument(), {"sensors"});
+	benchDocument(runner, "parse_series", seriesDocument(), {"readings"});
+}
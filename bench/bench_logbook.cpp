@@ -0,0 +1,150 @@
+#include "bench.h"
+
+#include "logger.h"
+#include "logbook.h"
+#include "column.h"
+#include "clock.h"
+
+#include <cmath>
+#include <unistd.h>
+
+static std::string temporaryFile(const std::string &name)
+{
+	return "/tmp/sensorlogger_bench_" + std::to_string(getpid()) + "_" + name + ".txt";
+}
+
+static void addColumns(logbook &lb, const std::vector<benchSensor*> &sensors, uint64_t evaluationPeriod, operation op, const std::string &title)
+{
+	for(size_t i=0; i<sensors.size(); ++i)
+		lb.addColumn(new column(sensors.at(i), &lb, title + std::to_string(i), "", evaluationPeriod, op, 0, 0, "", "", 1));
+}
+
+static void planCapacity(const std::vector<benchSensor*> &sensors)
+{
+	for(size_t i=0; i<sensors.size(); ++i)
+		sensors.at(i)->setCapacity(sensors.at(i)->requiredCapacity());
+}
+
+// Writing one entry into a logbook file that already has many entries.
+void benchLogbook(benchRunner &runner)
+{
+	const uint64_t cycleTime = 60000;
+	const unsigned maxEntries = 2000;
+
+	virtualClock clock;
+	clock.set(1664798400000);
+
+	logger root;
+	root.setVerbose(false);
+	root.setClock(&clock);
+
+	std::vector<benchSensor*> sensors;
+	for(int i=0; i<10; ++i)
+		sensors.push_back(new benchSensor(&root, "bench_" + std::to_string(i), 1000));
+
+	std::string filename = temporaryFile("logbook");
+	{
+		logbook lb(&root, filename, cycleTime, maxEntries, "-");
+		addColumns(lb, sensors, 0, mean, "mean");
+		addColumns(lb, sensors, 3600000, max, "max");
+		planCapacity(sensors);
+
+		uint64_t i = 0;
+		auto writeEntry = [&]() {
+			for(uint64_t t=0; t<cycleTime; t+=1000, ++i)
+			{
+				clock.advance(1000);
+				for(size_t s=0; s<sensors.size(); ++s)
+					sensors.at(s)->addRawMeasurement(20.0 + sin(static_cast<double>(i + s) / 100.0), clock.now());
+			}
+
+			lb.write(NULL, NULL);
+		};
+
+		// Fill the logbook to its maximum size first:
+		for(unsigned e=0; e<maxEntries; ++e)
+			writeEntry();
+
+		benchResult &r = runner.run("logbook", "write_20_columns_2000_entries", [&](uint64_t n) {
+			for(uint64_t k=0; k<n; ++k)
+				writeEntry();
+		});
+		r.metrics.push_back(std::make_pair("samples_per_entry", static_cast<double>(sensors.size() * cycleTime / 1000)));
+	}
+
+	remove(filename.c_str());
+	for(size_t i=0; i<sensors.size(); ++i)
+		delete sensors.at(i);
+}
+
+/* Macro benchmark: synthetic sensors deliver samples at a fixed rate for
+   a period of virtual time; two logbooks evaluate them. Measures the
+   throughput of the whole statistics and logbook path. */
+void benchPipeline(benchRunner &runner)
+{
+	const benchOptions &options = runner.options();
+	uint64_t step = static_cast<uint64_t>(std::max(1000.0 / std::max(options.rate, 0.001), 1.0));  // ms between samples
+	uint64_t duration = static_cast<uint64_t>(options.duration * 1000.0);
+
+	virtualClock clock;
+	uint64_t start = 1664798400000;
+	clock.set(start);
+
+	logger root;
+	root.setVerbose(false);
+	root.setClock(&clock);
+
+	std::vector<benchSensor*> sensors;
+	for(size_t i=0; i<options.nSensors; ++i)
+		sensors.push_back(new benchSensor(&root, "bench_" + std::to_string(i), step));
+
+	std::string minuteFile  = temporaryFile("minutes");
+	std::string quarterFile = temporaryFile("quarters");
+	{
+		logbook minutes(&root, minuteFile, 60000, 1000, "-");
+		addColumns(minutes, sensors, 0, mean, "mean");
+
+		logbook quarters(&root, quarterFile, 900000, 1000, "-");
+		addColumns(quarters, sensors, 3600000, mean, "mean1h");
+		addColumns(quarters, sensors, 3600000, max, "max1h");
+		addColumns(quarters, sensors, 0, median, "median");
+		addColumns(quarters, sensors, 0, stdDevMean, "stddev");
+
+		planCapacity(sensors);
+
+		uint64_t nSamples = 0;
+		uint64_t nEntries = 0;
+
+		const auto wallStart = std::chrono::steady_clock::now();
+		for(uint64_t t=start; t<(start + duration); t+=step)
+		{
+			clock.set(t);
+			for(size_t s=0; s<sensors.size(); ++s)
+			{
+				if(sensors.at(s)->addRawMeasurement(20.0 + sin(static_cast<double>(t / step + s) / 300.0), t))
+					++nSamples;
+			}
+
+			uint64_t nextMinute  = minutes.getTimestampForNextLogEntry();
+			uint64_t nextQuarter = quarters.getTimestampForNextLogEntry();
+			minutes.write(NULL, NULL);
+			quarters.write(NULL, NULL);
+
+			nEntries += (minutes.getTimestampForNextLogEntry() != nextMinute) ? 1 : 0;
+			nEntries += (quarters.getTimestampForNextLogEntry() != nextQuarter) ? 1 : 0;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+		benchResult &r = runner.record("pipeline", "synthetic_sensors", nSamples, seconds);
+		r.metrics.push_back(std::make_pair("sensors", static_cast<double>(sensors.size())));
+		r.metrics.push_back(std::make_pair("rate_hz", options.rate));
+		r.metrics.push_back(std::make_pair("virtual_seconds", options.duration));
+		r.metrics.push_back(std::make_pair("logbook_entries", static_cast<double>(nEntries)));
+		r.metrics.push_back(std::make_pair("samples_per_second", (seconds > 0) ? (static_cast<double>(nSamples) / seconds) : 0));
+	}
+
+	remove(minuteFile.c_str());
+	remove(quarterFile.c_str());
+	for(size_t i=0; i<sensors.size(); ++i)
+		delete sensors.at(i);
+}
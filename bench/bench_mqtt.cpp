@@ -0,0 +1,202 @@
+#include "bench.h"
+
+#ifdef OPTION_MQTT
+
+#include "logger.h"
+#include "mqttbroker.h"
+#include "mockbroker.h"
+
+#include <ctime>
+#include <fstream>
+#include <unistd.h>
+
+static std::string sensorTopic(size_t i)
+{
+	return "bench/sensor/" + std::to_string(i);
+}
+
+// Configuration with MQTT sensors (plain numbers and JSON payloads)
+// and a logbook that publishes its results.
+static std::string writeConfig(const benchOptions &options, unsigned short brokerPort, bool withBroker)
+{
+	std::string filename = "/tmp/sensorlogger_bench_" + std::to_string(getpid()) + "_mqtt.json";
+	std::string logbookFile = "/tmp/sensorlogger_bench_" + std::to_string(getpid()) + "_mqtt.txt";
+
+	std::ofstream config(filename.c_str());
+	config << "{\"general\": {\"loglevel\": \"error\"},\n";
+
+	if(withBroker)
+		config << "\"mqtt\": {\"host\": \"127.0.0.1\", \"port\": " << brokerPort << ", \"qos\": 0, \"max_queue_size\": 100000},\n";
+
+	config << "\"sensors\": [";
+	for(size_t i=0; i<options.nSensors; ++i)
+	{
+		if(i > 0)
+			config << ",";
+
+		config << "\n  {\"sensor_id\": \"mqtt_" << i << "\", \"mqtt_subscribe\": \"" << sensorTopic(i) << "\", \"rest_period\": {\"value\": 1, \"unit\": \"ms\"}";
+		if((i % 2) == 1)
+			config << ", \"json_key\": [\"SI7021\", \"Temperature\"]";
+		config << "}";
+	}
+	config << "],\n";
+
+	config << "\"logbooks\": [{\"filename\": \"" << logbookFile << "\", \"cycle_time\": {\"value\": 1, \"unit\": \"s\"}, \"max_entries\": 100, \"columns\": [";
+	for(size_t i=0; i<options.nSensors; ++i)
+	{
+		if(i > 0)
+			config << ",";
+
+		config << "\n  {\"title\": \"mean_" << i << "\", \"sensor_id\": \"mqtt_" << i << "\", \"operation\": \"mean\", \"mqtt_publish\": \"bench/stats/" << i << "\"}";
+	}
+	config << "]}]}\n";
+
+	return filename;
+}
+
+static std::string payload(size_t sensor, uint64_t i)
+{
+	std::string value = std::to_string(20.0 + static_cast<double>((i * 31 + sensor) % 100) * 0.1);
+	if((sensor % 2) == 1)
+		return "{\"Time\": \"2022-10-03T12:00:00\", \"SI7021\": {\"Temperature\": " + value + ", \"Humidity\": 48.2}}";
+
+	return value;
+}
+
+// message_arrived() for every message that paho delivers: topic lookup and payload parsing.
+static void benchDispatch(benchRunner &runner, mockBroker &mock)
+{
+	std::string configFile = writeConfig(runner.options(), 0, false);
+
+	logger root;
+	root.setVerbose(false);
+	root.loadConfig(configFile);
+
+	// A broker connection of its own, so that message_arrived() can be called directly:
+	mqttBroker broker(&root);
+	broker.setHost("127.0.0.1");
+	broker.setPort(mock.port());
+	broker.connectToMQTTBroker();
+	mock.waitForSubscriptions(runner.options().nSensors, 5000);
+
+	mqtt::callback &callback = broker;
+	size_t nSensors = std::max(runner.options().nSensors, static_cast<size_t>(2));
+
+	std::vector<mqtt::const_message_ptr> numbers, documents;
+	for(size_t i=0; i<nSensors; i+=2)
+	{
+		numbers.push_back(mqtt::make_message(sensorTopic(i), payload(i, i)));
+		documents.push_back(mqtt::make_message(sensorTopic(i+1), payload(i+1, i)));
+	}
+
+	runner.run("mqtt.dispatch", "message_arrived_number", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			callback.message_arrived(numbers.at(k % numbers.size()));
+	});
+
+	runner.run("mqtt.dispatch", "message_arrived_json", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			callback.message_arrived(documents.at(k % documents.size()));
+	});
+
+	mqtt::const_message_ptr unknown = mqtt::make_message("bench/unknown", "1");
+	runner.run("mqtt.dispatch", "message_arrived_unsubscribed", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			callback.message_arrived(unknown);
+	});
+
+	remove(configFile.c_str());
+}
+
+/* Macro benchmark: the mock broker publishes to all MQTT sensors at the
+   configured rate while Sensorlogger runs its usual trigger loop and
+   publishes its logbook results back to the broker. */
+static void benchEndToEnd(benchRunner &runner, mockBroker &mock)
+{
+	const benchOptions &options = runner.options();
+	std::string configFile = writeConfig(options, mock.port(), true);
+
+	logger root;
+	root.setVerbose(false);
+	root.loadConfig(configFile);
+	root.setUpConnections();
+
+	if(!mock.waitForSubscriptions(options.nSensors, 5000))
+		std::cerr << "mqtt: sensors did not subscribe to the mock broker." << std::endl;
+
+	uint64_t nSentBefore     = mock.nSent();
+	uint64_t nReceivedBefore = mock.nReceived();
+
+	std::atomic<bool> stop(false);
+	std::thread publisher([&]() {
+		const auto interval = std::chrono::duration<double>(1.0 / std::max(options.rate, 0.001));
+		auto next = std::chrono::steady_clock::now();
+		uint64_t i = 0;
+		while(!stop)
+		{
+			for(size_t s=0; s<options.nSensors; ++s)
+				mock.publish(sensorTopic(s), payload(s, i));
+
+			++i;
+			next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+			std::this_thread::sleep_until(next);
+		}
+	});
+
+	uint64_t nTriggers = 0;
+	double triggerSeconds = 0;
+	std::clock_t cpuStart = std::clock();
+	const auto wallStart = std::chrono::steady_clock::now();
+	const auto end = wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.mqttDuration));
+
+	while(std::chrono::steady_clock::now() < end)
+	{
+		const auto triggerStart = std::chrono::steady_clock::now();
+		root.trigger();
+		triggerSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - triggerStart).count();
+		++nTriggers;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	stop = true;
+	publisher.join();
+
+	double seconds    = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+	double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	uint64_t nSent     = mock.nSent() - nSentBefore;
+	uint64_t nReceived = mock.nReceived() - nReceivedBefore;
+
+	benchResult &r = runner.record("mqtt.end_to_end", "synthetic_sensors", nSent, seconds);
+	r.metrics.push_back(std::make_pair("sensors", static_cast<double>(options.nSensors)));
+	r.metrics.push_back(std::make_pair("rate_hz", options.rate));
+	r.metrics.push_back(std::make_pair("messages_to_sensorlogger", static_cast<double>(nSent)));
+	r.metrics.push_back(std::make_pair("messages_from_sensorlogger", static_cast<double>(nReceived)));
+	r.metrics.push_back(std::make_pair("cpu_seconds", cpuSeconds));
+	r.metrics.push_back(std::make_pair("cpu_us_per_message", (nSent > 0) ? (cpuSeconds * 1e6 / static_cast<double>(nSent)) : 0));
+	r.metrics.push_back(std::make_pair("trigger_us_mean", (nTriggers > 0) ? (triggerSeconds * 1e6 / static_cast<double>(nTriggers)) : 0));
+
+	remove(configFile.c_str());
+}
+
+void benchMQTT(benchRunner &runner)
+{
+	mockBroker mock;
+	if(!mock.start())
+	{
+		std::cerr << "mqtt: cannot start the mock broker." << std::endl;
+		return;
+	}
+
+	benchDispatch(runner, mock);
+	benchEndToEnd(runner, mock);
+}
+
+#else
+
+void benchMQTT(benchRunner &runner)
+{
+	// Compiled without MQTT support.
+}
+
+#endif
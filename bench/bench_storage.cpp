@@ -0,0 +1,160 @@
+#include "bench.h"
+
+#include "measurements.h"
+#include "counter.h"
+
+#include <cmath>
+
+// Synthetic signal: slow oscillation with some noise.
+static double signal(uint64_t i)
+{
+	return 20.0 + 5.0 * sin(static_cast<double>(i) / 500.0) + 0.01 * static_cast<double>((i * 7919) % 101);
+}
+
+static void fillWindow(measurements &m, uint64_t n, uint64_t startTimestamp, uint64_t step)
+{
+	// As planned by sensor::requiredCapacity():
+	m.setCapacity(n + 2 + (m.getCompression() ? SAMPLEBLOCK_SIZE : 0));
+	for(uint64_t i=0; i<n; ++i)
+		m.addValue(signal(i), startTimestamp + i * step);
+}
+
+static void benchMeasurements(benchRunner &runner, bool compress)
+{
+	const std::string suite = compress ? "storage.measurements_compressed" : "storage.measurements";
+	const uint64_t window = 3600;  // one hour at 1 s
+	const uint64_t step   = 1000;
+
+	{
+		// Sliding window as in operation: add the newest value, drop the oldest.
+		measurements m;
+		m.setCompression(compress);
+		m.setMinimumRestPeriod(step);
+		fillWindow(m, window, step, step);
+
+		uint64_t i = window;
+		runner.run(suite, "addValue_clean", [&](uint64_t n) {
+			for(uint64_t k=0; k<n; ++k, ++i)
+			{
+				uint64_t timestamp = (i + 1) * step;
+				m.clean(timestamp - window * step);
+				m.addValue(signal(i), timestamp);
+			}
+		});
+	}
+
+	{
+		measurements m;
+		m.setCompression(compress);
+		m.setMinimumRestPeriod(step);
+		fillWindow(m, window, step, step);
+
+		benchResult &r = runner.run(suite, "valuesInConfidence_3600", [&](uint64_t n) {
+			for(uint64_t k=0; k<n; ++k)
+			{
+				std::vector<double>* values = m.valuesInConfidence(0, 0, 0);
+				benchSink = values->back();
+				delete values;
+			}
+		});
+		r.metrics.push_back(std::make_pair("bytes", static_cast<double>(m.memoryUsage())));
+
+		runner.run(suite, "valuesInConfidence_3600_sigma", [&](uint64_t n) {
+			for(uint64_t k=0; k<n; ++k)
+			{
+				std::vector<double>* values = m.valuesInConfidence(0, 0, 2.0);
+				benchSink = values->back();
+				delete values;
+			}
+		});
+	}
+}
+
+static void benchKernels(benchRunner &runner)
+{
+	std::vector<double> values;
+	for(uint64_t i=0; i<3600; ++i)
+		values.push_back(signal(i));
+
+	runner.run("storage.kernels", "sum_3600",          [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::sum(&values); });
+	runner.run("storage.kernels", "mean_3600",         [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::mean(&values); });
+	runner.run("storage.kernels", "median_3600",       [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::median(&values); });
+	runner.run("storage.kernels", "maximum_3600",      [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::maximum(&values); });
+	runner.run("storage.kernels", "minimum_3600",      [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::minimum(&values); });
+	runner.run("storage.kernels", "stdDevMean_3600",   [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::stdDevMean(&values); });
+	runner.run("storage.kernels", "stdDevMedian_3600", [&](uint64_t n) { for(uint64_t k=0; k<n; ++k) benchSink = measurementFunctions::stdDevMedian(&values); });
+
+	// Rollups of one day in minutes:
+	measurements m;
+	m.setMinimumRestPeriod(1000);
+	m.accumulateRollupTimeToKeep(rollup_minute, 86400000);
+	fillWindow(m, 86400, 1000, 1000);
+
+	runner.run("storage.kernels", "rollupStatistics_1440", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			benchSink = measurementFunctions::mean(m.rollupStatistics(rollup_minute, 1000));
+	});
+}
+
+static void benchCounter(benchRunner &runner)
+{
+	const uint64_t cycleTime = 900000;  // 15 minutes, one day of cycles
+	const size_t   nCycles   = 96;
+
+	counter c(0);
+	c.setCycleTime(cycleTime);
+	c.accumulateCyclesToStore(nCycles);
+	c.enableHistograms();
+
+	uint64_t timestamp = 0;
+	for(size_t cycle=0; cycle<nCycles; ++cycle)
+	{
+		for(uint64_t i=0; i<100; ++i)
+			c.count((timestamp + i * 7000 + (i % 13) * 100) * 1000);  // µs
+
+		timestamp += cycleTime;
+		c.startNewCycle(timestamp);
+	}
+
+	uint64_t t = timestamp;
+	runner.run("storage.counter", "count", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			c.count((t + k) * 1000);
+	});
+
+	runner.run("storage.counter", "counts_96", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			benchSink = static_cast<double>(c.counts(nCycles));
+	});
+
+	runner.run("storage.counter", "frequency_96", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			benchSink = c.frequency(nCycles, t);
+	});
+
+	runner.run("storage.counter", "frequency_max_96", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			benchSink = c.frequency_max(nCycles);
+	});
+
+	runner.run("storage.counter", "frequency_percentile_96", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+			benchSink = c.frequency_percentile(nCycles, 95);
+	});
+
+	runner.run("storage.counter", "startNewCycle", [&](uint64_t n) {
+		for(uint64_t k=0; k<n; ++k)
+		{
+			t += cycleTime;
+			c.startNewCycle(t);
+		}
+	});
+}
+
+void benchStorage(benchRunner &runner)
+{
+	benchMeasurements(runner, false);
+	benchMeasurements(runner, true);
+	benchKernels(runner);
+	benchCounter(runner);
+}
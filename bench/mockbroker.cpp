@@ -0,0 +1,412 @@
+#include "mockbroker.h"
+
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// MQTT control packet types:
+#define MQTT_CONNECT     1
+#define MQTT_CONNACK     2
+#define MQTT_PUBLISH     3
+#define MQTT_PUBACK      4
+#define MQTT_PUBREC      5
+#define MQTT_PUBREL      6
+#define MQTT_PUBCOMP     7
+#define MQTT_SUBSCRIBE   8
+#define MQTT_SUBACK      9
+#define MQTT_UNSUBSCRIBE 10
+#define MQTT_UNSUBACK    11
+#define MQTT_PINGREQ     12
+#define MQTT_PINGRESP    13
+#define MQTT_DISCONNECT  14
+
+static void appendUInt16(std::string &s, uint16_t value)
+{
+	s += static_cast<char>(value >> 8);
+	s += static_cast<char>(value & 0xFF);
+}
+
+static uint16_t readUInt16(const std::string &s, size_t pos)
+{
+	return static_cast<uint16_t>((static_cast<uint8_t>(s[pos]) << 8) | static_cast<uint8_t>(s[pos+1]));
+}
+
+static bool readAll(int socket, char* buffer, size_t n)
+{
+	while(n > 0)
+	{
+		ssize_t r = recv(socket, buffer, n, 0);
+		if(r <= 0)
+			return false;
+
+		buffer += r;
+		n -= static_cast<size_t>(r);
+	}
+
+	return true;
+}
+
+mockBroker::mockBroker()
+{
+	_listenSocket = -1;
+	_port = 0;
+	_acceptThread = NULL;
+	_stop = false;
+	_nReceived = 0;
+	_nSent = 0;
+}
+
+mockBroker::~mockBroker()
+{
+	stop();
+}
+
+bool mockBroker::start()
+{
+	_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if(_listenSocket < 0)
+		return false;
+
+	int reuse = 1;
+	setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port        = 0;  // any free port
+
+	socklen_t length = sizeof(address);
+	if((bind(_listenSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+		|| (listen(_listenSocket, 8) != 0)
+		|| (getsockname(_listenSocket, reinterpret_cast<struct sockaddr*>(&address), &length) != 0))
+	{
+		close(_listenSocket);
+		_listenSocket = -1;
+		return false;
+	}
+
+	_port = ntohs(address.sin_port);
+	_stop = false;
+	_acceptThread = new std::thread(&mockBroker::acceptClients, this);
+
+	return true;
+}
+
+void mockBroker::stop()
+{
+	if(_acceptThread == NULL)
+		return;
+
+	_stop = true;
+	shutdown(_listenSocket, SHUT_RDWR);
+	close(_listenSocket);
+	_acceptThread->join();
+	delete _acceptThread;
+	_acceptThread = NULL;
+
+	std::vector<client*> clients;
+	{
+		std::lock_guard<std::mutex> lock(_clientsMutex);
+		clients.swap(_clients);
+	}
+
+	for(size_t i=0; i<clients.size(); ++i)
+	{
+		shutdown(clients[i]->socket, SHUT_RDWR);
+		clients[i]->thread->join();
+		close(clients[i]->socket);
+		delete clients[i]->thread;
+		delete clients[i];
+	}
+}
+
+unsigned short mockBroker::port() const
+{
+	return _port;
+}
+
+void mockBroker::acceptClients()
+{
+	while(!_stop)
+	{
+		int s = accept(_listenSocket, NULL, NULL);
+		if(s < 0)
+			break;
+
+		int noDelay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+		client* c = new client;
+		c->socket = s;
+
+		std::lock_guard<std::mutex> lock(_clientsMutex);
+		_clients.push_back(c);
+		c->thread = new std::thread(&mockBroker::serve, this, c);
+	}
+}
+
+bool mockBroker::readPacket(int socket, uint8_t &header, std::string &body)
+{
+	char byte;
+	if(!readAll(socket, &byte, 1))
+		return false;
+
+	header = static_cast<uint8_t>(byte);
+
+	// Remaining length, variable length encoding:
+	size_t length = 0;
+	size_t multiplier = 1;
+	do
+	{
+		if(!readAll(socket, &byte, 1) || (multiplier > 128*128*128))
+			return false;
+
+		length += (static_cast<uint8_t>(byte) & 127) * multiplier;
+		multiplier *= 128;
+	} while((static_cast<uint8_t>(byte) & 128) != 0);
+
+	body.resize(length);
+	return (length == 0) || readAll(socket, &body[0], length);
+}
+
+bool mockBroker::sendPacket(client* c, uint8_t header, const std::string &body)
+{
+	std::string packet;
+	packet += static_cast<char>(header);
+
+	size_t length = body.size();
+	do
+	{
+		uint8_t byte = length % 128;
+		length /= 128;
+		if(length > 0)
+			byte |= 128;
+
+		packet += static_cast<char>(byte);
+	} while(length > 0);
+
+	packet += body;
+
+	std::lock_guard<std::mutex> lock(c->writeMutex);
+	const char* data = packet.data();
+	size_t n = packet.size();
+	while(n > 0)
+	{
+		ssize_t w = send(c->socket, data, n, MSG_NOSIGNAL);
+		if(w <= 0)
+			return false;
+
+		data += w;
+		n -= static_cast<size_t>(w);
+	}
+
+	return true;
+}
+
+void mockBroker::serve(client* c)
+{
+	uint8_t header;
+	std::string body;
+
+	while(readPacket(c->socket, header, body))
+	{
+		uint8_t type = header >> 4;
+		std::string answer;
+
+		switch(type)
+		{
+		case MQTT_CONNECT:
+			answer += '\0';  // no session present
+			answer += '\0';  // accepted
+			sendPacket(c, MQTT_CONNACK << 4, answer);
+			break;
+
+		case MQTT_PUBLISH:
+			{
+				++_nReceived;
+				int qos = (header >> 1) & 3;
+				if((qos > 0) && (body.size() >= 2))
+				{
+					uint16_t topicLength = readUInt16(body, 0);
+					if(body.size() >= (static_cast<size_t>(topicLength) + 4))
+					{
+						appendUInt16(answer, readUInt16(body, 2 + topicLength));
+						sendPacket(c, ((qos == 1) ? MQTT_PUBACK : MQTT_PUBREC) << 4, answer);
+					}
+				}
+			}
+			break;
+
+		case MQTT_PUBREL:
+			if(body.size() >= 2)
+				sendPacket(c, MQTT_PUBCOMP << 4, body.substr(0, 2));
+			break;
+
+		case MQTT_PUBREC:
+			// For our own QoS 2 messages:
+			if(body.size() >= 2)
+				sendPacket(c, (MQTT_PUBREL << 4) | 2, body.substr(0, 2));
+			break;
+
+		case MQTT_SUBSCRIBE:
+		case MQTT_UNSUBSCRIBE:
+			if(body.size() >= 2)
+			{
+				appendUInt16(answer, readUInt16(body, 0));
+
+				size_t pos = 2;
+				while((pos + 2) <= body.size())
+				{
+					uint16_t filterLength = readUInt16(body, pos);
+					pos += 2;
+					if((pos + filterLength) > body.size())
+						break;
+
+					std::string filter = body.substr(pos, filterLength);
+					pos += filterLength;
+
+					std::lock_guard<std::mutex> lock(_clientsMutex);
+					if(type == MQTT_SUBSCRIBE)
+					{
+						pos += 1;  // requested QoS
+						answer += '\0';  // granted: QoS 0
+						c->filters.push_back(filter);
+					}
+					else
+					{
+						for(size_t i=0; i<c->filters.size(); ++i)
+						{
+							if(c->filters[i] == filter)
+							{
+								c->filters.erase(c->filters.begin() + i);
+								break;
+							}
+						}
+					}
+				}
+
+				if(type == MQTT_SUBSCRIBE)
+					sendPacket(c, MQTT_SUBACK << 4, answer);
+				else
+					sendPacket(c, MQTT_UNSUBACK << 4, answer.substr(0, 2));
+			}
+			break;
+
+		case MQTT_PINGREQ:
+			sendPacket(c, MQTT_PINGRESP << 4, answer);
+			break;
+
+		case MQTT_DISCONNECT:
+			shutdown(c->socket, SHUT_RDWR);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+	c->filters.clear();
+}
+
+bool mockBroker::topicMatches(const std::string &filter, const std::string &topic)
+{
+	size_t f = 0, t = 0;
+	while(f < filter.size())
+	{
+		if(filter[f] == '#')
+			return true;
+
+		if(filter[f] == '+')
+		{
+			// Skip one topic level:
+			while((t < topic.size()) && (topic[t] != '/'))
+				++t;
+			++f;
+			continue;
+		}
+
+		if((t >= topic.size()) || (filter[f] != topic[t]))
+			return false;
+
+		++f;
+		++t;
+	}
+
+	return (t == topic.size());
+}
+
+size_t mockBroker::publish(const std::string &topic, const std::string &payload)
+{
+	// QoS 0: topic and payload only.
+	std::string body;
+	appendUInt16(body, static_cast<uint16_t>(topic.size()));
+	body += topic;
+	body += payload;
+
+	std::vector<client*> receivers;
+	{
+		std::lock_guard<std::mutex> lock(_clientsMutex);
+		for(size_t i=0; i<_clients.size(); ++i)
+		{
+			for(size_t k=0; k<_clients[i]->filters.size(); ++k)
+			{
+				if(topicMatches(_clients[i]->filters[k], topic))
+				{
+					receivers.push_back(_clients[i]);
+					break;
+				}
+			}
+		}
+	}
+
+	size_t n = 0;
+	for(size_t i=0; i<receivers.size(); ++i)
+	{
+		if(sendPacket(receivers[i], MQTT_PUBLISH << 4, body))
+			++n;
+	}
+
+	_nSent += n;
+	return n;
+}
+
+size_t mockBroker::nSubscriptions() const
+{
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+
+	size_t n = 0;
+	for(size_t i=0; i<_clients.size(); ++i)
+		n += _clients[i]->filters.size();
+
+	return n;
+}
+
+bool mockBroker::waitForSubscriptions(size_t n, unsigned timeout_ms) const
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while(nSubscriptions() < n)
+	{
+		if(std::chrono::steady_clock::now() > deadline)
+			return false;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return true;
+}
+
+uint64_t mockBroker::nReceived() const
+{
+	return _nReceived;
+}
+
+uint64_t mockBroker::nSent() const
+{
+	return _nSent;
+}
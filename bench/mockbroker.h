@@ -0,0 +1,65 @@
+#ifndef _MOCKBROKER_H
+#define _MOCKBROKER_H
+
+// Minimal MQTT 3.1.1 broker on localhost for benchmarks. It accepts
+// clients, answers CONNECT, SUBSCRIBE, PINGREQ and QoS 1/2 handshakes,
+// counts the messages that clients publish, and can publish messages
+// to its subscribers. Topic filters are matched exactly or with
+// the wildcards '+' and '#'. Retained messages and sessions are not
+// supported.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+class mockBroker
+{
+private:
+	struct client
+	{
+		int socket;
+		std::mutex writeMutex;
+		std::vector<std::string> filters;
+		std::thread* thread;
+	};
+
+	int _listenSocket;
+	unsigned short _port;
+	std::thread* _acceptThread;
+	std::atomic<bool> _stop;
+
+	std::vector<client*> _clients;
+	mutable std::mutex _clientsMutex;
+
+	std::atomic<uint64_t> _nReceived;  // PUBLISH packets from clients
+	std::atomic<uint64_t> _nSent;      // PUBLISH packets to clients
+
+	void acceptClients();
+	void serve(client* c);
+	bool readPacket(int socket, uint8_t &header, std::string &body);
+	bool sendPacket(client* c, uint8_t header, const std::string &body);
+
+public:
+	mockBroker();
+	~mockBroker();
+
+	bool start();  // on a free port
+	void stop();
+	unsigned short port() const;
+
+	static bool topicMatches(const std::string &filter, const std::string &topic);
+
+	// Returns the number of subscribers that received the message.
+	size_t publish(const std::string &topic, const std::string &payload);
+
+	size_t nSubscriptions() const;
+	bool waitForSubscriptions(size_t n, unsigned timeout_ms) const;
+
+	uint64_t nReceived() const;
+	uint64_t nSent() const;
+};
+
+#endif
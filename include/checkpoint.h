@@ -0,0 +1,73 @@
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+// Periodic checkpoints of the sensors' measurement windows, rollups and
+// pulse counters, so that a restart does not begin with empty windows.
+// The checkpoint file is a journal: each checkpoint only appends what has
+// changed since the previous one. When the journal has grown much larger
+// than the data it describes, it is replaced by a compact snapshot.
+// Records are collected on the trigger thread; writing and syncing
+// the file happens on a background thread.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class sensor;
+
+class checkpoint
+{
+private:
+	std::string _filename;
+	uint64_t    _interval;  // ms, 0: checkpoints disabled
+	uint64_t    _timestamp_lastCheckpoint;
+
+	// What has already been written, per sensor (and counter):
+	std::vector<uint64_t> _lastSampleTimestamp;
+	std::vector<std::vector<unsigned> > _counterResets;
+
+	bool     _snapshotRequired;
+	uint64_t _journalSize;   // bytes in the file
+	uint64_t _snapshotSize;  // bytes of the last snapshot
+
+	// Handed over to the writer thread:
+	std::string _pending;    // records to append
+	std::string _snapshot;   // replaces the file if not empty
+	uint64_t    _nWriteFailures;
+
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::thread* _thread;
+	bool _stop;
+
+	void run();
+	bool writeSnapshot(const std::string &data);
+	bool appendRecords(const std::string &data);
+
+	void collect(const std::vector<sensor*> &sensors, uint64_t currentTimestamp, bool everything, std::string &records);
+	uint64_t write(const std::vector<sensor*> &sensors, uint64_t currentTimestamp);
+
+public:
+	checkpoint();
+	~checkpoint();
+
+	void setFile(const std::string &filename);
+	void setInterval(uint64_t interval);
+	bool enabled() const;
+
+	// Returns the number of restored measurements.
+	size_t restore(const std::vector<sensor*> &sensors, uint64_t currentTimestamp);
+
+	void start();
+	void stop();   // writes everything that is still pending
+
+	// Called from the trigger loop; returns the number of failed writes since the last call.
+	uint64_t update(const std::vector<sensor*> &sensors, uint64_t currentTimestamp);
+	void flush(const std::vector<sensor*> &sensors, uint64_t currentTimestamp);
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+// Time source for the logger and everything that asks it for the
+// current time (sensors, logbooks, counters). The system clock is used
+// for normal operation; a virtual clock is set explicitly, e.g. to the
+// timestamps of recorded samples during a replay.
+// Intervals between events (pulses of a counter) are measured on a
+// monotonic microsecond scale, which does not jump with the system time.
+
+#include <cstdint>
+#include <atomic>
+
+class loggerClock
+{
+public:
+	virtual ~loggerClock();
+
+	virtual uint64_t now() const = 0;  // ms since the epoch
+	virtual uint64_t monotonic() const = 0;  // µs, arbitrary origin
+};
+
+class systemClock : public loggerClock
+{
+public:
+	uint64_t now() const;
+	uint64_t monotonic() const;
+};
+
+class virtualClock : public loggerClock
+{
+private:
+	std::atomic<uint64_t> _now;
+
+public:
+	virtualClock();
+
+	uint64_t now() const;
+	uint64_t monotonic() const;  // the virtual time in µs
+
+	void set(uint64_t timestamp);
+	void advance(uint64_t ms);
+};
+
+#endif
@@ -7,7 +7,10 @@
 #include <sstream>
 #include <vector>
 
-enum operation {mean, median, max, min, sum, count, freq, freq_min, freq_max, stdDevMean, stdDevMedian};
+#include "numberformat.h"
+#include "measurements.h"
+
+enum operation {mean, median, max, min, sum, count, freq, freq_min, freq_max, freq_percentile, gust_factor, stdDevMean, stdDevMedian};
 
 class logbook;
 class sensor;
@@ -27,11 +30,17 @@ private:
 	std::string   _mqttPublishTopic;
 	std::string   _homematicPublishISE;
 	double        _countFactor;
+	double        _percentile;     // for freq_percentile and gust_factor
+	numberFormat  _format;
 
 	logbook*      _rootLogbook;
 
 	// Calculated from evaluation period / logbook cycle time:
 	size_t        _nCycles;  // How many logbook cycles does the evaluation period represent?
+	rollupTier    _tier;     // Pre-aggregated values that can be used instead of the raw measurements
+
+	bool canUseRollups() const;
+	void registerStorage();
 
 public:
 	column(sensor* s, logbook* lb, const std::string &title, const std::string &unit, uint64_t evaluationPeriod, operation op, double confidenceAbsolute, double confidenceSigma, const std::string &mqttPublishTopic, const std::string &homematicPublishISE, double countFactor);
@@ -45,6 +54,10 @@ public:
 	std::string getMQTTPublishTopic() const;
 	std::string getHomematicPublishISE() const;
 	double getCountFactor() const;
+	double getPercentile() const;
+	bool isCounterOperation() const;
+	rollupTier getRollupTier() const;
+	const numberFormat& getNumberFormat() const;
 
 	counter* getCounter();
 	sensor*  getSensor();
@@ -59,6 +72,8 @@ public:
 	void setMQTTPublishTopic(const std::string &mqttPublishTopic);
 	void setHomematicPublishISE(const std::string &homematicPublishISE);
 	void setCountFactor(double countFactor);
+	void setPercentile(double percentile);
+	void setNumberFormat(const numberFormat &format);
 
 	std::string getValue(uint64_t startTimestamp, uint64_t currentTimestamp) const;
 	void startNewCycle(const uint64_t currentTimestamp);
@@ -3,51 +3,96 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <string>
 #include <vector>
+#include <atomic>
+
+#include "histogram.h"
+
+/* Counter for one logbook cycle.
+   count() may be called from a callback thread while the
+   main thread evaluates the counter: all members are atomic.
+   Cycles start and finish at logger timestamps (ms since the epoch),
+   pulses are counted at their monotonic event time (µs), so that
+   the distances between pulses are exact. */
+#define CYCLECOUNTER_FIELDS 6
 
-/* Counter for one logbook cycle */
 class cycleCounter
 {
 private:
-	uint64_t _counts;
-	uint64_t _timestamp_countsSince;
-	uint64_t _timestamp_finished;
-	uint64_t _minTimeDistance;
-	uint64_t _maxTimeDistance;
-	uint64_t _timestamp_lastCount;
+	std::atomic<uint64_t> _counts;
+	std::atomic<uint64_t> _timestamp_countsSince;
+	std::atomic<uint64_t> _timestamp_finished;
+	std::atomic<uint64_t> _minTimeDistance;      // µs
+	std::atomic<uint64_t> _maxTimeDistance;      // µs
+	std::atomic<uint64_t> _timestamp_lastCount;  // monotonic µs
 
 public:
+	cycleCounter();
 	cycleCounter(const uint64_t currentTimestamp);
+	cycleCounter(const cycleCounter &other);
 	~cycleCounter();
 
+	cycleCounter& operator=(const cycleCounter &other);
+
 	uint64_t getStartTimestamp() const;
 
-	void count(const uint64_t currentTimestamp);
+	// For checkpoints: raw values of all members. The time of the last
+	// pulse is not loaded: the monotonic clock restarts with the system.
+	void save(uint64_t* fields) const;
+	void load(const uint64_t* fields);
+
+	void count(const uint64_t eventTime);
 	void finish(const uint64_t currentTimestamp);
 	void reset(const uint64_t currentTimestamp);
 
 	uint64_t counts() const;
 	double frequency() const;
+	double frequency(const uint64_t endTimestamp) const;
 	double frequency_min() const;
 	double frequency_max() const;
 
 };
 
-/* Counter manager class; enables floating counters. */
+/* Counter manager class; enables floating counters.
+   The cycles are kept in a ring, the newest one is the current cycle.
+   count() is lock-free and may run on another thread than the
+   evaluation and startNewCycle(); the ring itself is only resized
+   during configuration. The ring has one spare slot, so that the next
+   cycle is always prepared in a slot that count() is not writing to. */
 class counter
 {
 private:
 	size_t _nCyclesToStore;
+	uint64_t _cycleTime;  // ms, of the logbook that owns this counter
+
+	std::vector<cycleCounter> _ring;
+	std::vector<uint64_t>     _countsBefore;  // for each cycle: total counts when it was started
+	std::atomic<size_t>   _current;      // ring position of the current cycle
+	size_t                _nStored;      // cycles in the ring, including the current one, up to _nCyclesToStore
+	std::atomic<uint64_t> _totalCounts;  // all counts since the last reset
+	std::atomic<unsigned> _nResets;
 
-	std::vector<cycleCounter*> _counters;
-	cycleCounter* _currentCounter;
+	// Optional distribution of pulse intervals, one histogram per ring slot.
+	// Only the spare slot's histogram is cleared for a new cycle:
+	std::vector<intervalHistogram*> _histograms;
+	std::atomic<uint64_t> _timestamp_lastCount;  // across cycles, monotonic µs
 
+	size_t ringSize() const;
+	size_t position(size_t age) const;  // age 0: current cycle
+	size_t cyclesToEvaluate(size_t nCycles) const;
+	void resizeRing();
+	void mergeHistograms(size_t nCycles, std::vector<uint64_t> &merged) const;
+	void deleteHistograms();
 public:
 	counter(const uint64_t currentTimestamp);
 	~counter();
 
 	void accumulateCyclesToStore(size_t cyclesToStore);
-	void count(const uint64_t currentTimestamp);
+	void setCycleTime(uint64_t cycleTime);
+	void enableHistograms();
+	bool histogramsEnabled() const;
+	void count(const uint64_t eventTime);  // monotonic µs
 	void startNewCycle(const uint64_t currentTimestamp);
 	void reset(const uint64_t currentTimestamp);
 
@@ -55,6 +100,18 @@ public:
 	double frequency(size_t nCycles, const uint64_t currentTimestamp) const;
 	double frequency_min(size_t nCycles) const;
 	double frequency_max(size_t nCycles) const;
+	double frequency_percentile(size_t nCycles, double percentile) const;
+	double gust_factor(size_t nCycles, double percentile, const uint64_t currentTimestamp) const;
+
+	// Checkpoints: the stored cycles, from oldest to current. Interval
+	// histograms are not included. Only cycles that finished at or after
+	// finishedSince are serialized, and always the current one.
+	// restore() replaces the ring's contents, skipping cycles that are
+	// too old to be evaluated any more. After a reset, earlier cycles
+	// are gone: nResets() tells when a checkpoint needs all cycles again.
+	void serialize(std::string &data, const uint64_t currentTimestamp, const uint64_t finishedSince = 0) const;
+	bool restore(const std::string &data, const uint64_t currentTimestamp);
+	unsigned nResets() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef _HISTOGRAM_H
+#define _HISTOGRAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+/* Log-bucketed histogram of time intervals (in µs).
+   Intervals below 16 µs get their own bucket; above, each power
+   of two is divided into 16 sub-buckets (about 6% resolution).
+   Intervals beyond 2^42 µs (about 50 days) fall into the last bucket.
+   add() is lock-free and never allocates. */
+
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_MAX_EXPONENT 41
+#define HISTOGRAM_N_BUCKETS (HISTOGRAM_SUB_BUCKETS + (HISTOGRAM_MAX_EXPONENT - 3) * HISTOGRAM_SUB_BUCKETS)
+
+class intervalHistogram
+{
+private:
+	std::atomic<uint32_t> _buckets[HISTOGRAM_N_BUCKETS];
+
+public:
+	intervalHistogram();
+
+	static size_t bucketIndex(uint64_t interval);
+	static double bucketValue(size_t index);  // center of the bucket
+
+	void add(uint64_t interval);
+	void clear();
+
+	// Adds the bucket contents to a merged histogram of HISTOGRAM_N_BUCKETS entries.
+	void addTo(std::vector<uint64_t> &merged) const;
+	void copyFrom(const intervalHistogram &other);
+
+	// Interval below which the fraction q of all entries lies; 0 if empty.
+	static double quantile(const std::vector<uint64_t> &merged, double q);
+};
+
+#endif
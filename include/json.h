@@ -2,6 +2,7 @@
 #define _JSON_H
 
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <sstream>
 #include <fstream>
@@ -34,6 +35,10 @@ bool isIn(const char& c, const char* chain);
 bool isIntInString(const std::string &s);
 bool isFloatInString(const std::string &s);
 
+// Locale-independent number parsing without temporary copies:
+bool parseLong(std::string_view s, long &value);
+bool parseDouble(std::string_view s, double &value);
+
 class jsonValue
 {
 private:
@@ -110,7 +115,7 @@ public:
 	void setFilename(const std::string &filename);
 	void readFile();
 	void parseFile(const std::string &filename);
-	void setContent(const std::string &content);
+	void setContent(std::string_view content);
 
 	void parse();
 
@@ -30,6 +30,7 @@ private:
 	std::vector<column*> _cols;
 	logger*              _root;
 	std::string          _missingDataToken;
+	std::string          _line;  // reused for each new log line
 
 	uint64_t _timestamp_next_logentry;
 	uint64_t _timestamp_last_logentry_written;
@@ -51,8 +52,10 @@ public:
 	void addColumn(column* col);
 
 	void setTimestampForNextLogEntry();
+	uint64_t getTimestampForNextLogEntry() const;
 
 	// Writes to file and possibly publishes column values to MQTT broker.
+	// brokers and hm may be NULL (replay) to skip publishing.
 	void write(mqttManager* brokers, homematic* hm);
 };
 
@@ -5,6 +5,7 @@
 #define E_SENSOR_DOES_NOT_EXIST 6002
 #define E_JSON_READ             6003
 #define E_HTTP_REQUEST_FAILED   6004
+#define E_HTTP_TIMEOUT          6005
 
 #include <cstdio>
 #include <iostream>
@@ -14,6 +15,8 @@
 #include <vector>
 #include <thread>
 
+#include "clock.h"
+
 #ifdef OPTION_CURL
 	#include <curl/curl.h>
 #endif
@@ -27,17 +30,29 @@ enum loglevel {
 
 class readoutBuffer;
 class tinkerforge;
+class workerPool;
+class jsonNode;
 class mqttBroker;
 class mqttManager;
 class homematic;
 class sensor;
 class logbook;
+class logWriter;
+class checkpoint;
+class sampleJournal;
+class metricsRegistry;
+class metricCounter;
+class metricGauge;
+class metricHistogram;
+
+// Parts of a trigger cycle, timed for the metrics:
+enum trigger_stage {stage_tinkerforge, stage_measure, stage_logbooks, stage_mqtt, stage_checkpoint, N_TRIGGER_STAGES};
 
 class logger
 {
 private:
 	std::string _logFilename;
-	std::string _lastLogfileMessage;
+	logWriter*  _logWriter;
 	int _logLevel;
 
 	uint64_t _default_rest_period;
@@ -46,17 +61,16 @@ private:
 	readoutBuffer* _rBuffer;
 	bool _verbose;
 
-	unsigned _brickd_restart_attempt_counter;
-	unsigned _max_tinkerforge_read_failures;
-	unsigned _max_brickd_restart_attempts;
-	std::string _cmd_readFailures;
-	std::string _cmd_readFailures_critical;
-
 	std::vector<sensor*> _sensors;
 	std::vector<logbook*> _logbooks;
 
 	#ifdef OPTION_TINKERFORGE
-		tinkerforge* _tfDaemon;
+		std::vector<tinkerforge*> _tfDaemons;
+		workerPool* _tfDaemonPool;  // polls the daemons in parallel
+
+		void addTinkerforgeDaemon(jsonNode* daemonNode);
+		tinkerforge* tinkerforgeDaemon(const std::string &name);
+		void checkBrickDaemon(tinkerforge* daemon, uint64_t current);
 	#endif
 
 	mqttManager* _mqttManager;
@@ -67,6 +81,56 @@ private:
 	#endif
 
 	long _http_timeout;
+	uint64_t _memoryLimit;  // bytes for raw measurements of all sensors, 0: no limit
+	checkpoint* _checkpoint;
+	sampleJournal* _journal;
+
+	// Read statistics of the sensors, to the debug log and optionally to MQTT:
+	uint64_t    _telemetryInterval;  // ms, 0: no reports
+	std::string _telemetryTopic;     // one subtopic per sensor
+	uint64_t    _timestamp_lastTelemetry;
+	void reportTelemetry(uint64_t currentTimestamp);
+
+	// Runtime metrics, NULL if neither an endpoint nor a topic is configured:
+	metricsRegistry* _metrics;
+	std::string      _metricsAddress;
+	unsigned short   _metricsPort;      // 0: no Prometheus endpoint
+	std::string      _metricsTopic;
+	uint64_t         _metricsInterval;  // ms between MQTT messages
+	uint64_t         _timestamp_lastMetrics;
+
+	metricHistogram* _metricTrigger;
+	metricHistogram* _metricStage[N_TRIGGER_STAGES];
+	std::vector<metricGauge*> _metricSensorMeasurements;
+	std::vector<metricGauge*> _metricSensorMemory;
+	std::vector<metricGauge*> _metricSensorReadFailures;
+	std::vector<metricCounter*> _metricSensorTruncated;
+	metricGauge*     _metricJournalBuffered;
+	metricCounter*   _metricJournalLost;
+	std::vector<metricGauge*>   _metricMQTTQueued;
+	std::vector<metricGauge*>   _metricMQTTSpooled;
+	std::vector<metricGauge*>   _metricMQTTInFlight;
+	std::vector<metricCounter*> _metricMQTTPublished;
+	std::vector<metricCounter*> _metricMQTTCoalesced;
+	std::vector<metricCounter*> _metricMQTTDropped;
+
+	#ifdef OPTION_TRACE
+		std::string _traceFile;
+		void dumpTrace();
+	#endif
+
+	void setUpMetrics();
+	void stageFinished(trigger_stage stage, uint64_t &stageStart);
+	void updateMetrics(uint64_t currentTimestamp, uint64_t triggerStart);
+
+	systemClock  _systemClock;
+	virtualClock _replayClock;
+	loggerClock* _clock;       // source of currentTimestamp()
+	bool         _replayMode;
+
+	void planMeasurementMemory();
+	size_t writeReplayLogbooks();
+	size_t replayLogbooksUntil(uint64_t timestamp);
 
 public:
 	logger();
@@ -79,9 +143,18 @@ public:
 	void message(const std::string &m, bool isError);
 	std::string logLevelString();
 	void welcomeMessage(const std::string &configJSON);
+	void setVerbose(bool verbose);  // messages to stdout/stderr
 
 	void loadConfig(const std::string &configJSON);
 
+	// Regenerating logbooks from a sample journal or CSV file instead of
+	// measuring, as fast as possible under a virtual clock. Replay mode
+	// must be set before the configuration is loaded.
+	void setReplayMode();
+	uint64_t replay(const std::string &journalPath);
+
+	void setClock(loggerClock* clock);
+
 	std::string getLogFilename() const;
 	std::string logfileState() const;
 
@@ -92,6 +165,7 @@ public:
 	sensor* getSensor(size_t n);
 
 	uint64_t currentTimestamp() const;
+	uint64_t monotonicTimestamp() const;  // µs, for intervals between events
 
 	std::string httpRequest(const std::string url);
 
@@ -101,6 +175,8 @@ public:
 	void mqttPublish(const std::string &topic, const std::string &payload);
 	void homematicPublish(const std::string &iseID, const std::string &payload) const;
 
+	void recordSample(const sensor* s, uint64_t timestamp, double value);
+
 	void trigger();  // Check if measurement is necessary, and run it if so.
 };
 
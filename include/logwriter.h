@@ -0,0 +1,81 @@
+#ifndef _LOGWRITER_H
+#define _LOGWRITER_H
+
+// Writes the application log file on a background thread.
+// Messages are collected in a ring buffer and written through
+// a file handle that stays open; the file is flushed periodically
+// and rotated when it exceeds its maximum size. A message is written
+// at most once per LOG_REPEAT_INTERVAL; its repetitions in between are
+// summarized ("repeated n times"), even if other messages alternate
+// with it.
+
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class logWriter
+{
+private:
+	struct logLine
+	{
+		std::time_t time;
+		std::string text;
+	};
+
+	std::string _filename;
+	FILE*       _file;
+	uint64_t    _maxFileSize;     // bytes, 0: no rotation
+	unsigned    _nRotations;      // number of old files to keep
+	uint64_t    _flushInterval;   // ms
+
+	// Ring buffer:
+	std::vector<logLine> _buffer;
+	size_t   _head;               // oldest line
+	size_t   _count;
+	uint64_t _nOverwritten;       // lines lost because the buffer was full
+
+	// Repetitions per message text since it was last written:
+	struct repeatState
+	{
+		std::time_t timeWritten;
+		uint64_t    nSuppressed;
+	};
+	std::unordered_map<std::string, repeatState> _repeats;
+	std::time_t _lastSweep;
+
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::thread* _thread;
+	bool _stop;
+
+	void enqueue(std::time_t time, const std::string &text);
+	void flushRepetitions(std::time_t now, bool all);
+	void run();
+	void writeLine(const logLine &line);
+	bool openFile();
+	void closeFile();
+	void rotate();
+
+public:
+	logWriter();
+	~logWriter();
+
+	// Settings must be made before start():
+	void setFile(const std::string &filename);
+	void setRotation(uint64_t maxFileSize, unsigned nRotations);
+	void setFlushInterval(uint64_t flushInterval);
+	void setBufferSize(size_t nLines);
+
+	void start();
+	void stop();  // writes everything that is still buffered
+
+	void write(const std::string &text, bool urgent);
+};
+
+#endif
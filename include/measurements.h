@@ -5,33 +5,94 @@
 
 #include <cstdint>
 #include <vector>
+#include <deque>
 #include <cmath>
 #include <algorithm>
 
+#include "sampleblock.h"
+
 uint64_t timeDiff(uint64_t timestamp1, uint64_t timestamp2);
 
+// Pre-aggregated statistics for long evaluation periods:
+#define N_ROLLUP_TIERS 2
+enum rollupTier {rollup_minute = 0, rollup_hour = 1, rollup_none = -1};
+
+struct rollup
+{
+	uint64_t end;    // covers the time interval (end - tier period, end]
+	uint64_t count;
+	double   sum;
+	double   sumsq;
+	double   min;
+	double   max;
+};
+
+uint64_t rollupPeriod(rollupTier tier);
+
+// Memory for one raw measurement (value and timestamp):
+#define MEASUREMENT_SIZE (sizeof(double) + sizeof(uint64_t))
+// Estimate for compressed measurements, on the safe side for noisy values:
+#define COMPRESSED_MEASUREMENT_SIZE 10
+
 class measurements
 {
 private:
-	std::vector<double> _values;
-	std::vector<uint64_t> _timestamps;  // microtime in milliseconds
+	std::deque<double>   _values;
+	std::deque<uint64_t> _timestamps;  // microtime in milliseconds
 
 	uint64_t _minimumRestPeriod;  // min. time between two measurements, in ms
+	size_t   _capacity;           // max. number of values to keep
+	uint64_t _nTruncated;         // values dropped because the capacity was reached
+
+	// Older values can be kept in compressed blocks, the newest ones are always uncompressed.
+	// Only the front block can hold expired values; they are trimmed when room is needed.
+	bool     _compress;
+	std::deque<sampleBlock> _blocks;
+	size_t   _nInBlocks;
+	uint64_t _earliestToKeep;  // of the last clean()
+
+	void sealBlock();
+	void trimFrontBlock();
+	void appendValue(double value, uint64_t timestamp);
+
+	std::deque<rollup> _rollups[N_ROLLUP_TIERS];
+	uint64_t _rollupTimeToKeep[N_ROLLUP_TIERS];  // in ms, 0: tier not used
+
+	void addToRollups(double value, uint64_t timestamp);
 
 public:
 	measurements();
 	~measurements();
 
 	void setMinimumRestPeriod(uint64_t ms);
+	void setCapacity(size_t capacity);
+	size_t getCapacity() const;
+	uint64_t nTruncated() const;
+	void setCompression(bool compress);
+	bool getCompression() const;
+	size_t bytesPerMeasurement() const;  // planned
+	size_t memoryUsage() const;          // actual, in bytes
 	void addValue(double value, uint64_t timestamp);
 	void setOnlyValue(double value, uint64_t timestamp);  // Counters only keep the last value.
 	void clean(uint64_t earliest_timestamp_to_keep);
+	void cleanRollups(uint64_t currentTimestamp);
 	void clear();
 
+	void accumulateRollupTimeToKeep(rollupTier tier, uint64_t timeToKeep);
+	size_t plannedRollupMemory() const;  // in bytes
+	rollup rollupStatistics(rollupTier tier, uint64_t startTimestamp) const;  // (startTimestamp, newest]
+
 	size_t nMeasurements() const;
 	double getLastValue() const;
 
 	std::vector<double>* valuesInConfidence(uint64_t startTimestamp, double absolute, double nSigma) const;
+
+	// For checkpoints:
+	uint64_t getLastTimestamp() const;
+	void valuesSince(uint64_t startTimestamp, std::vector<uint64_t> &timestamps, std::vector<double> &values) const;
+	void rollupsSince(rollupTier tier, uint64_t startTimestamp, std::vector<rollup> &rollups) const;
+	void restoreValue(double value, uint64_t timestamp);
+	void restoreRollup(rollupTier tier, const rollup &r);
 };
 
 namespace measurementFunctions
@@ -43,6 +104,11 @@ namespace measurementFunctions
 	double minimum(const std::vector<double>* values);
 	double stdDevMean(const std::vector<double>* values);
 	double stdDevMedian(const std::vector<double>* values);
+
+	double mean(const rollup &r);
+	double maximum(const rollup &r);
+	double minimum(const rollup &r);
+	double stdDevMean(const rollup &r);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef _METRICS_H
+#define _METRICS_H
+
+/* Runtime metrics of the logger process itself, exported in the
+   Prometheus text format on a local port and optionally as JSON for MQTT.
+   Metrics are created before the exporter is started; afterwards the
+   registry does not change. Updates are lock-free (atomics only) and
+   may come from any thread, the exporter thread only reads. */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+// Upper bounds of the histogram buckets in µs, and +Inf:
+#define METRIC_HISTOGRAM_BUCKETS 16
+
+#define METRICS_MAX_REQUEST_SIZE 4096  // bytes of an HTTP request that are read
+
+enum metric_type {metric_counter, metric_gauge, metric_histogram};
+
+class metric
+{
+protected:
+	std::string _name;
+	std::string _help;
+	std::string _labelName;   // optional, e.g. "sensor"
+	std::string _labelValue;
+
+	std::string labels(const std::string &extra) const;  // {sensor="T",le="0.1"}
+
+public:
+	metric(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue);
+	virtual ~metric();
+
+	virtual metric_type type() const = 0;
+	const std::string& name() const;
+	const std::string& help() const;
+	const std::string& labelValue() const;
+
+	virtual void writePrometheus(std::string &out) const = 0;  // sample lines
+	virtual void writeJSON(std::string &out) const = 0;        // value
+};
+
+class metricCounter : public metric
+{
+private:
+	std::atomic<uint64_t> _value;
+
+public:
+	metricCounter(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue);
+
+	metric_type type() const;
+	void add(uint64_t n = 1);
+	void set(uint64_t value);  // for totals that are counted elsewhere
+	uint64_t value() const;
+
+	void writePrometheus(std::string &out) const;
+	void writeJSON(std::string &out) const;
+};
+
+class metricGauge : public metric
+{
+private:
+	std::atomic<double> _value;
+
+public:
+	metricGauge(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue);
+
+	metric_type type() const;
+	void set(double value);
+	double value() const;
+
+	void writePrometheus(std::string &out) const;
+	void writeJSON(std::string &out) const;
+};
+
+// Durations, observed in µs and exported in seconds.
+class metricHistogram : public metric
+{
+private:
+	std::atomic<uint64_t> _buckets[METRIC_HISTOGRAM_BUCKETS + 1];  // not cumulative, last: +Inf
+	std::atomic<uint64_t> _count;
+	std::atomic<uint64_t> _sum;  // µs
+
+public:
+	metricHistogram(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue);
+
+	metric_type type() const;
+	void observe(uint64_t duration);  // µs
+
+	void writePrometheus(std::string &out) const;
+	void writeJSON(std::string &out) const;
+};
+
+class metricsRegistry
+{
+private:
+	std::vector<metric*> _metrics;
+
+	int _socket;
+	std::thread* _thread;
+	std::atomic<bool> _stop;
+
+	void serve();
+	void respond(int client);
+
+	// Families in order of their first registration:
+	void families(std::vector<std::vector<const metric*> > &f) const;
+
+public:
+	metricsRegistry();
+	~metricsRegistry();
+
+	// labelName and labelValue are optional; metrics of the same name
+	// form one family and must have the same type and label name.
+	metricCounter*   newCounter(const std::string &name, const std::string &help, const std::string &labelName = "", const std::string &labelValue = "");
+	metricGauge*     newGauge(const std::string &name, const std::string &help, const std::string &labelName = "", const std::string &labelValue = "");
+	metricHistogram* newHistogram(const std::string &name, const std::string &help, const std::string &labelName = "", const std::string &labelValue = "");
+
+	std::string prometheus() const;
+	std::string json() const;
+
+	// HTTP endpoint for GET /metrics; false if the port cannot be bound.
+	bool start(const std::string &address, unsigned short port);
+	void stop();
+};
+
+#endif
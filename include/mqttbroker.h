@@ -4,9 +4,32 @@
 #ifdef OPTION_MQTT
 
 #include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <atomic>
+#include <cstdint>
 #include "mqtt/async_client.h"
+#include "mqttqueue.h"
+#include "mqttspool.h"
 
 class logger;
+class sensorMQTT;
+
+class mqttBroker;
+
+// Keeps track of the publish tokens that paho has not yet completed.
+class mqttPublishListener : public virtual mqtt::iaction_listener
+{
+private:
+	mqttBroker* _broker;
+
+public:
+	mqttPublishListener(mqttBroker* broker);
+
+	void on_failure(const mqtt::token& tok) override;
+	void on_success(const mqtt::token& tok) override;
+};
 
 class mqttBroker : public virtual mqtt::callback, public virtual mqtt::iaction_listener
 {
@@ -25,7 +48,7 @@ private:
 	std::string _lwt_topic;
 	std::string _lwt_payload;
 
-	bool        _isConnected;
+	std::atomic<bool> _isConnected;
 
 	logger*     _root;
 
@@ -35,8 +58,28 @@ private:
 	mqtt::connect_options _connOpts;
 	mqtt::async_client*   _mqttClient;
 
+	// Outbound messages and unacknowledged publish tokens:
+	mqttQueue             _queue;
+	mqttSpool             _spool;   // keeps messages while disconnected
+	mqttPublishListener   _publishListener;
+	unsigned              _maxInFlight;
+	std::atomic<unsigned> _nInFlight;
+	std::atomic<unsigned> _session;   // counts connections, tags publish tokens
+	std::atomic<uint64_t> _nPublished;
+	std::atomic<uint64_t> _nFailed;
+	std::mutex            _sendMutex;
+	uint64_t              _timestamp_lastStatistics;
+	uint64_t              _nDropped_lastStatistics;
+
+	// MQTT sensors, sorted by their subscribe topic:
+	std::vector<std::pair<std::string, sensorMQTT*>> _subscriptions;
+
 	void generateClientID();
 	void reconnect();
+	void buildSubscriptionIndex();
+	void dispatch(sensorMQTT* smqtt, std::string_view topic, std::string_view payload);
+	void sendQueued(uint64_t currentTimestamp);
+	bool releaseInFlight(unsigned session);
 
 	bool isValidTopic(const std::string& topic) const;
 
@@ -63,14 +106,33 @@ public:
 	void setLWTpayload(const std::string& lwtpayload);
 	void setConnectedTopic(const std::string& connectedtopic);
 	void setConnectedPayload(const std::string& connectedpayload);
+	void setMaxQueueSize(size_t maxQueueSize);
+	void setMaxPublishRate(double messagesPerSecond);
+	void setMaxInFlight(unsigned maxInFlight);
+	void setSpoolSize(size_t spoolSize);
+	void setSpoolFile(const std::string &spoolFile);
+	void setSpoolReplayRate(double messagesPerSecond);
 
 	std::string getHost() const;
 	unsigned    getPort() const;
 	int         getQoS() const;
 	bool        doRetain() const;
 
+	// Publish queue statistics:
+	size_t   nQueued() const;
+	size_t   nSpooled() const;
+	unsigned nInFlight() const;
+	uint64_t nPublished() const;
+	uint64_t nCoalesced() const;
+	uint64_t nDropped() const;
+	uint64_t nFailed() const;
+	std::string queueStatistics() const;
+
+	void publishFinished(bool success, const mqtt::token& tok);
+
 	void connectToMQTTBroker();
 	void publish(const std::string &topic, const std::string &payload, bool enforce);
+	void processQueue(uint64_t currentTimestamp);
 };
 
 #else
@@ -3,6 +3,7 @@
 
 // Manages several MQTT brokers.
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -18,9 +19,12 @@ public:
 	~mqttManager();
 
 	void addBroker(mqttBroker* broker);
+	size_t nBrokers() const;
+	mqttBroker* getBroker(size_t i);
 
 	void connectToMQTTBrokers();
 	void publish(const std::string &topic, const std::string &payload);
+	void processQueues(uint64_t currentTimestamp);
 
 };
 
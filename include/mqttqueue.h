@@ -0,0 +1,88 @@
+#ifndef _MQTTQUEUE_H
+#define _MQTTQUEUE_H
+
+// Outbound message queue for one MQTT broker.
+// Messages for a topic that is still waiting in the queue are coalesced
+// (only the most recent payload is kept), and a token bucket limits
+// the number of messages that may be released per second.
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+struct mqttMessage
+{
+	std::string topic;
+	std::string payload;
+};
+
+// Token bucket: allows a given number of events per second,
+// with bursts of up to one second's worth of events.
+class rateLimiter
+{
+private:
+	double   _rate;  // events per second, 0: unlimited
+	double   _tokens;
+	uint64_t _timestamp_lastRefill;
+
+public:
+	rateLimiter();
+
+	void   setRate(double eventsPerSecond);
+	double getRate() const;
+
+	bool acquire(uint64_t currentTimestamp);
+};
+
+class mqttQueue
+{
+private:
+	struct queueEntry
+	{
+		uint64_t    seq;
+		mqttMessage message;
+	};
+
+	std::deque<queueEntry> _entries;
+	std::unordered_map<std::string, uint64_t> _pendingTopics;  // topic -> sequence number of its queue entry
+	uint64_t _nextSeq;
+	mutable std::mutex _mutex;
+
+	size_t      _maxSize;
+	rateLimiter _limiter;
+
+	std::atomic<uint64_t> _nEnqueued;
+	std::atomic<uint64_t> _nCoalesced;
+	std::atomic<uint64_t> _nDropped;
+
+	void popFront();
+
+public:
+	mqttQueue();
+	~mqttQueue();
+
+	void setMaxSize(size_t maxSize);
+	void setMaxRate(double messagesPerSecond);
+
+	size_t getMaxSize() const;
+	double getMaxRate() const;
+
+	// Returns false if the oldest message had to be dropped to make room.
+	bool push(const std::string &topic, const std::string &payload);
+
+	// Takes the oldest message from the queue if the rate limit allows it.
+	bool pop(mqttMessage &message, uint64_t currentTimestamp);
+
+	size_t size() const;
+	bool empty() const;
+	void clear();
+
+	uint64_t nEnqueued() const;
+	uint64_t nCoalesced() const;
+	uint64_t nDropped() const;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _MQTTSPOOL_H
+#define _MQTTSPOOL_H
+
+// Store-and-forward buffer for one MQTT broker. Keeps messages that
+// are published while the broker is not connected, and releases them
+// in their original order (rate-limited) once it is connected again.
+// Messages that do not fit into memory go to an optional spool file,
+// which also survives a restart of Sensorlogger.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+
+#include "mqttqueue.h"
+
+class mqttSpool
+{
+private:
+	std::deque<mqttMessage> _memory;
+	size_t                  _maxMemory;   // messages, 0: spooling disabled
+
+	std::string _filename;
+	uint64_t    _maxFileSize;             // bytes
+	FILE*       _file;
+	long        _readOffset;              // position of the oldest unread record
+	size_t      _nOnDisk;                 // records not yet read back
+
+	rateLimiter _limiter;
+	mutable std::mutex _mutex;
+
+	std::atomic<uint64_t> _nSpooled;
+	std::atomic<uint64_t> _nDropped;
+
+	bool openFile();
+	void closeFile();
+	void resetFile();
+	bool writeRecord(const mqttMessage &message);
+	bool readRecord(mqttMessage &message);
+	void refillFromFile();
+
+public:
+	mqttSpool();
+	~mqttSpool();
+
+	void setMaxMemory(size_t maxMessages);
+	void setFile(const std::string &filename, uint64_t maxFileSize);
+	void setReplayRate(double messagesPerSecond);
+
+	bool enabled() const;
+
+	void push(const mqttMessage &message);
+	bool pop(mqttMessage &message, uint64_t currentTimestamp);
+
+	size_t size() const;
+	bool empty() const;
+
+	uint64_t nSpooled() const;
+	uint64_t nDropped() const;
+};
+
+#endif
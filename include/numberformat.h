@@ -0,0 +1,42 @@
+#ifndef _NUMBERFORMAT_H
+#define _NUMBERFORMAT_H
+
+// Conversion of measurement values to text for logbooks, MQTT and HomeMatic.
+// Based on std::to_chars: locale-independent and without stream objects.
+
+#include <cstddef>
+#include <string>
+
+#define NUMBERFORMAT_BUFFER_SIZE 64
+
+enum numberStyle {numberGeneral, numberFixed, numberShortest};
+
+class numberFormat
+{
+private:
+	numberStyle _style;
+	int         _precision;  // significant digits (general) or decimals (fixed)
+
+public:
+	numberFormat();
+
+	// Six significant digits, like the default output of a std::stringstream.
+	void setGeneral();
+	void setDecimals(int decimals);
+	// Shortest representation that reads back to the same double.
+	void setShortest();
+
+	// Config value of "decimals": a number of decimal places or "shortest".
+	bool setFromString(const std::string &decimals);
+
+	numberStyle getStyle() const;
+	int getPrecision() const;
+
+	// Writes into the given buffer (not terminated), returns the number of characters.
+	size_t format(double value, char* buffer, size_t bufferSize) const;
+
+	void append(double value, std::string &out) const;
+	std::string format(double value) const;
+};
+
+#endif
@@ -19,6 +19,7 @@ class readoutFile
 {
 private:
 	std::string _content;
+	int         _error;  // of the last read, 0 if successful
 	uint64_t    _last_read_timestamp;
 	bool        _isHTTP;
 public:
@@ -0,0 +1,44 @@
+#ifndef _SAMPLEBLOCK_H
+#define _SAMPLEBLOCK_H
+
+// Compressed block of measurements (timestamp and value pairs) that will
+// not change anymore. Timestamps are stored as delta-of-delta, values as
+// XOR with the previous value (as in Facebook's Gorilla time series store).
+// For slot-aligned timestamps and slowly changing values, a sample takes
+// a few bits instead of 16 bytes. The encoding is lossless.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+
+#define SAMPLEBLOCK_SIZE 128  // measurements per block
+
+class sampleBlock
+{
+private:
+	std::vector<uint64_t> _bits;
+	size_t   _nBits;
+	size_t   _count;
+	uint64_t _firstTimestamp;
+	uint64_t _lastTimestamp;
+
+	void     writeBits(uint64_t value, unsigned nBits);
+	uint64_t readBits(size_t &position, unsigned nBits) const;
+
+public:
+	sampleBlock();
+
+	// Encodes the first n entries of the given measurements.
+	void encode(const std::deque<uint64_t> &timestamps, const std::deque<double> &values, size_t n);
+
+	// Appends the decoded measurements with timestamps > startTimestamp.
+	void decode(uint64_t startTimestamp, std::vector<double> &values, std::vector<uint64_t>* timestamps = NULL) const;
+
+	size_t   count() const;
+	uint64_t firstTimestamp() const;
+	uint64_t lastTimestamp() const;
+	size_t   memory() const;  // in bytes
+};
+
+#endif
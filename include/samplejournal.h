@@ -0,0 +1,93 @@
+#ifndef _SAMPLEJOURNAL_H
+#define _SAMPLEJOURNAL_H
+
+// Append-only journal of all raw measurements that the sensors accept.
+// The journal is split into segment files in one directory; a new segment
+// is started when the current one reaches its maximum size, and the
+// oldest segments can be deleted automatically. Samples are buffered
+// and written by a background thread.
+// A journal can be replayed through the logbooks to regenerate them,
+// see logger::replay(), as can samples from CSV files.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class sensor;
+
+struct journalSample
+{
+	uint16_t sensorIndex;  // into the segment's list of sensor IDs
+	uint64_t timestamp;    // ms
+	double   value;        // raw, before factor and offset
+};
+
+class sampleJournal
+{
+private:
+	std::string _path;            // directory for the segments
+	uint64_t    _maxSegmentSize;  // bytes
+	unsigned    _maxSegments;     // 0: keep all
+	uint64_t    _flushInterval;   // ms
+
+	std::vector<std::string> _sensorIDs;
+	std::unordered_map<const sensor*, uint16_t> _sensorIndex;
+
+	std::vector<journalSample> _buffer;
+	size_t   _maxBuffer;
+	uint64_t _nDropped;           // samples lost because the buffer was full
+	uint64_t _nWriteFailures;
+
+	FILE*    _segment;
+	uint64_t _segmentSize;
+
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::thread* _thread;
+	bool _stop;
+
+	void run();
+	bool openSegment(uint64_t firstTimestamp);
+	void closeSegment();
+	void deleteOldSegments();
+	bool writeSamples(const std::vector<journalSample> &samples);
+
+public:
+	sampleJournal();
+	~sampleJournal();
+
+	// Settings must be made before start():
+	void setPath(const std::string &path);
+	void setSegmentSize(uint64_t maxSegmentSize);
+	void setMaxSegments(unsigned maxSegments);
+	void setSensors(const std::vector<sensor*> &sensors);
+
+	bool enabled() const;
+	const std::string& getPath() const;
+
+	void start();
+	void stop();  // writes everything that is still buffered
+
+	void add(const sensor* s, uint64_t timestamp, double value);
+
+	// Returns the number of samples lost or not written since the last call.
+	uint64_t nLost();
+	size_t nBuffered();  // samples waiting to be written
+
+	// Reading journals:
+	static std::vector<std::string> segmentFiles(const std::string &path);
+	static bool readSegment(const std::string &filename, std::vector<std::string> &sensorIDs, std::vector<journalSample> &samples);
+
+	// Recorded samples from other sources, one per line:
+	// timestamp;sensor_id;value (also separated by commas or tabs).
+	// The timestamp is either in ms since the epoch or local time as "YYYY-MM-DD hh:mm:ss".
+	static bool isCSV(const std::string &filename);
+	static bool readCSV(const std::string &filename, std::vector<std::string> &sensorIDs, std::vector<journalSample> &samples);
+};
+
+#endif
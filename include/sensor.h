@@ -5,6 +5,11 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <atomic>
+
+#include "numberformat.h"
+#include "measurements.h"
+#include "telemetry.h"
 
 enum sensor_type {sensor_json, sensor_tinkerforge, sensor_mqtt, sensor_homematic};
 enum trigger_event {periodic, high, low, high_or_low, mqttSubscribe};
@@ -12,12 +17,12 @@ enum trigger_event {periodic, high, low, high_or_low, mqttSubscribe};
 class measurements;
 class counter;
 class logger;
+class metricCounter;
 
 class sensor
 {
 private:
-	//void count();
-	void count(uint64_t currentTimestamp);
+	void count(uint64_t eventTime);
 	bool isCounter() const;
 
 protected:
@@ -36,11 +41,20 @@ protected:
 	std::string   _mqttPublishTopic;
 	std::string   _homematicPublishISE;
 	bool          _lastValuePublished;
+	numberFormat  _format;             // for published values
 
 	uint64_t      _keepValuesFor_ms;   // defined by the maximum logbook cycle time
 
 	uint64_t      _timestamp_lastMeasurement;
 
+	readTelemetry _telemetry;          // reads from the sensor's source
+	std::atomic<metricCounter*> _metricSamples;  // accepted samples, NULL without metrics
+	void recordRead(read_result result, uint64_t startTime, int errorCode = 0);  // startTime: monotonic µs
+
+	uint64_t      _nTruncatedReported;
+	uint64_t      _timestamp_lastTruncationWarning;
+	void checkTruncation(uint64_t currentTimestamp);
+
 	logger* _root;
 
 public:
@@ -54,7 +68,21 @@ public:
 	void clean(uint64_t currentTimestamp);
 
 	void accumulateMaxTimeToKeep(uint64_t timeToKeep);
+	void accumulateRollupTimeToKeep(rollupTier tier, uint64_t timeToKeep);
+
+	// Memory planning:
+	size_t requiredCapacity() const;  // measurements needed for the longest evaluation period
+	void setCapacity(size_t capacity);
+	void setCompression(bool compress);
+	size_t bytesPerMeasurement() const;
+	size_t memoryUsage() const;       // in bytes
+	size_t getCapacity() const;
+	size_t plannedMemory() const;     // in bytes
+	uint64_t nTruncated() const;      // measurements lost because the capacity was too small
 	counter* newCounter();
+	size_t nCounters() const;
+	counter* getCounter(size_t i);
+	measurements* getMeasurements();
 
 	void setPointerToLogger(logger* root);
 	void setSensorID(const std::string &sensorID);
@@ -66,6 +94,7 @@ public:
 	void setRetryTime(uint64_t retryTime);
 	void setMQTTPublishTopic(const std::string &mqttPublishTopic);
 	void setHomematicPublishISE(const std::string &homematicPublishISE);
+	void setNumberFormat(const numberFormat &format);
 
 	void addJSONkey(const std::string &key);
 	void setJSONkeys(const std::vector<std::string>* keys);
@@ -83,6 +112,9 @@ public:
 	uint64_t getRetryTime() const;
 	std::string getMQTTPublishTopic() const;
 
+	readTelemetry* telemetry();
+	void setSampleMetric(metricCounter* samples);
+
 	uint64_t getReadFailures() const;
 	void addReadFailure();
 	void resetReadFailures();
@@ -91,8 +123,11 @@ public:
 
 	size_t nMeasurements() const;
 	bool addRawMeasurement(double value);
+	bool addRawMeasurement(double value, uint64_t currentTimestamp);
+	bool addRawMeasurement(double value, uint64_t currentTimestamp, uint64_t eventTime);  // eventTime: monotonic µs
 	
 	std::vector<double>* valuesInConfidence(uint64_t startTimestamp, double absolute, double nSigma) const;
+	rollup rollupStatistics(rollupTier tier, uint64_t startTimestamp) const;
 
 	void reset();
 	virtual bool measure(uint64_t currentTimestamp) = 0;
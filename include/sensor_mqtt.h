@@ -22,7 +22,7 @@ public:
 	sensorMQTT(logger* root, const std::string &sensorID, const std::string &mqttPublishTopic, const std::string &homematicPublishISE, const std::string &mqttSubscribeTopic, const std::vector<std::string>* jsonKeys, bool isCounter, double factor, double offset, uint64_t minimumRestPeriod, uint64_t retryTime);
 
 	sensor_type type() const;
-	std::string getMQTTSubscribeTopic() const;
+	const std::string& getMQTTSubscribeTopic() const;
 
 	bool measure(uint64_t currentTimestamp);
 };
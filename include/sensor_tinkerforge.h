@@ -3,6 +3,8 @@
 
 #ifdef OPTION_TINKERFORGE
 
+#include <atomic>
+
 #include "sensor.h"
 #include "tinkerforge.h"
 
@@ -12,16 +14,17 @@ private:
 	void failWithReadError(int tf_error_code);
 
 	std::string _uid;
-	unsigned    _deviceType;
+	std::atomic<unsigned> _deviceType;  // set by the enumeration callback
 	uint8_t     _channel;  // To select input channel
 	uint16_t    _bitMask;  // Input channel mask
 	char        _ioPort;   // Port 'a' or 'b' of the IO16 bricklet
 	unsigned    _debounceTime;
+	unsigned    _averaging;   // samples averaged on the Bricklet, 0: Bricklet default
+	unsigned    _sampleRate;  // samples per second on the Bricklet, 0: Bricklet default
 
 	bool        _isInitialized;
 
-	tinkerforge*          _tinkerMan;
-	tinkerforge_callback* _tinkerforgeCallback;
+	std::atomic<tinkerforge*> _tinkerMan;  // NULL until a Brick Daemon has found the UID
 
 public:
 	sensorTinkerforge(logger* root, const std::string &sensorID, const std::string &mqttPublishTopic, const std::string &homematicPublishISE, tinkerforge* tinkerManager, const std::string uid, trigger_event triggerEvent, bool isCounter, uint8_t channel, char ioPort, uint32_t debounceTime, double factor, double offset, uint64_t minimumRestPeriod, uint64_t retryTime);
@@ -31,12 +34,15 @@ public:
 	sensor_type type() const;
 
 	std::string getUID() const;
+	tinkerforge* getDaemon() const;
 	std::string getMasterBrickUID() const;
 	unsigned    getDeviceType() const;
 	uint16_t    getBitMask() const;
 	uint8_t     getChannel() const;
 	uint32_t    getDebounceTime() const;
 	char        getIOPort() const;
+	unsigned    getAveraging() const;
+	unsigned    getSampleRate() const;
 
 	void setUID(const std::string &uid);
 	void setMasterBrickUID(const std::string &masterBrickUID);
@@ -44,8 +50,15 @@ public:
 	void setChannel(uint8_t channel);
 	void setIOPort(char ioPort);
 	void setDebounceTime(uint32_t debounceTime);
+	void setAveraging(unsigned averaging);
+	void setSampleRate(unsigned sampleRate);
+
+	// Binds an unbound sensor to a Brick Daemon. Returns false if it is already bound to another one.
+	bool bindDaemon(tinkerforge* tinkerMan);
 
 	void registerCallback();
+	void inputChanged(bool high, uint64_t currentTimestamp, uint64_t eventTime);  // called back by digital inputs
+	bool isDue(uint64_t currentTimestamp) const;  // periodic sensor, rest period is over
 	bool poll(uint64_t currentTimestamp);
 	bool measure(uint64_t currentTimestamp);
 };
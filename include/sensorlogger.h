@@ -9,20 +9,55 @@
 #define DEFAULT_MAX_ENTRIES          30
 #define DEFAULT_MEASUREMENT_INTERVAL 60000   // 60 seconds
 #define DEFAULT_RETRY_TIME           300000  // 5 minutes
+#define DEFAULT_FREQ_PERCENTILE      50      // for freq_percentile columns
+#define DEFAULT_GUST_PERCENTILE      95      // for gust_factor columns
 #define DEFAULT_HTTP_TIMEOUT         10L
 #define DEFAULT_HTTP_MAXFILESIZE     10485760L  // 10 MB
 #define DEFAULT_HTTP_MAXREDIRS       10L
 
+// Application log file:
+#define DEFAULT_LOGFILE_MAX_SIZE       0       // bytes, 0: no rotation
+#define DEFAULT_LOGFILE_ROTATIONS      3       // old log files to keep
+#define DEFAULT_LOGFILE_FLUSH_INTERVAL 1000    // ms
+#define DEFAULT_LOG_BUFFER_SIZE        4096    // lines waiting to be written
+#define LOG_REPEAT_INTERVAL            60      // s, summary of repeated messages at least this often
+#define LOG_REPEAT_MAX_TEXTS           256     // distinct messages that are tracked for repetitions
+
 // Tinerforge Defaults:
 #define DEFAULT_MAX_BRICKLET_READ_FAILURES   7
 #define DEFAULT_MAX_BRICKD_RESTART_ATTEMPTS  3
 #define DEFAULT_DEBOUNCE_TIME                7  // ms
 #define DEFAULT_TINKERFORGE_TIMEOUT       1000  // ms
+#define DEFAULT_ENUMERATION_TIMEOUT      10000  // ms to wait for all configured Bricklets
+#define DEFAULT_TINKERFORGE_POLL_THREADS     8  // concurrent requests to the Brick Daemon
+#define BRICKD_RECOVERY_BACKOFF          30000  // ms to wait after the first restart of a Brick Daemon, doubled for each further attempt
+#define BRICKD_RECOVERY_MAX_BACKOFF    1800000  // ms
+#define BRICKD_HEALTHY_PERIOD          3600000  // ms without restarts until the restart attempts are reset
+
+// Storage limit per sensor until its capacity is planned from the configuration:
+#define DEFAULT_MAX_MEASUREMENTS     20000
+#define TRUNCATION_WARNING_INTERVAL  3600000  // ms between warnings about lost measurements
+#define DEFAULT_CHECKPOINT_INTERVAL  60000    // ms between checkpoints of the measurement windows
+#define DEFAULT_TELEMETRY_INTERVAL   60000    // ms between reports of the sensors' read statistics
+
+// Runtime metrics of the logger:
+#define DEFAULT_METRICS_ADDRESS      "127.0.0.1"
+#define DEFAULT_METRICS_INTERVAL     60000    // ms between metrics published to MQTT
+#define DEFAULT_TRACE_FILE           "sensorlogger_trace.json"  // written on SIGUSR1, with OPTION_TRACE
 
-// Storage limit: max. number of measurements per _values vector.
-#define MAX_MEASUREMENTS     20000   
+// Raw sample journal:
+#define DEFAULT_JOURNAL_SEGMENT_SIZE   16777216L  // 16 MB
+#define DEFAULT_JOURNAL_FLUSH_INTERVAL 1000       // ms
+#define DEFAULT_JOURNAL_BUFFER_SIZE    100000     // samples waiting to be written
 
 // MQTT Defaults
 #define MQTT_KEEPALIVE_INTERVAL 20  // seconds
+#define DEFAULT_MQTT_MAX_QUEUE_SIZE    1000  // messages per broker
+#define DEFAULT_MQTT_MAX_PUBLISH_RATE  0     // messages per second, 0: unlimited
+#define DEFAULT_MQTT_MAX_INFLIGHT      20    // unacknowledged messages per broker
+#define MQTT_STATISTICS_INTERVAL       60000 // ms between queue reports in the debug log
+#define DEFAULT_MQTT_SPOOL_SIZE        5000  // messages kept in memory while disconnected
+#define DEFAULT_MQTT_SPOOL_FILE_SIZE   52428800L  // 50 MB
+#define DEFAULT_MQTT_SPOOL_REPLAY_RATE 20    // messages per second after reconnecting
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef _SYSTEMCOMMAND_H
+#define _SYSTEMCOMMAND_H
+
+// Shell command that runs in a child process. The caller checks on it
+// with running() instead of waiting, and gets its output (stdout and
+// stderr) and exit status when it is done.
+
+#include <string>
+#include <sys/types.h>
+
+class systemCommand
+{
+private:
+	std::string _command;
+	pid_t       _pid;
+	int         _outputPipe;  // read end, non-blocking
+	std::string _output;
+	int         _exitStatus;
+
+	void readOutput();
+	void closePipe();
+
+public:
+	systemCommand();
+	~systemCommand();
+
+	// Returns false if the child process could not be started.
+	bool start(const std::string &command);
+	bool running();
+
+	const std::string& command() const;
+	const std::string& output() const;
+	int exitStatus() const;  // -1 if the command did not exit normally
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#include "histogram.h"
+
+/* Statistics of a sensor's reads from its source (Bricklet, HTTP or
+   file, HomeMatic CCU): the outcome of each read, the last error code
+   and the distribution of the read latencies. record() is lock-free and
+   never allocates, because it runs on the polling threads; the main
+   thread takes a report from time to time, which starts a new report
+   interval for the latencies. */
+
+enum read_result {read_ok, read_timeout, read_error};
+
+struct readReport
+{
+	// Since the start:
+	uint64_t nOK;
+	uint64_t nTimeouts;
+	uint64_t nErrors;
+	int      lastError;            // 0 if there was no error
+	uint64_t timestamp_lastError;
+	uint64_t nTruncated;           // measurements dropped at capacity, set by the logger
+
+	// In the report interval, latencies in ms:
+	uint64_t nReads;
+	double   meanLatency;
+	double   latency_p50;
+	double   latency_p95;
+	double   maxLatency;
+
+	std::string summary() const;  // for the debug log
+	std::string json() const;     // MQTT payload
+};
+
+class readTelemetry
+{
+private:
+	std::atomic<uint64_t> _nOK;
+	std::atomic<uint64_t> _nTimeouts;
+	std::atomic<uint64_t> _nErrors;
+	std::atomic<int>      _lastError;
+	std::atomic<uint64_t> _timestamp_lastError;
+
+	// Report interval:
+	std::atomic<uint64_t> _nReads;
+	std::atomic<uint64_t> _sumLatency;  // µs
+	std::atomic<uint64_t> _maxLatency;  // µs
+	intervalHistogram     _latencies;   // µs
+
+public:
+	readTelemetry();
+
+	// latency in µs, errorCode and currentTimestamp only for failed reads
+	void record(read_result result, uint64_t latency, int errorCode, uint64_t currentTimestamp);
+
+	uint64_t nReads() const;  // since the start
+	void report(readReport &r);
+};
+
+#endif
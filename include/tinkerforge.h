@@ -5,6 +5,11 @@
 #include <cstdint>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
 
 #include "ip_connection.h"
 #include "brick_master.h"
@@ -66,21 +71,70 @@
 
 class logger;
 class sensorTinkerforge;
+class workerPool;
+class systemCommand;
+struct tfBricklet;
+struct tfDeviceDriver;
+
+enum recovery_state {recovery_idle, recovery_running, recovery_backoff};
 
 std::string getTFConnectionErrorText(int e);
 std::string getDeviceType_name(uint16_t device_identifier);
 std::string getDeviceType_nice(uint16_t device_identifier);
-void enumerateTFSensors(const char *uid, const char *connected_uid, char position, uint8_t hardware_version[3], uint8_t firmware_version[3], uint16_t device_identifier, uint8_t enumeration_type, logger* _root);
+class tinkerforge;
+void enumerateTFSensors(const char *uid, const char *connected_uid, char position, uint8_t hardware_version[3], uint8_t firmware_version[3], uint16_t device_identifier, uint8_t enumeration_type, tinkerforge* tinkerMan);
 
 class tinkerforge
 {
 private:
+	std::string _name;
 	std::string _host;
 	unsigned short _port;
 	uint32_t _timeout;
 
 	logger* _root;
 
+	// Failure accounting for this Brick Daemon:
+	unsigned    _maxReadFailures;
+	unsigned    _maxRestartAttempts;
+	unsigned    _restartAttemptCounter;
+	std::string _cmdRestart;
+	std::string _cmdRestartSystem;
+
+	// Recovery runs the restart command in a child process and then waits
+	// before the daemon's sensors are polled again. The trigger loop goes on.
+	std::atomic<recovery_state> _recoveryState;
+	systemCommand* _recoveryCommand;
+	uint64_t _recoveryBackoff;          // ms
+	uint64_t _timestamp_recoveryEnd;
+
+	// Enumeration runs on the IP connection's callback thread. It is done
+	// when all configured UIDs have been seen or the timeout has passed.
+	// Sensors without an explicit daemon are listed at every daemon and
+	// are bound to the first one that finds their UID.
+	std::unordered_map<std::string, tfBricklet*> _bricklets;
+	std::unordered_set<std::string> _enumeratedUIDs;
+	std::mutex _enumerationMutex;
+	bool     _enumerating;
+	uint64_t _enumerationTimeout;  // ms
+	uint64_t _timestamp_enumerationStart;
+
+	bool isResolved(const tfBricklet* bricklet) const;
+	bool isEnumerated(const std::string &uid);
+	void checkEnumeration();
+
+	// Device handles are kept for the lifetime of the IP connection:
+	std::mutex _devicesMutex;
+	void* device(tfBricklet* bricklet, const tfDeviceDriver* driver);
+	void destroyDevices();
+	int configure(tfBricklet* bricklet, const tfDeviceDriver* driver, void* d);
+
+	// Periodic sensors are polled by several threads, so that their
+	// requests to the Brick Daemon are pipelined on the connection.
+	unsigned    _pollThreads;
+	workerPool* _pollPool;
+	std::atomic<bool> _pollingConcurrently;  // the connection must not be replaced
+
 public:
 	IPConnection *_ipcon;
 
@@ -88,108 +142,52 @@ public:
 	tinkerforge(logger* root, const std::string &host, unsigned short port);
 	~tinkerforge();
 
+	void setName(const std::string &name);
 	void setHost(const std::string &host);
 	void setPort(unsigned short port);
-
+	void setMaxReadFailures(unsigned maxReadFailures);
+	void setMaxRestartAttempts(unsigned maxRestartAttempts);
+	void setRestartCommand(const std::string &command);
+	void setSystemRestartCommand(const std::string &command);
+	void setEnumerationTimeout(uint64_t enumerationTimeout);
+	void setPollThreads(unsigned pollThreads);
+
+	std::string getName() const;  // host:port if no name is set
+	logger* ptLogger() const;
 	std::string getHost() const;
 	unsigned short getPort() const;
+	unsigned getMaxReadFailures() const;
+	unsigned getMaxRestartAttempts() const;
+	const std::string& getRestartCommand() const;
+	const std::string& getSystemRestartCommand() const;
+	uint64_t getEnumerationTimeout() const;
+	unsigned getPollThreads() const;
+
+	void addSensor(sensorTinkerforge* s);
+	void deviceEnumerated(const std::string &uid, uint16_t device_identifier, uint8_t enumeration_type);
+	bool enumerationPending();  // also reports a timeout
+
+	// Counts the attempts to solve read failures by restarting the Brick Daemon:
+	unsigned restartAttempts() const;
+	void resetRestartAttempts();
+
+	// Non-blocking recovery, driven by the trigger loop:
+	bool recovering() const;  // the daemon's sensors are not polled
+	bool startRecovery(const std::string &command, bool systemRestart, uint64_t currentTimestamp);
+	void updateRecovery(uint64_t currentTimestamp);
+
+	// Access to a sensor's Bricklet through its driver. Return the Tinkerforge error code.
+	int read(sensorTinkerforge* s, const tfDeviceDriver* driver, double &value);
+	int enableCallback(sensorTinkerforge* s, const tfDeviceDriver* driver);
+
+	// Polls all periodic sensors that are due, one task per Bricklet.
+	// Returns the sensors that have a new measurement.
+	void pollSensors(uint64_t currentTimestamp, std::vector<sensorTinkerforge*> &measured);
 
 	bool disconnect();
 	bool disconnect_and_prepare();
 	bool reconnect();
 };
 
-
-/* A callback class to store all callback properties for a sensorTinkerforge object.
-   Which callbacks will be registered (and how) will be figured out later by the
-   tinkerforge TinkerMan, because Sensors with the same UID but different thresholds/periods
-   might be defined. */
-
-class tinkerforge_callback
-{
-protected:
-	sensorTinkerforge* _s;
-	tinkerforge*       _tinkerMan;
-
-	bool               _value_has_to_change;
-	double             _min;
-	double             _max;
-
-public:
-	tinkerforge_callback();
-	virtual ~tinkerforge_callback();
-
-	bool         valueHasToChange() const;
-	double       min() const;
-	double       max() const;
-
-	void setValueHasToChange(bool value_has_to_change);
-	void setMin(double min);
-	void setMax(double max);
-
-	virtual void reset() = 0;
-	virtual void registerCallback() = 0;
-};
-
-class tinkerforge_callback_io4 : public tinkerforge_callback
-{
-private:
-	IO4 *_io4;
-
-public:
-	tinkerforge_callback_io4(sensorTinkerforge* s, tinkerforge* tinkerMan);
-	~tinkerforge_callback_io4();
-
-	void reset();
-	void registerCallback();
-};
-
-
-class tinkerforge_callback_io4_v2 : public tinkerforge_callback
-{
-private:
-	IO4V2 *_io4_v2;
-
-public:
-	tinkerforge_callback_io4_v2(sensorTinkerforge* s, tinkerforge* tinkerMan);
-	~tinkerforge_callback_io4_v2();
-
-	void reset();
-	void registerCallback();
-};
-
-
-class tinkerforge_callback_io16 : public tinkerforge_callback
-{
-private:
-	IO16 *_io16;
-
-public:
-	tinkerforge_callback_io16(sensorTinkerforge* s, tinkerforge* tinkerMan);
-	~tinkerforge_callback_io16();
-
-	void reset();
-	void registerCallback();
-};
-
-class tinkerforge_callback_io16_v2 : public tinkerforge_callback
-{
-private:
-	IO16V2 *_io16_v2;
-
-public:
-	tinkerforge_callback_io16_v2(sensorTinkerforge* s, tinkerforge* tinkerMan);
-	~tinkerforge_callback_io16_v2();
-
-	void reset();
-	void registerCallback();
-};
-
-
-// Callback functions
-void callback_io4(uint8_t interrupt_mask, uint8_t value_mask, sensorTinkerforge* cb);  // IO-4
-void callback_io16(char port, uint8_t interrupt_mask, uint8_t value_mask, sensorTinkerforge* s); // IO-16
-void callback_io_v2(uint8_t channel, bool changed, bool value, sensorTinkerforge* s); // IO-4/16 2.0
-
 #endif
 #endif
\ No newline at end of file
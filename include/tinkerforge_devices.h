@@ -0,0 +1,105 @@
+#ifndef _TINKERFORGE_DEVICES_H
+#define _TINKERFORGE_DEVICES_H
+
+#ifdef OPTION_TINKERFORGE
+
+/* Descriptors of the supported Tinkerforge Bricklets.
+   Each Bricklet type is a specialization of tfDevice<device identifier>
+   that names its handle type, how a channel is read and scaled,
+   for analog inputs how averaging on the device is configured and,
+   for digital inputs, how value callbacks are enabled. The registry
+   turns the descriptors into a table of drivers, looked up by the
+   device identifier that the enumeration reports. */
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "tinkerforge.h"
+
+// Return values of a driver's read() besides the Tinkerforge error codes:
+#define TF_VALUE     0  // value has been read
+#define TF_NO_VALUE  1  // nothing to read on this channel, not a failure
+
+// Error code for a PTC Bricklet without a connected sensor:
+#define E_NO_SENSOR_CONNECTED -100
+
+class sensorTinkerforge;
+
+// What a sensor reads from its Bricklet:
+struct tfChannel
+{
+	uint8_t  channel;
+	uint16_t bitMask;
+	char     ioPort;   // 'a' or 'b', IO-16 only
+};
+
+// How a sensor wants to be called back on input changes:
+struct tfCallbackSettings
+{
+	uint8_t  channel;
+	char     ioPort;
+	uint32_t debounceTime;  // ms
+	uint32_t period;        // ms
+};
+
+// Averaging on the Bricklet, so that fewer, less noisy values are polled.
+// A setting of 0 keeps the Bricklet's own configuration.
+struct tfOversampling
+{
+	unsigned averaging;   // samples
+	unsigned sampleRate;  // samples per second
+};
+
+struct tfDeviceDriver;
+
+/* A Bricklet as seen from one Brick Daemon. The device handle lives as
+   long as the IP connection: it is created on first use and destroyed
+   before the connection is. All sensors on the UID share it, because the
+   IP connection passes responses and callbacks to one device per UID. */
+struct tfBricklet
+{
+	std::string uid;
+	tinkerforge* daemon;
+	std::vector<sensorTinkerforge*> sensors;  // configured with this UID
+
+	const tfDeviceDriver* driver;
+	void* device;  // handle of the driver's type, NULL if not created
+	std::atomic<bool> configured;  // false after the handle is created or the Bricklet restarted
+};
+
+struct tfDeviceDriver
+{
+	uint16_t deviceIdentifier;
+
+	void* (*create)(const char* uid, IPConnection* ipcon);
+	void  (*destroy)(void* device);
+	int   (*read)(void* device, const tfChannel &channel, double &value);
+	int   (*configure)(void* device, const tfOversampling &oversampling);
+	int   (*enableCallback)(void* device, const tfCallbackSettings &settings, tfBricklet* bricklet);
+};
+
+// NULL if the Bricklet type is not supported.
+const tfDeviceDriver* getTFDeviceDriver(uint16_t deviceIdentifier);
+
+
+// Descriptors, specialized in tinkerforge_devices.cpp:
+template<uint16_t deviceIdentifier> struct tfDevice;
+
+// Defaults for the parts a Bricklet does not need to describe:
+struct tfDeviceDefaults
+{
+	template<typename H> static int configure(H* device, const tfOversampling &oversampling)
+	{
+		return E_NOT_SUPPORTED;
+	}
+
+	template<typename H> static int enableCallback(H* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+	{
+		return E_NOT_SUPPORTED;
+	}
+};
+
+#endif
+#endif
@@ -0,0 +1,62 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+/* Tracing of the trigger loop, compiled in with OPTION_TRACE (see makefile).
+   TRACE_SCOPE("name") or TRACE_SCOPE("name", detail) records the time
+   spent in the enclosing scope as one complete event; the detail (e.g.
+   a sensor ID) is copied and truncated. Each thread writes into its own
+   ring buffer without locks, so only the latest events are kept. On
+   SIGUSR1, the trigger loop writes all buffers as a Chrome trace file,
+   which can be opened in chrome://tracing or ui.perfetto.dev.
+   Without OPTION_TRACE, the macro expands to nothing and its arguments
+   are not evaluated. */
+
+#ifdef OPTION_TRACE
+
+#include <cstdint>
+#include <string>
+
+#define TRACE_BUFFER_EVENTS 8192  // per thread
+#define TRACE_DETAIL_SIZE   32    // characters of a detail, including the terminating 0
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(...) traceScope TRACE_CONCAT(_traceScope, __LINE__)(__VA_ARGS__)
+
+class tracer
+{
+public:
+	static uint64_t now();  // µs, monotonic
+
+	// name must be a string literal; detail is copied.
+	static void record(const char* name, const char* detail, uint64_t start, uint64_t end);
+
+	// The signal handler only sets a flag; the dump is written by
+	// the thread that asks for it with dumpRequested().
+	static void installSignalHandler();
+	static bool dumpRequested();
+
+	// Returns the number of events written.
+	static size_t dump(const std::string &filename);
+};
+
+class traceScope
+{
+private:
+	const char* _name;
+	char        _detail[TRACE_DETAIL_SIZE];
+	uint64_t    _start;
+
+public:
+	traceScope(const char* name);
+	traceScope(const char* name, const char* detail);
+	traceScope(const char* name, const std::string &detail);
+	~traceScope();
+};
+
+#else
+
+#define TRACE_SCOPE(...)
+
+#endif
+#endif
@@ -0,0 +1,43 @@
+#ifndef _WORKERPOOL_H
+#define _WORKERPOOL_H
+
+// Small fixed pool of threads that runs a batch of independent tasks.
+// The calling thread takes part in the work and run() returns when
+// all tasks of the batch are finished.
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class workerPool
+{
+private:
+	std::vector<std::thread*> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::condition_variable _done;
+
+	const std::function<void(size_t)>* _task;
+	size_t _nTasks;
+	size_t _nextTask;
+	size_t _nBusy;
+	bool   _stop;
+
+	void work();
+	void runTasks(std::unique_lock<std::mutex> &lock);
+
+public:
+	workerPool(unsigned nThreads);  // including the calling thread
+	~workerPool();
+
+	unsigned nThreads() const;
+
+	// Calls task(i) for i = 0..nTasks-1. Tasks must not throw.
+	void run(size_t nTasks, const std::function<void(size_t)> &task);
+};
+
+#endif
@@ -0,0 +1,479 @@
+#include "checkpoint.h"
+
+#include "sensorlogger.h"
+#include "sensor.h"
+#include "measurements.h"
+#include "counter.h"
+
+#include <cstring>
+#include <map>
+#include <unistd.h>
+
+#define CHECKPOINT_MAGIC   "SLCP"
+#define CHECKPOINT_VERSION 2
+
+// Record types:
+#define RECORD_MEASUREMENTS 'M'
+#define RECORD_ROLLUPS      'R'
+#define RECORD_COUNTER      'C'
+#define RECORD_COUNTER_DELTA 'D'
+
+/* File format: magic, uint32 version, then records.
+   Record: uint32 length of the rest, uint8 type, uint16 length of the
+   sensor ID, sensor ID, content:
+     'M': uint32 n, n times (uint64 timestamp, double value)
+     'R': uint8 tier, uint32 n, n rollups
+     'C': uint32 counter index, serialized counter (all stored cycles)
+     'D': like 'C', but only the cycles that were finished since the
+          previous checkpoint and the current one; they replace cycles
+          with the same start time
+   A record that is cut off (crash while writing) ends the file. */
+
+static void appendBytes(std::string &data, const void* bytes, size_t n)
+{
+	data.append(static_cast<const char*>(bytes), n);
+}
+
+static void beginRecord(std::string &record, char type, const std::string &sensorID)
+{
+	record.clear();
+	record.push_back(type);
+
+	uint16_t idLength = static_cast<uint16_t>(sensorID.size());
+	appendBytes(record, &idLength, sizeof(idLength));
+	record.append(sensorID, 0, idLength);
+}
+
+static void appendRecord(std::string &records, const std::string &record)
+{
+	uint32_t length = static_cast<uint32_t>(record.size());
+	appendBytes(records, &length, sizeof(length));
+	records.append(record);
+}
+
+// Reads n bytes from a record's content; false if the record is too short.
+static bool readBytes(const std::string &record, size_t &pos, void* bytes, size_t n)
+{
+	if((pos + n) > record.size())
+		return false;
+
+	memcpy(bytes, record.data() + pos, n);
+	pos += n;
+	return true;
+}
+
+// Cycles of one counter by their start time, each CYCLECOUNTER_FIELDS values:
+typedef std::map<uint64_t, std::vector<uint64_t> > counterCycles;
+
+static void mergeCounterCycles(const std::string &data, counterCycles &cycles)
+{
+	size_t pos = 0;
+	uint64_t n = 0;
+	if(!readBytes(data, pos, &n, sizeof(n)))
+		return;
+
+	std::vector<uint64_t> fields(CYCLECOUNTER_FIELDS);
+	for(uint64_t i=0; i<n; ++i)
+	{
+		if(!readBytes(data, pos, fields.data(), CYCLECOUNTER_FIELDS * sizeof(uint64_t)))
+			return;
+
+		cycles[fields[1]] = fields;
+	}
+}
+
+static std::string serializeCounterCycles(const counterCycles &cycles)
+{
+	std::string data;
+	uint64_t n = cycles.size();
+	appendBytes(data, &n, sizeof(n));
+
+	for(counterCycles::const_iterator c = cycles.begin(); c != cycles.end(); ++c)
+		appendBytes(data, c->second.data(), CYCLECOUNTER_FIELDS * sizeof(uint64_t));
+
+	return data;
+}
+
+checkpoint::checkpoint()
+{
+	_interval = DEFAULT_CHECKPOINT_INTERVAL;
+	_timestamp_lastCheckpoint = 0;
+
+	_snapshotRequired = true;
+	_journalSize  = 0;
+	_snapshotSize = 0;
+	_nWriteFailures = 0;
+
+	_thread = NULL;
+	_stop   = false;
+}
+
+checkpoint::~checkpoint()
+{
+	stop();
+}
+
+void checkpoint::setFile(const std::string &filename)
+{
+	_filename = filename;
+}
+
+void checkpoint::setInterval(uint64_t interval)
+{
+	_interval = interval;
+}
+
+bool checkpoint::enabled() const
+{
+	return (_filename.size() > 0) && (_interval > 0);
+}
+
+size_t checkpoint::restore(const std::vector<sensor*> &sensors, uint64_t currentTimestamp)
+{
+	_lastSampleTimestamp.assign(sensors.size(), 0);
+	_timestamp_lastCheckpoint = currentTimestamp;
+	_snapshotRequired = true;
+
+	if(!enabled())
+		return 0;
+
+	FILE* f = fopen(_filename.c_str(), "rb");
+	if(f == NULL)
+		return 0;
+
+	char magic[4];
+	uint32_t version = 0;
+	bool valid = (fread(magic, 1, 4, f) == 4) && (memcmp(magic, CHECKPOINT_MAGIC, 4) == 0);
+	valid = valid && (fread(&version, sizeof(version), 1, f) == 1) && (version == CHECKPOINT_VERSION);
+	if(!valid)
+	{
+		fclose(f);
+		return 0;
+	}
+
+	std::map<std::string, size_t> sensorIndex;
+	for(size_t i=0; i<sensors.size(); ++i)
+		sensorIndex[sensors[i]->getSensorID()] = i;
+
+	// Cycles of each counter, from its newest full record and the deltas after it:
+	std::map<std::pair<size_t, uint32_t>, counterCycles> counters;
+
+	size_t nRestored = 0;
+	std::string record;
+	uint32_t length;
+	while(fread(&length, sizeof(length), 1, f) == 1)
+	{
+		record.resize(length);
+		if((length == 0) || (fread(&record[0], 1, length, f) != length))
+			break;  // cut off
+
+		size_t pos = 1;
+		uint16_t idLength;
+		if(!readBytes(record, pos, &idLength, sizeof(idLength)) || ((pos + idLength) > record.size()))
+			break;
+
+		std::map<std::string, size_t>::iterator s = sensorIndex.find(record.substr(pos, idLength));
+		pos += idLength;
+		if(s == sensorIndex.end())
+			continue;  // sensor no longer configured
+
+		measurements* m = sensors[s->second]->getMeasurements();
+
+		if(record[0] == RECORD_MEASUREMENTS)
+		{
+			uint32_t n = 0;
+			readBytes(record, pos, &n, sizeof(n));
+
+			uint64_t timestamp;
+			double value;
+			for(uint32_t i=0; i<n; ++i)
+			{
+				if(!readBytes(record, pos, &timestamp, sizeof(timestamp)) || !readBytes(record, pos, &value, sizeof(value)))
+					break;
+
+				if(timestamp <= currentTimestamp)
+				{
+					m->restoreValue(value, timestamp);
+					++nRestored;
+				}
+			}
+		}
+		else if(record[0] == RECORD_ROLLUPS)
+		{
+			uint8_t tier = 0;
+			uint32_t n = 0;
+			readBytes(record, pos, &tier, sizeof(tier));
+			readBytes(record, pos, &n, sizeof(n));
+
+			rollup r;
+			for(uint32_t i=0; (i<n) && (tier<N_ROLLUP_TIERS); ++i)
+			{
+				if(!readBytes(record, pos, &r, sizeof(r)))
+					break;
+
+				if(r.end <= (currentTimestamp + rollupPeriod(static_cast<rollupTier>(tier))))
+					m->restoreRollup(static_cast<rollupTier>(tier), r);
+			}
+		}
+		else if((record[0] == RECORD_COUNTER) || (record[0] == RECORD_COUNTER_DELTA))
+		{
+			uint32_t index = 0;
+			if(readBytes(record, pos, &index, sizeof(index)))
+			{
+				counterCycles &cycles = counters[std::make_pair(s->second, index)];
+				if(record[0] == RECORD_COUNTER)
+					cycles.clear();
+
+				mergeCounterCycles(record.substr(pos), cycles);
+			}
+		}
+	}
+
+	fclose(f);
+
+	for(std::map<std::pair<size_t, uint32_t>, counterCycles>::iterator c = counters.begin(); c != counters.end(); ++c)
+	{
+		sensor* s = sensors[c->first.first];
+		if(c->first.second < s->nCounters())
+			s->getCounter(c->first.second)->restore(serializeCounterCycles(c->second), currentTimestamp);
+	}
+
+	// Discard everything that has expired while Sensorlogger was not running:
+	for(size_t i=0; i<sensors.size(); ++i)
+	{
+		sensors[i]->clean(currentTimestamp);
+		_lastSampleTimestamp[i] = sensors[i]->getMeasurements()->getLastTimestamp();
+	}
+
+	return nRestored;
+}
+
+// Serializes what has changed since the last checkpoint, or everything for a snapshot.
+void checkpoint::collect(const std::vector<sensor*> &sensors, uint64_t currentTimestamp, bool everything, std::string &records)
+{
+	if(_lastSampleTimestamp.size() != sensors.size())
+		_lastSampleTimestamp.resize(sensors.size(), 0);
+
+	if(_counterResets.size() != sensors.size())
+		_counterResets.resize(sensors.size());
+
+	std::string record;
+	std::vector<uint64_t> timestamps;
+	std::vector<double> values;
+	std::vector<rollup> rollups;
+
+	for(size_t i=0; i<sensors.size(); ++i)
+	{
+		sensor* s = sensors[i];
+		const measurements* m = s->getMeasurements();
+
+		timestamps.clear();
+		values.clear();
+		m->valuesSince(everything ? 0 : _lastSampleTimestamp[i], timestamps, values);
+		if(values.size() > 0)
+		{
+			beginRecord(record, RECORD_MEASUREMENTS, s->getSensorID());
+			uint32_t n = static_cast<uint32_t>(values.size());
+			appendBytes(record, &n, sizeof(n));
+			for(size_t v=0; v<values.size(); ++v)
+			{
+				appendBytes(record, &timestamps[v], sizeof(uint64_t));
+				appendBytes(record, &values[v], sizeof(double));
+			}
+			appendRecord(records, record);
+
+			_lastSampleTimestamp[i] = timestamps.back();
+		}
+
+		for(uint8_t tier=0; tier<N_ROLLUP_TIERS; ++tier)
+		{
+			rollups.clear();
+			m->rollupsSince(static_cast<rollupTier>(tier), everything ? 0 : _timestamp_lastCheckpoint, rollups);
+			if(rollups.size() > 0)
+			{
+				beginRecord(record, RECORD_ROLLUPS, s->getSensorID());
+				uint32_t n = static_cast<uint32_t>(rollups.size());
+				appendBytes(record, &tier, sizeof(tier));
+				appendBytes(record, &n, sizeof(n));
+				appendBytes(record, rollups.data(), n * sizeof(rollup));
+				appendRecord(records, record);
+			}
+		}
+
+		// Counters: only the cycles finished since the last checkpoint and the
+		// current one, unless the counter has been reset in the meantime.
+		if(_counterResets[i].size() != s->nCounters())
+			_counterResets[i].assign(s->nCounters(), 0);
+
+		for(uint32_t c=0; c<s->nCounters(); ++c)
+		{
+			const counter* cnt = s->getCounter(c);
+			bool full = everything || (cnt->nResets() != _counterResets[i][c]);
+			_counterResets[i][c] = cnt->nResets();
+
+			beginRecord(record, full ? RECORD_COUNTER : RECORD_COUNTER_DELTA, s->getSensorID());
+			appendBytes(record, &c, sizeof(c));
+			cnt->serialize(record, currentTimestamp, full ? 0 : _timestamp_lastCheckpoint);
+			appendRecord(records, record);
+		}
+	}
+}
+
+uint64_t checkpoint::update(const std::vector<sensor*> &sensors, uint64_t currentTimestamp)
+{
+	if(!enabled() || (timeDiff(_timestamp_lastCheckpoint, currentTimestamp) < _interval))
+		return 0;
+
+	return write(sensors, currentTimestamp);
+}
+
+uint64_t checkpoint::write(const std::vector<sensor*> &sensors, uint64_t currentTimestamp)
+{
+	// Compact when the journal is mostly outdated records:
+	if(_journalSize > (2 * _snapshotSize + 65536))
+		_snapshotRequired = true;
+
+	std::string records;
+	if(_snapshotRequired)
+	{
+		records = CHECKPOINT_MAGIC;
+		uint32_t version = CHECKPOINT_VERSION;
+		appendBytes(records, &version, sizeof(version));
+	}
+
+	collect(sensors, currentTimestamp, _snapshotRequired, records);
+	_timestamp_lastCheckpoint = currentTimestamp;
+
+	uint64_t nFailures;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if(_snapshotRequired)
+		{
+			// Everything that was still pending is contained in the snapshot.
+			_snapshot.swap(records);
+			_pending.clear();
+			_snapshotSize = _snapshot.size();
+			_journalSize  = _snapshotSize;
+			_snapshotRequired = false;
+		}
+		else
+		{
+			_pending.append(records);
+			_journalSize += records.size();
+		}
+
+		nFailures = _nWriteFailures;
+		_nWriteFailures = 0;
+	}
+
+	// The file might be incomplete: start over with a snapshot.
+	if(nFailures > 0)
+		_snapshotRequired = true;
+
+	_wakeUp.notify_one();
+
+	return nFailures;
+}
+
+// Immediate checkpoint that is on disk when this function returns.
+void checkpoint::flush(const std::vector<sensor*> &sensors, uint64_t currentTimestamp)
+{
+	if(!enabled())
+		return;
+
+	write(sensors, currentTimestamp);
+
+	stop();
+	start();
+}
+
+void checkpoint::start()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(enabled() && (_thread == NULL))
+	{
+		_stop   = false;
+		_thread = new std::thread(&checkpoint::run, this);
+	}
+}
+
+void checkpoint::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(_thread == NULL)
+			return;
+
+		_stop = true;
+	}
+
+	_wakeUp.notify_one();
+	_thread->join();
+	delete _thread;
+	_thread = NULL;
+}
+
+void checkpoint::run()
+{
+	std::string snapshot, pending;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(true)
+	{
+		_wakeUp.wait(lock, [this]{ return _stop || (_snapshot.size() > 0) || (_pending.size() > 0); });
+
+		snapshot.clear();
+		pending.clear();
+		snapshot.swap(_snapshot);
+		pending.swap(_pending);
+		bool stopNow = _stop;
+
+		lock.unlock();
+
+		uint64_t nFailures = 0;
+		if((snapshot.size() > 0) && !writeSnapshot(snapshot))
+			++nFailures;
+
+		if((pending.size() > 0) && !appendRecords(pending))
+			++nFailures;
+
+		lock.lock();
+		_nWriteFailures += nFailures;
+
+		if(stopNow && (_snapshot.size() == 0) && (_pending.size() == 0))
+			break;
+	}
+}
+
+// Written to a temporary file first: the old checkpoint stays valid until the rename.
+bool checkpoint::writeSnapshot(const std::string &data)
+{
+	std::string tmpFilename = _filename + ".tmp";
+	FILE* f = fopen(tmpFilename.c_str(), "wb");
+	if(f == NULL)
+		return false;
+
+	bool success = (fwrite(data.data(), 1, data.size(), f) == data.size());
+	success = success && (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+	fclose(f);
+
+	if(success)
+		success = (rename(tmpFilename.c_str(), _filename.c_str()) == 0);
+
+	return success;
+}
+
+bool checkpoint::appendRecords(const std::string &data)
+{
+	FILE* f = fopen(_filename.c_str(), "ab");
+	if(f == NULL)
+		return false;
+
+	bool success = (fwrite(data.data(), 1, data.size(), f) == data.size());
+	success = success && (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+	fclose(f);
+
+	return success;
+}
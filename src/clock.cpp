@@ -0,0 +1,45 @@
+#include "clock.h"
+
+#include <chrono>
+
+loggerClock::~loggerClock()
+{
+
+}
+
+uint64_t systemClock::now() const
+{
+	const auto now = std::chrono::system_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
+}
+
+uint64_t systemClock::monotonic() const
+{
+	const auto now = std::chrono::steady_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count());
+}
+
+virtualClock::virtualClock()
+{
+	_now = 0;
+}
+
+uint64_t virtualClock::now() const
+{
+	return _now;
+}
+
+uint64_t virtualClock::monotonic() const
+{
+	return _now * 1000;
+}
+
+void virtualClock::set(uint64_t timestamp)
+{
+	_now = timestamp;
+}
+
+void virtualClock::advance(uint64_t ms)
+{
+	_now += ms;
+}
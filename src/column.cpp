@@ -17,6 +17,9 @@ column::column(sensor* s, logbook* lb, const std::string &title, const std::stri
 	if(_pulseCounter == NULL)
 		_pulseCounter = s->newCounter();
 
+	_percentile = 50;
+	_tier = rollup_none;
+
 	setTitle(title);
 	setUnit(unit);
 	setOperation(op);
@@ -26,6 +29,8 @@ column::column(sensor* s, logbook* lb, const std::string &title, const std::stri
 	setMQTTPublishTopic(mqttPublishTopic);
 	setHomematicPublishISE(homematicPublishISE);
 	setCountFactor(countFactor);
+
+	registerStorage();
 }
 
 std::string column::getTitle() const
@@ -73,6 +78,64 @@ double column::getCountFactor() const
 	return _countFactor;
 }
 
+double column::getPercentile() const
+{
+	return _percentile;
+}
+
+// Operations that are evaluated from the pulse counter instead of the measurement values.
+bool column::isCounterOperation() const
+{
+	return (_op == freq || _op==freq_min || _op==freq_max || _op==freq_percentile || _op==gust_factor || _op==count);
+}
+
+rollupTier column::getRollupTier() const
+{
+	return _tier;
+}
+
+// Statistics that can be merged from pre-aggregated values:
+bool column::canUseRollups() const
+{
+	if((_confidenceAbsolute != 0) || (_confidenceSigma != 0))
+		return false;
+
+	return (_op == mean || _op == max || _op == min || _op == sum || _op == stdDevMean);
+}
+
+// Tells the sensor which kind of values have to be kept for how long.
+void column::registerStorage()
+{
+	_tier = rollup_none;
+
+	// Counter operations do not need any stored values.
+	if(isCounterOperation())
+		return;
+
+	if(canUseRollups())
+	{
+		// Use the coarsest tier whose periods fit the evaluation period and the logbook cycles:
+		const rollupTier tiers[] = {rollup_hour, rollup_minute};
+		for(size_t i=0; i<2; ++i)
+		{
+			uint64_t period = rollupPeriod(tiers[i]);
+			if(((_evaluationPeriod % period) == 0) && ((_rootLogbook->getCycleTime() % period) == 0))
+			{
+				_tier = tiers[i];
+				_sensor->accumulateRollupTimeToKeep(_tier, _evaluationPeriod);
+				return;
+			}
+		}
+	}
+
+	_sensor->accumulateMaxTimeToKeep(_evaluationPeriod);
+}
+
+const numberFormat& column::getNumberFormat() const
+{
+	return _format;
+}
+
 counter* column::getCounter()
 {
 	return _pulseCounter;
@@ -96,6 +159,10 @@ void column::setUnit(const std::string &unit)
 void column::setOperation(operation op)
 {
 	_op = op;
+
+	// Interval distributions are only kept if a column needs them:
+	if(_op == freq_percentile || _op == gust_factor)
+		_pulseCounter->enableHistograms();
 }
 
 void column::setEvaluationPeriod(uint64_t evaluationPeriod)
@@ -105,7 +172,6 @@ void column::setEvaluationPeriod(uint64_t evaluationPeriod)
 	{
 		_evaluationPeriod = _rootLogbook->getCycleTime();
 	}
-	_sensor->accumulateMaxTimeToKeep(_evaluationPeriod);
 	calculateColumnCycles();
 }
 
@@ -114,6 +180,7 @@ void column::calculateColumnCycles()
 	uint64_t nCycles = _evaluationPeriod / _rootLogbook->getCycleTime();
 
 	_nCycles = static_cast<size_t>(nCycles);
+	_pulseCounter->setCycleTime(_rootLogbook->getCycleTime());
 	_pulseCounter->accumulateCyclesToStore(_nCycles);
 }
 
@@ -142,13 +209,42 @@ void column::setCountFactor(double countFactor)
 	_countFactor = countFactor;
 }
 
+void column::setPercentile(double percentile)
+{
+	_percentile = percentile;
+	if(_percentile < 0)   _percentile = 0;
+	if(_percentile > 100) _percentile = 100;
+}
+
+void column::setNumberFormat(const numberFormat &format)
+{
+	_format = format;
+}
+
 std::string column::getValue(uint64_t startTimestamp, uint64_t currentTimestamp) const
 {
 	if(_sensor != NULL)
 	{
 		double value = 0;
+
+		if(_tier != rollup_none)
+		{
+			rollup r = _sensor->rollupStatistics(_tier, startTimestamp);
+			switch(_op)
+			{
+				case(mean):       value = measurementFunctions::mean(r); break;
+				case(max):        value = measurementFunctions::maximum(r); break;
+				case(min):        value = measurementFunctions::minimum(r); break;
+				case(sum):        value = r.sum; break;
+				case(stdDevMean): value = measurementFunctions::stdDevMean(r); break;
+				default: break;
+			}
+
+			return _format.format(value);
+		}
+
 		std::vector<double>* values = NULL;
-		if(!(_op == freq || _op==freq_min || _op==freq_max || _op==count))
+		if(!isCounterOperation())
 		{
 			values = _sensor->valuesInConfidence(startTimestamp, _confidenceAbsolute, _confidenceSigma);
 		}
@@ -174,17 +270,21 @@ std::string column::getValue(uint64_t startTimestamp, uint64_t currentTimestamp)
 			case(freq_max):
 				value = _countFactor * _pulseCounter->frequency_max(_nCycles);
 				break;
+			case(freq_percentile):
+				value = _countFactor * _pulseCounter->frequency_percentile(_nCycles, _percentile);
+				break;
+			case(gust_factor):
+				value = _pulseCounter->gust_factor(_nCycles, _percentile, currentTimestamp);
+				break;
 		}
 
-		if(!(_op == freq || _op==freq_min || _op==freq_max || _op==count))
+		if(!isCounterOperation())
 		{
 			if(values != NULL)
 				delete values;
 		}
 
-		std::stringstream ss;
-		ss << value;
-		return ss.str();
+		return _format.format(value);
 	}
 
 	throw E_NO_VALUES_FOR_COLUMN;
@@ -1,37 +1,87 @@
 #include "counter.h"
 #include "measurements.h"
 
+#include <algorithm>
+#include <cstring>
+
+cycleCounter::cycleCounter()
+{
+	reset(0);
+}
+
 cycleCounter::cycleCounter(const uint64_t currentTimestamp)
 {
 	reset(currentTimestamp);
 }
 
+cycleCounter::cycleCounter(const cycleCounter &other)
+{
+	*this = other;
+}
+
 cycleCounter::~cycleCounter()
 {
 
 }
 
+cycleCounter& cycleCounter::operator=(const cycleCounter &other)
+{
+	_counts                = other._counts.load();
+	_timestamp_countsSince = other._timestamp_countsSince.load();
+	_timestamp_finished    = other._timestamp_finished.load();
+	_minTimeDistance       = other._minTimeDistance.load();
+	_maxTimeDistance       = other._maxTimeDistance.load();
+	_timestamp_lastCount   = other._timestamp_lastCount.load();
+
+	return *this;
+}
+
 uint64_t cycleCounter::getStartTimestamp() const
 {
 	return _timestamp_countsSince;
 }
 
-void cycleCounter::count(const uint64_t currentTimestamp)
+void cycleCounter::save(uint64_t* fields) const
 {
-	uint64_t timeDistance = timeDiff(currentTimestamp, _timestamp_lastCount);
+	fields[0] = _counts;
+	fields[1] = _timestamp_countsSince;
+	fields[2] = _timestamp_finished;
+	fields[3] = _minTimeDistance;
+	fields[4] = _maxTimeDistance;
+	fields[5] = _timestamp_lastCount;
+}
 
-	++_counts;
-	_timestamp_lastCount = currentTimestamp;
+void cycleCounter::load(const uint64_t* fields)
+{
+	_counts                = fields[0];
+	_timestamp_countsSince = fields[1];
+	_timestamp_finished    = fields[2];
+	_minTimeDistance       = fields[3];
+	_maxTimeDistance       = fields[4];
+	_timestamp_lastCount   = 0;
+}
 
-	if((_maxTimeDistance == 0) || (timeDistance > _maxTimeDistance))
-	{
-		_maxTimeDistance = timeDistance;
-	}
+void cycleCounter::count(const uint64_t eventTime)
+{
+	uint64_t lastCount = _timestamp_lastCount.exchange(eventTime, std::memory_order_relaxed);
+	_counts.fetch_add(1, std::memory_order_relaxed);
 
-	if((_minTimeDistance == 0) || (timeDistance < _minTimeDistance))
-	{
-		_minTimeDistance = timeDistance;
-	}
+	// The first pulse of a cycle has no distance yet:
+	if(lastCount == 0)
+		return;
+
+	uint64_t timeDistance = timeDiff(eventTime, lastCount);
+
+	// A distance of 0 means "not set yet".
+	uint64_t maxDistance = _maxTimeDistance.load(std::memory_order_relaxed);
+	while(((maxDistance == 0) || (timeDistance > maxDistance))
+		&& !_maxTimeDistance.compare_exchange_weak(maxDistance, timeDistance, std::memory_order_relaxed))
+	{ }
+
+	uint64_t minDistance = _minTimeDistance.load(std::memory_order_relaxed);
+	while(((minDistance == 0) || (timeDistance < minDistance))
+		&& !_minTimeDistance.compare_exchange_weak(minDistance, timeDistance, std::memory_order_relaxed))
+	{ }
 }
 
 void cycleCounter::finish(const uint64_t currentTimestamp)
@@ -43,6 +93,7 @@ void cycleCounter::reset(const uint64_t currentTimestamp)
 {
 	_timestamp_lastCount = 0;
 	_timestamp_countsSince = currentTimestamp;
+	_timestamp_finished = 0;
 	_counts = 0;
 
 	_minTimeDistance = 0;
@@ -55,10 +106,15 @@ uint64_t cycleCounter::counts() const
 }
 
 double cycleCounter::frequency() const
+{
+	return frequency(_timestamp_finished);
+}
+
+double cycleCounter::frequency(const uint64_t endTimestamp) const
 {
 	if(_counts > 0)
 	{
-		uint64_t periodicLength = timeDiff(_timestamp_countsSince, _timestamp_finished) / 1000;   // in s
+		uint64_t periodicLength = timeDiff(_timestamp_countsSince, endTimestamp) / 1000;   // in s
 
 		if(periodicLength > 0)
 		{
@@ -73,7 +129,7 @@ double cycleCounter::frequency_min() const
 {
 	if(_maxTimeDistance > 0)
 	{
-		return 1000.0 / static_cast<double>(_maxTimeDistance);
+		return 1000000.0 / static_cast<double>(_maxTimeDistance);
 	}
 
 	return 0;
@@ -83,7 +139,7 @@ double cycleCounter::frequency_max() const
 {
 	if(_minTimeDistance > 0)
 	{
-		return 1000.0 / static_cast<double>(_minTimeDistance);
+		return 1000000.0 / static_cast<double>(_minTimeDistance);
 	}
 
 	return 0;
@@ -94,22 +150,77 @@ double cycleCounter::frequency_max() const
 counter::counter(const uint64_t currentTimestamp)
 {
 	_nCyclesToStore = 1;
+	_cycleTime = 0;
+	_nResets = 0;
 	reset(currentTimestamp);
 }
 
 counter::~counter()
 {
-	for(size_t i=0; i<_counters.size(); ++i)
+	deleteHistograms();
+}
+
+void counter::deleteHistograms()
+{
+	for(size_t i=0; i<_histograms.size(); ++i)
+		delete _histograms.at(i);
+
+	_histograms.clear();
+}
+
+void counter::enableHistograms()
+{
+	if(_histograms.size() == 0)
 	{
-		delete _counters.at(i);
+		for(size_t i=0; i<_ring.size(); ++i)
+			_histograms.push_back(new intervalHistogram());
 	}
+}
+
+bool counter::histogramsEnabled() const
+{
+	return (_histograms.size() > 0);
+}
+
+// Storing infinitely means the current counter is never replaced,
+// otherwise one slot is kept free for the next cycle.
+size_t counter::ringSize() const
+{
+	if(_nCyclesToStore == 0)
+		return 1;
 
-	_counters.clear();
+	return _nCyclesToStore + 1;
 }
 
-void counter::count(const uint64_t currentTimestamp)
+size_t counter::position(size_t age) const
 {
-	_currentCounter->count(currentTimestamp);
+	return (_current.load() + _ring.size() - age) % _ring.size();
+}
+
+// Number of stored cycles that an evaluation over nCycles covers.
+size_t counter::cyclesToEvaluate(size_t nCycles) const
+{
+	if((nCycles == 0) || (nCycles > _nStored))  // 0: get result for all stored counters
+		return _nStored;
+
+	return nCycles;
+}
+
+void counter::count(const uint64_t eventTime)
+{
+	size_t current = _current.load(std::memory_order_acquire);
+	_ring[current].count(eventTime);
+	_totalCounts.fetch_add(1, std::memory_order_relaxed);
+
+	if(_histograms.size() > 0)
+	{
+		uint64_t lastCount = _timestamp_lastCount.exchange(eventTime, std::memory_order_relaxed);
+		if(lastCount > 0)
+		{
+			// Resolution is 1 µs: treat simultaneous pulses as 1 µs apart.
+			_histograms[current]->add(std::max(timeDiff(eventTime, lastCount), static_cast<uint64_t>(1)));
+		}
+	}
 }
 
 void counter::accumulateCyclesToStore(size_t cyclesToStore)
@@ -119,163 +230,329 @@ void counter::accumulateCyclesToStore(size_t cyclesToStore)
 		if(cyclesToStore == 0)  // store infinitely
 		{
 			_nCyclesToStore = cyclesToStore;
-			return;
 		}
-
-		if(cyclesToStore > _nCyclesToStore)
+		else if(cyclesToStore > _nCyclesToStore)
 		{
 			_nCyclesToStore = cyclesToStore;
 		}
+
+		resizeRing();
 	}
 }
 
-void counter::startNewCycle(const uint64_t currentTimestamp)
+void counter::setCycleTime(uint64_t cycleTime)
 {
-	if(_nCyclesToStore > 0)  // otherwise never reset the current counter
+	_cycleTime = cycleTime;
+}
+
+void counter::resizeRing()
+{
+	size_t newSize = ringSize();
+	if(newSize == _ring.size())
+		return;
+
+	// Keep the youngest cycles, in order from oldest to current:
+	size_t nKeep = std::min(_nStored, std::max(_nCyclesToStore, static_cast<size_t>(1)));
+	std::vector<cycleCounter> ring(newSize);
+	std::vector<uint64_t> countsBefore(newSize, 0);
+
+	for(size_t i=0; i<nKeep; ++i)
+	{
+		size_t age = nKeep - 1 - i;
+		ring[i]         = _ring[position(age)];
+		countsBefore[i] = _countsBefore[position(age)];
+	}
+
+	if(_histograms.size() > 0)
 	{
-		if(currentTimestamp > _currentCounter->getStartTimestamp())  // only if new cycle will be younger than current cycle
+		std::vector<intervalHistogram*> histograms(newSize, NULL);
+		for(size_t i=0; i<newSize; ++i)
 		{
-			_currentCounter->finish(currentTimestamp);
-			_currentCounter = new cycleCounter(currentTimestamp);
+			histograms[i] = new intervalHistogram();
+			if(i < nKeep)
+				histograms[i]->copyFrom(*_histograms[position(nKeep - 1 - i)]);
+		}
+
+		deleteHistograms();
+		_histograms.swap(histograms);
+	}
 
-			// Delete old counters:
-			while(_counters.size() >= _nCyclesToStore)
-			{
-				delete _counters.at(0);
-				_counters.erase(_counters.begin());
-			}
+	_ring.swap(ring);
+	_countsBefore.swap(countsBefore);
+	_current.store(nKeep - 1);
+	_nStored = nKeep;
+}
 
-			_counters.push_back(_currentCounter);
+void counter::startNewCycle(const uint64_t currentTimestamp)
+{
+	if(_nCyclesToStore > 0)  // otherwise never reset the current counter
+	{
+		size_t current = _current.load();
+		if(currentTimestamp > _ring[current].getStartTimestamp())  // only if new cycle will be younger than current cycle
+		{
+			_ring[current].finish(currentTimestamp);
+
+			// The new cycle goes into the spare slot. It is prepared
+			// completely before counting switches over to it; the
+			// oldest cycle then becomes the spare slot.
+			size_t next = (current + 1) % _ring.size();
+			_ring[next].reset(currentTimestamp);
+			_countsBefore[next] = _totalCounts.load();
+
+			// Never the histogram that count() is adding to:
+			if(_histograms.size() > 0)
+				_histograms[next]->clear();
+			_current.store(next, std::memory_order_release);
+
+			if(_nStored < _nCyclesToStore)
+				++_nStored;
 		}
 	}
 }
 
 void counter::reset(const uint64_t currentTimestamp)
 {
-	for(size_t i=0; i<_counters.size(); ++i)
+	// Allocate only once; afterwards the ring is reset in place,
+	// because count() might be running at the same time.
+	if(_ring.size() != ringSize())
 	{
-		delete _counters.at(i);
+		_ring.resize(ringSize());
+		_countsBefore.resize(ringSize());
 	}
 
-	_counters.clear();
-	_currentCounter = new cycleCounter(currentTimestamp);
-	_counters.push_back(_currentCounter);
+	for(size_t i=0; i<_ring.size(); ++i)
+		_ring[i].reset(currentTimestamp);
+
+	_totalCounts = 0;
+	for(size_t i=0; i<_countsBefore.size(); ++i)
+		_countsBefore[i] = 0;
+
+	for(size_t i=0; i<_histograms.size(); ++i)
+		_histograms[i]->clear();
+	_timestamp_lastCount = 0;
+
+	_current.store(0, std::memory_order_release);
+	_nStored = 1;
+	++_nResets;
+}
+
+unsigned counter::nResets() const
+{
+	return _nResets;
 }
 
 uint64_t counter::counts(size_t nCycles) const
 {
 	if(nCycles == 1)
 	{
-		return _currentCounter->counts();
+		return _ring[_current.load()].counts();
 	}
-	else if(_counters.size() > 0)
-	{
-		if(nCycles == 0)  // get result for all stored counters
-			nCycles = _counters.size();
-
-		size_t i = _counters.size();
-		uint64_t sum = 0;
 
-		do
-		{
-			--i;
-			--nCycles;
-			sum += _counters.at(i)->counts();
-		} while(i>0 && nCycles>0);
+	// Everything counted since the oldest evaluated cycle began:
+	size_t oldest = position(cyclesToEvaluate(nCycles) - 1);
+	return _totalCounts - _countsBefore[oldest];
+}
 
-		return sum;
+double counter::frequency(size_t nCycles, const uint64_t currentTimestamp) const
+{
+	if(nCycles == 1)
+	{
+		return _ring[_current.load()].frequency(currentTimestamp);
 	}
 
-	return 0;
+	size_t oldest = position(cyclesToEvaluate(nCycles) - 1);
+	uint64_t sum = counts(nCycles);
+	uint64_t startTime = _ring[oldest].getStartTimestamp();
+
+	uint64_t periodicLength = timeDiff(startTime, currentTimestamp) / 1000;   // in s
+	return static_cast<double>(sum) / static_cast<double>(periodicLength);
 }
 
-double counter::frequency(size_t nCycles, const uint64_t currentTimestamp) const
+double counter::frequency_min(size_t nCycles) const
 {
-	_currentCounter->finish(currentTimestamp);
+	size_t n = cyclesToEvaluate(nCycles);
+	double min = _ring[_current.load()].frequency_min();
 
-	if(nCycles == 1)
+	for(size_t age=1; age<n; ++age)
 	{
-		return _currentCounter->frequency();
+		if(min > _ring[position(age)].frequency_min())
+		{
+			min = _ring[position(age)].frequency_min();
+		}
 	}
-	else if(_counters.size() > 0)
-	{
-		if(nCycles == 0)  // get result for all stored counters
-			nCycles = _counters.size();
 
-		size_t i = _counters.size();
-		uint64_t sum = 0;
-		uint64_t startTime = 0;
-		do
+	return min;
+}
+
+double counter::frequency_max(size_t nCycles) const
+{
+	size_t n = cyclesToEvaluate(nCycles);
+	double max = _ring[_current.load()].frequency_max();
+
+	for(size_t age=1; age<n; ++age)
+	{
+		if(max < _ring[position(age)].frequency_max())
 		{
-			--i;
-			--nCycles;
-			sum += _counters.at(i)->counts();
-			startTime = _counters.at(i)->getStartTimestamp();
-		} while(i>0 && nCycles>0);
-
-		uint64_t periodicLength = timeDiff(startTime, currentTimestamp) / 1000;   // in s
-		return static_cast<double>(sum) / static_cast<double>(periodicLength);
+			max = _ring[position(age)].frequency_max();
+		}
 	}
 
-	return 0;
+	return max;
 }
 
-double counter::frequency_min(size_t nCycles) const
+void counter::mergeHistograms(size_t nCycles, std::vector<uint64_t> &merged) const
 {
-	if(nCycles == 1)
+	merged.assign(HISTOGRAM_N_BUCKETS, 0);
+
+	if(_histograms.size() > 0)
 	{
-		return _currentCounter->frequency_min();
+		size_t n = cyclesToEvaluate(nCycles);
+		for(size_t age=0; age<n; ++age)
+			_histograms[position(age)]->addTo(merged);
 	}
-	else if(_counters.size() > 0)
-	{
-		if(nCycles == 0)  // get result for all stored counters
-			nCycles = _counters.size();
+}
 
-		size_t i = _counters.size();
-		double min = _currentCounter->frequency_min();
+// Frequency below which the given percentage of pulses occurred.
+double counter::frequency_percentile(size_t nCycles, double percentile) const
+{
+	std::vector<uint64_t> merged;
+	mergeHistograms(nCycles, merged);
 
-		do
-		{
-			--i;
-			--nCycles;
-			if(min > _counters.at(i)->frequency_min())
-			{
-				min = _counters.at(i)->frequency_min();
-			}
-		} while(i>0 && nCycles>0);
-
-		return min;
-	}
+	// High frequencies belong to short intervals:
+	double interval = intervalHistogram::quantile(merged, 1.0 - percentile / 100.0);
+	if(interval > 0)
+		return 1000000.0 / interval;  // interval in µs
 
 	return 0;
 }
 
-double counter::frequency_max(size_t nCycles) const
+// Ratio of a high frequency percentile to the mean frequency.
+double counter::gust_factor(size_t nCycles, double percentile, const uint64_t currentTimestamp) const
 {
-	if(nCycles == 1)
+	double meanFrequency = frequency(nCycles, currentTimestamp);
+	if(meanFrequency > 0)
+		return frequency_percentile(nCycles, percentile) / meanFrequency;
+
+	return 0;
+}
+
+// Format: uint64 number of cycles, then CYCLECOUNTER_FIELDS values per cycle.
+// The current cycle is stored as if it had finished at currentTimestamp.
+void counter::serialize(std::string &data, const uint64_t currentTimestamp, const uint64_t finishedSince) const
+{
+	size_t nCyclesPos = data.size();
+	uint64_t nCycles = 0;
+	data.append(reinterpret_cast<const char*>(&nCycles), sizeof(nCycles));
+
+	uint64_t fields[CYCLECOUNTER_FIELDS];
+	for(size_t i=0; i<_nStored; ++i)
 	{
-		return _currentCounter->frequency_max();
+		_ring[position(_nStored - 1 - i)].save(fields);
+		if(fields[2] == 0)
+			fields[2] = currentTimestamp;
+		else if(fields[2] < finishedSince)
+			continue;
+
+		data.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+		++nCycles;
 	}
-	else if(_counters.size() > 0)
+
+	memcpy(&data[nCyclesPos], &nCycles, sizeof(nCycles));
+}
+
+bool counter::restore(const std::string &data, const uint64_t currentTimestamp)
+{
+	uint64_t nCycles;
+	if(data.size() < sizeof(nCycles))
+		return false;
+
+	memcpy(&nCycles, data.data(), sizeof(nCycles));
+	if(data.size() != (sizeof(nCycles) + nCycles * CYCLECOUNTER_FIELDS * sizeof(uint64_t)))
+		return false;
+
+	std::vector<cycleCounter> cycles;
+	std::vector<uint64_t> finished;
+	uint64_t fields[CYCLECOUNTER_FIELDS];
+	const char* pos = data.data() + sizeof(nCycles);
+	for(uint64_t i=0; i<nCycles; ++i)
 	{
-		if(nCycles == 0)  // get result for all stored counters
-			nCycles = _counters.size();
+		memcpy(fields, pos, sizeof(fields));
+		pos += sizeof(fields);
 
-		size_t i = _counters.size();
-		double max = _currentCounter->frequency_max();
+		// Skip cycles from the future (clock set back):
+		if(fields[1] < currentTimestamp)
+		{
+			cycles.push_back(cycleCounter());
+			cycles.back().load(fields);
+			finished.push_back(fields[2]);
+		}
+	}
 
-		do
+	if(_nCyclesToStore == 0)
+	{
+		// Counting infinitely: continue the one and only cycle.
+		reset(currentTimestamp);
+		if(cycles.size() > 0)
 		{
-			--i;
-			--nCycles;
-			if(max < _counters.at(i)->frequency_max())
-			{
-				max = _counters.at(i)->frequency_max();
-			}
-		} while(i>0 && nCycles>0);
-
-		return max;
+			_ring[0] = cycles.back();
+			_totalCounts = _ring[0].counts();
+		}
+
+		return true;
 	}
 
-	return 0;
-}
\ No newline at end of file
+	// Cycles that ended before the longest evaluation period are of no use:
+	uint64_t oldestUseful = 0;
+	if(_cycleTime > 0 && currentTimestamp > (_nCyclesToStore * _cycleTime))
+		oldestUseful = currentTimestamp - _nCyclesToStore * _cycleTime;
+
+	size_t first = 0;
+	while((first < cycles.size()) && (finished[first] < oldestUseful))
+		++first;
+
+	// The previous current cycle is continued if it belongs to the
+	// running logbook cycle, otherwise counting starts a fresh cycle.
+	bool continueLast = false;
+	if((cycles.size() > first) && (_cycleTime > 0))
+		continueLast = (cycles.back().getStartTimestamp() >= (currentTimestamp - (currentTimestamp % _cycleTime)));
+
+	size_t nFinished = cycles.size() - first;
+	if(continueLast)
+		--nFinished;
+
+	// Keep room for the current cycle:
+	if(nFinished > (_nCyclesToStore - 1))
+	{
+		first += nFinished - (_nCyclesToStore - 1);
+		nFinished = _nCyclesToStore - 1;
+	}
+
+	reset(currentTimestamp);
+
+	uint64_t total = 0;
+	size_t slot = 0;
+	for(size_t i=first; i<(first + nFinished); ++i, ++slot)
+	{
+		_ring[slot] = cycles[i];
+		_countsBefore[slot] = total;
+		total += cycles[i].counts();
+	}
+
+	_countsBefore[slot] = total;
+	if(continueLast)
+	{
+		_ring[slot] = cycles.back();
+		_ring[slot].finish(0);
+		total += cycles.back().counts();
+	}
+	else
+	{
+		_ring[slot].reset(currentTimestamp);
+	}
+
+	_totalCounts = total;
+	_current.store(slot, std::memory_order_release);
+	_nStored = slot + 1;
+
+	return true;
+}
@@ -0,0 +1,88 @@
+#include "histogram.h"
+
+#include <cmath>
+
+intervalHistogram::intervalHistogram()
+{
+	clear();
+}
+
+size_t intervalHistogram::bucketIndex(uint64_t interval)
+{
+	if(interval < HISTOGRAM_SUB_BUCKETS)
+		return static_cast<size_t>(interval);
+
+	unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(interval));  // >= 4
+	if(exponent > HISTOGRAM_MAX_EXPONENT)
+		return HISTOGRAM_N_BUCKETS - 1;
+
+	size_t subBucket = static_cast<size_t>(interval >> (exponent - 4)) & (HISTOGRAM_SUB_BUCKETS - 1);
+	return HISTOGRAM_SUB_BUCKETS + (exponent - 4) * HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+double intervalHistogram::bucketValue(size_t index)
+{
+	if(index < HISTOGRAM_SUB_BUCKETS)
+		return static_cast<double>(index);
+
+	unsigned exponent = static_cast<unsigned>((index - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_SUB_BUCKETS) + 4;
+	uint64_t subBucket = (index - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_SUB_BUCKETS;
+
+	uint64_t width = static_cast<uint64_t>(1) << (exponent - 4);
+	uint64_t lower = (HISTOGRAM_SUB_BUCKETS + subBucket) * width;
+
+	return static_cast<double>(lower) + 0.5 * static_cast<double>(width - 1);
+}
+
+void intervalHistogram::add(uint64_t interval)
+{
+	_buckets[bucketIndex(interval)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void intervalHistogram::clear()
+{
+	for(size_t i=0; i<HISTOGRAM_N_BUCKETS; ++i)
+		_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void intervalHistogram::addTo(std::vector<uint64_t> &merged) const
+{
+	if(merged.size() < HISTOGRAM_N_BUCKETS)
+		merged.resize(HISTOGRAM_N_BUCKETS, 0);
+
+	for(size_t i=0; i<HISTOGRAM_N_BUCKETS; ++i)
+		merged[i] += _buckets[i].load(std::memory_order_relaxed);
+}
+
+void intervalHistogram::copyFrom(const intervalHistogram &other)
+{
+	for(size_t i=0; i<HISTOGRAM_N_BUCKETS; ++i)
+		_buckets[i].store(other._buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+double intervalHistogram::quantile(const std::vector<uint64_t> &merged, double q)
+{
+	uint64_t total = 0;
+	for(size_t i=0; i<merged.size(); ++i)
+		total += merged[i];
+
+	if(total == 0)
+		return 0;
+
+	if(q < 0) q = 0;
+	if(q > 1) q = 1;
+
+	uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+	if(rank == 0)
+		rank = 1;
+
+	uint64_t cumulated = 0;
+	for(size_t i=0; i<merged.size(); ++i)
+	{
+		cumulated += merged[i];
+		if(cumulated >= rank)
+			return bucketValue(i);
+	}
+
+	return bucketValue(merged.size() - 1);
+}
@@ -2,6 +2,7 @@
 
 #include "sensorlogger.h"
 #include "logger.h"
+#include "trace.h"
 
 homematic::homematic(logger*root)
 {
@@ -25,6 +26,7 @@ std::string homematic::getXMLAPI_URL() const
 
 void homematic::publish(const std::string &iseID, const std::string &payload) const
 {
+	TRACE_SCOPE("homematic.publish", iseID);
 	if(_xmlAPI_URL.size() > 0)
 	{
 		std::string publishURL = _xmlAPI_URL + "/statechange.cgi?ise_id=" + iseID + "&new_value=" + payload;
@@ -109,6 +111,9 @@ std::string homematic::getValue(const std::string &iseID) const
 			if(e != E_CANNOT_READ_HM_SYSVAR)
 				_root->error("Cannot measure HomeMatic system variable with ISE ID " + iseID + ". Requested URL: " + getterURL);
 
+			if(e == E_HTTP_TIMEOUT)  // kept apart for the read statistics
+				throw e;
+
 			throw E_CANNOT_READ_HM_SYSVAR;
 		}
 	}
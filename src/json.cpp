@@ -1,5 +1,7 @@
 #include "json.h"
 
+#include <charconv>
+
 const char* intChain = "+-0123456789";
 const char* floatChain = "+-eE.0123456789";
 
@@ -48,6 +50,42 @@ bool isFloatInString(const std::string &s)
 	return true;
 }
 
+// Strips surrounding white space and a leading plus sign,
+// which std::from_chars does not accept.
+std::string_view trimNumber(std::string_view s)
+{
+	while((s.size() > 0) && isIn(s.front(), " \t\n\r"))
+		s.remove_prefix(1);
+
+	while((s.size() > 0) && isIn(s.back(), " \t\n\r"))
+		s.remove_suffix(1);
+
+	if((s.size() > 1) && (s.front() == '+'))
+		s.remove_prefix(1);
+
+	return s;
+}
+
+bool parseLong(std::string_view s, long &value)
+{
+	s = trimNumber(s);
+
+	const char* last = s.data() + s.size();
+	std::from_chars_result result = std::from_chars(s.data(), last, value);
+
+	return (result.ec == std::errc()) && (result.ptr == last);
+}
+
+bool parseDouble(std::string_view s, double &value)
+{
+	s = trimNumber(s);
+
+	const char* last = s.data() + s.size();
+	std::from_chars_result result = std::from_chars(s.data(), last, value);
+
+	return (result.ec == std::errc()) && (result.ptr == last);
+}
+
 
 jsonValue::jsonValue()
 {
@@ -122,8 +160,9 @@ long jsonValue::getInt() const
 
 	if(_type == jsonString)
 	{
-		if(isIntInString(_vString))
-			return atoi(_vString.c_str());
+		long v;
+		if(isIntInString(_vString) && parseLong(_vString, v))
+			return v;
 	}
 
 	throw E_VALUE_IS_NOT_INT;
@@ -147,8 +186,9 @@ double jsonValue::getDouble() const
 
 	if(_type == jsonString)
 	{
-		if(isFloatInString(_vString))
-			return atof(_vString.c_str());
+		double v;
+		if(isFloatInString(_vString) && parseDouble(_vString, v))
+			return v;
 	}
 
 	throw E_VALUE_IS_NOT_DOUBLE;
@@ -497,15 +537,15 @@ void jsonNode::parseObject(const std::string &content, size_t start, size_t stop
 							}
 							else // number
 							{
-								if(isIntInString(value))
+								long vInt;
+								double vDouble;
+								if(isIntInString(value) && parseLong(value, vInt))
 								{
-									long v = atoi(value.c_str());
-									newNode->value()->setInt(v);
+									newNode->value()->setInt(vInt);
 								}
-								else if(isFloatInString(value))
+								else if(isFloatInString(value) && parseDouble(value, vDouble))
 								{
-									double v = atof(value.c_str());
-									newNode->value()->setDouble(v);
+									newNode->value()->setDouble(vDouble);
 								}								
 							}
 
@@ -615,15 +655,15 @@ void jsonNode::parseArray(const std::string &content, size_t start, size_t stop)
 				}
 				else // number
 				{
-					if(isIntInString(value))
+					long vInt;
+					double vDouble;
+					if(isIntInString(value) && parseLong(value, vInt))
 					{
-						long v = atoi(value.c_str());
-						newNode->value()->setInt(v);
+						newNode->value()->setInt(vInt);
 					}
-					else if(isFloatInString(value))
+					else if(isFloatInString(value) && parseDouble(value, vDouble))
 					{
-						double v = atof(value.c_str());
-						newNode->value()->setDouble(v);
+						newNode->value()->setDouble(vDouble);
 					}
 				}
 
@@ -687,9 +727,9 @@ void json::parseFile(const std::string &filename)
 	parse();
 }
 
-void json::setContent(const std::string &content)
+void json::setContent(std::string_view content)
 {
-	_content = content;
+	_content.assign(content.data(), content.size());
 }
 
 void json::parse()
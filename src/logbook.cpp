@@ -7,6 +7,7 @@
 #include "mqttmanager.h"
 #include "homematic.h"
 #include "sensor.h"
+#include "trace.h"
 
 logbook::logbook(logger* root, const std::string &filename, uint64_t cycleTime, unsigned maxEntries, const std::string &missingDataToken)
 {
@@ -101,6 +102,10 @@ void logbook::setTimestampForNextLogEntry()
 	_timestamp_next_logentry = lastLogentry + _cycleTime;
 }
 
+uint64_t logbook::getTimestampForNextLogEntry() const
+{
+	return _timestamp_next_logentry;
+}
 
 void logbook::write(mqttManager* brokers, homematic* hm)
 {
@@ -108,6 +113,8 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 
 	if(currentTimestamp >= _timestamp_next_logentry)
 	{
+		TRACE_SCOPE("logbook.write", _filename);
+
 		// Round to full multiple of the logbook's cycle time:
 		uint64_t currentTimeSlot = currentTimestamp - (currentTimestamp % _cycleTime);
 
@@ -117,6 +124,7 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 
 		for(size_t i=0; i<_cols.size(); ++i)
 		{
+			TRACE_SCOPE("column", _cols.at(i)->getTitle());
 			std::string colValue = _missingDataToken;
 			try	{
 				uint64_t startTimestamp = currentTimeSlot - _cols.at(i)->getEvaluationPeriod();
@@ -128,7 +136,7 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 			if(colValue != _missingDataToken)
 			{
 				// Publish this result to MQTT Broker?
-				if(_cols.at(i)->getMQTTPublishTopic().size() > 0)
+				if((brokers != NULL) && (_cols.at(i)->getMQTTPublishTopic().size() > 0))
 				{
 					try
 					{
@@ -141,7 +149,7 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 				}
 
 				// Publish this result to Homematic?
-				if(_cols.at(i)->getHomematicPublishISE().size() > 0)
+				if((hm != NULL) && (_cols.at(i)->getHomematicPublishISE().size() > 0))
 				{
 					try
 					{
@@ -158,17 +166,15 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 		// If a logbook file is supposed to be written:
 		if(_filename.size() > 0)
 		{
-			// Get current time:
-			std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+			// Time of this entry (the logger's time, which is the journal's time during a replay):
+			std::time_t now = static_cast<std::time_t>(currentTimestamp / 1000);
 			struct tm *timeinfo;
 			timeinfo = std::localtime(&now);
-			
-			int y	   = timeinfo->tm_year + 1900;
-			int d 	   = timeinfo->tm_mday;
-			int m	   = timeinfo->tm_mon + 1;
-			int h	   = timeinfo->tm_hour;
-			int minute = timeinfo->tm_min;
-			int s      = timeinfo->tm_sec;
+
+			char timeString[64];
+			snprintf(timeString, sizeof(timeString), "%04d-%02d-%02d %02d:%02d:%02d",
+				timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, timeinfo->tm_mday,
+				timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
 
 			// Read existing log values:
 			std::ifstream existingLog;
@@ -231,22 +237,15 @@ void logbook::write(mqttManager* brokers, homematic* hm)
 
 
 				// Create new line for current cycle:
-				std::stringstream dateStream;
-				dateStream << y;
-				dateStream << "-" << std::setfill('0') << std::setw(2) << m;
-				dateStream << "-" << std::setfill('0') << std::setw(2) << d;
-				dateStream << " " << std::setfill('0') << std::setw(2) << h;
-				dateStream << ":" << std::setfill('0') << std::setw(2) << minute;
-				dateStream << ":" << std::setfill('0') << std::setw(2) << s;
-
-				logwrite << dateStream.str();
+				_line.assign(timeString);
 
 				for(size_t i=0; i<columnValues.size(); ++i)
 				{
-					logwrite << "\t";			
-					logwrite << columnValues.at(i);
+					_line += '\t';
+					_line += columnValues.at(i);
 				}
 
+				logwrite << _line;
 				logwrite << std::endl;
 				logwrite.close();
 			}
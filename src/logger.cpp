@@ -14,6 +14,14 @@
 #include "column.h"
 #include "logbook.h"
 #include "json.h"
+#include "logwriter.h"
+#include "checkpoint.h"
+#include "samplejournal.h"
+#include "workerpool.h"
+#include "metrics.h"
+#include "trace.h"
+
+#include <algorithm>
 
 size_t receiveHTTP(void* buffer, size_t size, size_t nmemb, void* userp)
 {
@@ -24,18 +32,15 @@ size_t receiveHTTP(void* buffer, size_t size, size_t nmemb, void* userp)
 
 logger::logger()
 {
-	_max_tinkerforge_read_failures  = DEFAULT_MAX_BRICKLET_READ_FAILURES;
-	_max_brickd_restart_attempts    = DEFAULT_MAX_BRICKD_RESTART_ATTEMPTS;
-	_brickd_restart_attempt_counter = 0;
-
 	_verbose = true;
 	_logLevel = loglevel_info;
+	_logWriter = new logWriter();
 
 	_default_rest_period = DEFAULT_MEASUREMENT_INTERVAL;
 	_default_retry_time  = DEFAULT_RETRY_TIME;
 
 	#ifdef OPTION_TINKERFORGE
-		_tfDaemon    = new tinkerforge(this);
+		_tfDaemonPool = NULL;
 	#endif
 
 	_mqttManager = new mqttManager();
@@ -46,15 +51,47 @@ logger::logger()
 		_curl = curl_easy_init();
 	#endif
 	_http_timeout = DEFAULT_HTTP_TIMEOUT;
+	_memoryLimit  = 0;
+	_checkpoint   = new checkpoint();
+	_journal      = new sampleJournal();
+
+	_telemetryInterval = DEFAULT_TELEMETRY_INTERVAL;
+	_timestamp_lastTelemetry = 0;
+
+	_metrics = NULL;
+	_metricsAddress = DEFAULT_METRICS_ADDRESS;
+	_metricsPort = 0;
+	_metricsInterval = DEFAULT_METRICS_INTERVAL;
+	_timestamp_lastMetrics = 0;
+
+	#ifdef OPTION_TRACE
+		_traceFile = DEFAULT_TRACE_FILE;
+	#endif
+
+	_clock      = &_systemClock;
+	_replayMode = false;
 
 	_rBuffer = new readoutBuffer(this);
 }
 
 logger::~logger()
 {
+	if(_checkpoint != NULL)
+	{
+		_checkpoint->flush(_sensors, currentTimestamp());
+		delete _checkpoint;
+	}
+
+	// Sensor callbacks might still add samples until the sensors are deleted.
+	if(_journal != NULL)
+		_journal->stop();
+
 	for(size_t i=0; i<_sensors.size(); ++i)
 		delete _sensors.at(i);
 
+	if(_journal != NULL)
+		delete _journal;
+
 	if(_mqttManager != NULL)
 		delete _mqttManager;
 
@@ -62,10 +99,17 @@ logger::~logger()
 		delete _rBuffer;
 	
 	#ifdef OPTION_TINKERFORGE
-		if(_tfDaemon != NULL)
-			delete _tfDaemon;
+		if(_tfDaemonPool != NULL)
+			delete _tfDaemonPool;
+
+		for(size_t i=0; i<_tfDaemons.size(); ++i)
+			delete _tfDaemons.at(i);
 	#endif
 
+	// After the Tinkerforge callbacks have stopped counting samples:
+	if(_metrics != NULL)
+		delete _metrics;
+
 	if(_homematic != NULL)
 		delete _homematic;
 
@@ -75,6 +119,10 @@ logger::~logger()
 
 		curl_global_cleanup();
 	#endif
+
+	// Last, so that messages from the destructors above are still written.
+	if(_logWriter != NULL)
+		delete _logWriter;
 }
 
 void logger::debug(const std::string &debug_message)
@@ -111,51 +159,17 @@ void logger::error(const std::string &error_message)
 
 void logger::message(const std::string &m, bool isError)
 {
-	if(m != _lastLogfileMessage)
+	if(_verbose)
 	{
-		_lastLogfileMessage = ""; //m;
-
-		if(_verbose)
-		{
-			if(isError)
-				std::cerr << m << std::endl;
-			else
-				std::cout << m << std::endl;
-		}
-
-		if(_logFilename.length() > 0)
-		{
-			time_t rawtime;
-			struct tm * timeinfo;
-			time(&rawtime);
-			timeinfo = localtime(&rawtime);
-
-			int year    = timeinfo->tm_year + 1900;
-			int day     = timeinfo->tm_mday;
-			int month   = timeinfo->tm_mon + 1;
-			int hour    = timeinfo->tm_hour;
-			int minute 	= timeinfo->tm_min;
-			int second  = timeinfo->tm_sec;
-
-			std::ofstream outfile;
-			outfile.open(_logFilename, std::ios_base::app);
-			if(outfile.is_open())
-			{
-				outfile << std::setfill('0') << std::setw(2) << year << "-";
-				outfile << std::setfill('0') << std::setw(2) << month << "-";
-				outfile << std::setfill('0') << std::setw(2) << day <<" ";
-				outfile << std::setfill('0') << std::setw(2) << hour << ":";
-				outfile << std::setfill('0') << std::setw(2) << minute << ":";
-				outfile << std::setfill('0') << std::setw(2) << second << " > ";
-				outfile << m << std::endl;
-				outfile.close();
-			}
-			else
-			{
-				std::cerr << "Cannot open logfile to write: " << _logFilename << std::endl;
-			}			
-		}
+		if(isError)
+			std::cerr << m << std::endl;
+		else
+			std::cout << m << std::endl;
 	}
+
+	// The log file is written in the background; errors are written right away.
+	if(_logFilename.length() > 0)
+		_logWriter->write(m, isError);
 }
 
 std::string logger::logLevelString()
@@ -171,6 +185,11 @@ std::string logger::logLevelString()
 	return "unknown";
 }
 
+void logger::setVerbose(bool verbose)
+{
+	_verbose = verbose;
+}
+
 void logger::welcomeMessage(const std::string &configJSON)
 {
 	message("---", false);
@@ -179,6 +198,79 @@ void logger::welcomeMessage(const std::string &configJSON)
 	message("  Logfile: " + logfileState(), false);
 }
 
+#ifdef OPTION_TINKERFORGE
+void logger::addTinkerforgeDaemon(jsonNode* daemonNode)
+{
+	tinkerforge* daemon = new tinkerforge(this);
+
+	try {
+		daemon->setHost(daemonNode->element("host")->value()->getString());
+	} catch(int e) { }
+
+	try {
+		daemon->setPort(static_cast<unsigned short>(daemonNode->element("port")->value()->getInt()));
+	} catch(int e) { }
+
+	try {
+		daemon->setName(daemonNode->element("name")->value()->getString());
+	} catch(int e) { }
+
+	if(tinkerforgeDaemon(daemon->getName()) != NULL)
+	{
+		error("Tinkerforge Brick Daemon \'" + daemon->getName() + "\' is defined more than once. Only the first definition is used.");
+		delete daemon;
+		return;
+	}
+
+	debug("Tinkerforge daemon: " + daemon->getName());
+	debug("Tinkerforge Host: " + daemon->getHost());
+	debug("Tinkerforge Port: " + std::to_string(daemon->getPort()));
+
+	try {
+		daemon->setMaxReadFailures(static_cast<unsigned>(daemonNode->element("max_bricklet_read_failures")->value()->getInt()));
+	} catch(int e) { }
+	debug("Tinkerforge max_bricklet_read_failures: " + std::to_string(daemon->getMaxReadFailures()));
+
+	try {
+		daemon->setMaxRestartAttempts(static_cast<unsigned>(daemonNode->element("max_brickd_restart_attempts")->value()->getInt()));
+	} catch(int e) { }
+	debug("Tinkerforge max_brickd_restart_attempts: " + std::to_string(daemon->getMaxRestartAttempts()));
+
+	try {
+		daemon->setRestartCommand(daemonNode->element("brickd_restart_command")->value()->getString());
+	} catch(int e) { }
+	debug("Tinkerforge brickd_restart_command: " + daemon->getRestartCommand());
+
+	try {
+		daemon->setSystemRestartCommand(daemonNode->element("system_restart_command")->value()->getString());
+	} catch(int e) { }
+	debug("Tinkerforge system_restart_command: " + daemon->getSystemRestartCommand());
+
+	try {
+		daemon->setEnumerationTimeout(daemonNode->element("enumeration_timeout")->durationInMS());
+	} catch(int e) { }
+	debug("Tinkerforge enumeration_timeout: " + std::to_string(daemon->getEnumerationTimeout()) + " ms");
+
+	try {
+		daemon->setPollThreads(static_cast<unsigned>(daemonNode->element("poll_threads")->value()->getInt()));
+	} catch(int e) { }
+	debug("Tinkerforge poll_threads: " + std::to_string(daemon->getPollThreads()));
+
+	_tfDaemons.push_back(daemon);
+}
+
+tinkerforge* logger::tinkerforgeDaemon(const std::string &name)
+{
+	for(size_t i=0; i<_tfDaemons.size(); ++i)
+	{
+		if(_tfDaemons.at(i)->getName() == name)
+			return _tfDaemons.at(i);
+	}
+
+	return NULL;
+}
+#endif
+
 void logger::loadConfig(const std::string &configJSON)
 {
 	json configFile;
@@ -189,6 +281,7 @@ void logger::loadConfig(const std::string &configJSON)
 		// General configuration
 		try	{
 			_logFilename = configFile.element("general")->element("logfile")->value()->getString();
+			_logWriter->setFile(_logFilename);
 			welcomeMessage(configJSON);
 		}
 		catch(int e) {
@@ -223,6 +316,24 @@ void logger::loadConfig(const std::string &configJSON)
 		}
 		debug("Log Level: " + logLevelString());
 
+		if(_logFilename.length() > 0)
+		{
+			uint64_t logfileMaxSize = DEFAULT_LOGFILE_MAX_SIZE;
+			try	{
+				logfileMaxSize = static_cast<uint64_t>(configFile.element("general")->element("logfile_max_size")->value()->getDouble() * 1048576.0);
+			}
+			catch(int e) { }
+
+			unsigned logfileRotations = DEFAULT_LOGFILE_ROTATIONS;
+			try	{
+				logfileRotations = static_cast<unsigned>(configFile.element("general")->element("logfile_rotations")->value()->getInt());
+			}
+			catch(int e) { }
+
+			_logWriter->setRotation(logfileMaxSize, logfileRotations);
+			_logWriter->start();
+		}
+
 		try	{
 			_http_timeout = static_cast<long>(configFile.element("general")->element("http_timeout")->value()->getInt());
 		}
@@ -247,6 +358,91 @@ void logger::loadConfig(const std::string &configJSON)
 		}
 		debug("Default retry time: " + std::to_string(_default_retry_time) + " ms");
 
+		try	{
+			_memoryLimit = static_cast<uint64_t>(configFile.element("general")->element("memory_limit")->value()->getDouble() * 1048576.0);
+		}
+		catch(int e) {
+			_memoryLimit = 0;
+		}
+
+		// A replay must not overwrite the checkpoint of the running Sensorlogger.
+		if(!_replayMode)
+		{
+			try	{
+				_checkpoint->setFile(configFile.element("general")->element("checkpoint_file")->value()->getString());
+			}
+			catch(int e) { }
+		}
+
+		try	{
+			_checkpoint->setInterval(configFile.element("general")->element("checkpoint_interval")->durationInMS());
+		}
+		catch(int e) {
+			_checkpoint->setInterval(DEFAULT_CHECKPOINT_INTERVAL);
+		}
+
+		try	{
+			_journal->setPath(configFile.element("general")->element("journal_path")->value()->getString());
+		}
+		catch(int e) { }
+
+		try	{
+			_journal->setSegmentSize(static_cast<uint64_t>(configFile.element("general")->element("journal_segment_size")->value()->getDouble() * 1048576.0));
+		}
+		catch(int e) { }
+
+		try	{
+			_journal->setMaxSegments(static_cast<unsigned>(configFile.element("general")->element("journal_max_segments")->value()->getInt()));
+		}
+		catch(int e) { }
+
+		try	{
+			_telemetryInterval = configFile.element("general")->element("telemetry_interval")->durationInMS();
+		}
+		catch(int e) {
+			_telemetryInterval = DEFAULT_TELEMETRY_INTERVAL;
+		}
+
+		try	{
+			_telemetryTopic = configFile.element("general")->element("telemetry_topic")->value()->getString();
+		}
+		catch(int e) { }
+
+		try	{
+			_metricsPort = static_cast<unsigned short>(configFile.element("general")->element("metrics_port")->value()->getInt());
+		}
+		catch(int e) { }
+
+		try	{
+			_metricsAddress = configFile.element("general")->element("metrics_address")->value()->getString();
+		}
+		catch(int e) { }
+
+		try	{
+			_metricsTopic = configFile.element("general")->element("metrics_topic")->value()->getString();
+		}
+		catch(int e) { }
+
+		try	{
+			_metricsInterval = configFile.element("general")->element("metrics_interval")->durationInMS();
+		}
+		catch(int e) {
+			_metricsInterval = DEFAULT_METRICS_INTERVAL;
+		}
+
+		#ifdef OPTION_TRACE
+			try	{
+				_traceFile = configFile.element("general")->element("trace_file")->value()->getString();
+			}
+			catch(int e) { }
+		#endif
+
+		bool defaultCompression = false;
+		try	{
+			defaultCompression = configFile.element("general")->element("compress_measurements")->value()->getBool();
+		}
+		catch(int e) { }
+
 		// Homematic configuration
 		if(configFile.existAndNotNull("homematic"))
 		{
@@ -259,56 +455,42 @@ void logger::loadConfig(const std::string &configJSON)
 		}
 		debug("Homematic xmlapi_url: " + _homematic->getXMLAPI_URL());
 
-		// Tinkerforge configuration
+		// Tinkerforge configuration: one Brick Daemon or an array of them.
 		if(configFile.existAndNotNull("tinkerforge"))
 		{
-			if(configFile.element("tinkerforge")->existAndNotNull("host"))
+			jsonNode* tfNode = configFile.element("tinkerforge");
+			size_t nDaemons = 1;
+
+			if(!tfNode->existAndNotNull("host"))
 			{
-				#ifdef OPTION_TINKERFORGE
-					try {
-						_tfDaemon->setHost(configFile.element("tinkerforge")->element("host")->value()->getString());
-					} catch(int e) { }
-
-					try {
-						_tfDaemon->setPort(static_cast<unsigned short>(configFile.element("tinkerforge")->element("port")->value()->getInt()));
-					} catch(int e) { }
-				#else
-					error("Cannot set up Tinkerforge connection. This version of Sensorlogger was compiled without Tinkerforge support.");
-				#endif
+				// This might be a JSON array that defines multiple Brick Daemons.
+				nDaemons = tfNode->nElements();
 			}
-		}
 
-		#ifdef OPTION_TINKERFORGE
-			debug("Tinkerforge Host: " + _tfDaemon->getHost());
-			debug("Tinkerforge Port: " + std::to_string(_tfDaemon->getPort()));
-
-			try {
-				_max_tinkerforge_read_failures = configFile.element("tinkerforge")->element("max_bricklet_read_failures")->value()->getInt();
-			} catch(int e) {
-				_max_tinkerforge_read_failures = DEFAULT_MAX_BRICKLET_READ_FAILURES;
-			}
-			debug("Tinkerforge max_bricklet_read_failures: " + std::to_string(_max_tinkerforge_read_failures));
+			for(size_t d=0; d<nDaemons; ++d)
+			{
+				jsonNode* daemonNode = tfNode;
+				if(!tfNode->existAndNotNull("host"))
+					daemonNode = tfNode->element(d);
 
-			try {
-				_max_brickd_restart_attempts = configFile.element("tinkerforge")->element("max_brickd_restart_attempts")->value()->getInt();
-			} catch(int e) {
-				_max_brickd_restart_attempts = DEFAULT_MAX_BRICKD_RESTART_ATTEMPTS;
+				if(daemonNode->existAndNotNull("host"))
+				{
+					#ifdef OPTION_TINKERFORGE
+						addTinkerforgeDaemon(daemonNode);
+					#else
+						error("Cannot set up Tinkerforge connection. This version of Sensorlogger was compiled without Tinkerforge support.");
+					#endif
+				}
 			}
-			debug("Tinkerforge max_brickd_restart_attempts: " + std::to_string(_max_brickd_restart_attempts));
+		}
 
-			try {
-				_cmd_readFailures = configFile.element("tinkerforge")->element("brickd_restart_command")->value()->getString();
-			} catch(int e) {
-				_cmd_readFailures = "";
-			}
-			debug("Tinkerforge brickd_restart_command: " + _cmd_readFailures);
+		#ifdef OPTION_TINKERFORGE
+			// Sensors always need a daemon, even if it cannot connect:
+			if(_tfDaemons.size() == 0)
+				_tfDaemons.push_back(new tinkerforge(this));
 
-			try {
-				_cmd_readFailures_critical = configFile.element("tinkerforge")->element("system_restart_command")->value()->getString();
-			} catch(int e) {
-				_cmd_readFailures_critical = "";
-			}
-			debug("Tinkerforge system_restart_command: " + _cmd_readFailures_critical);
+			if(_tfDaemons.size() > 1)
+				_tfDaemonPool = new workerPool(static_cast<unsigned>(_tfDaemons.size()));
 		#endif
 
 
@@ -339,6 +521,8 @@ void logger::loadConfig(const std::string &configJSON)
 							char ioPort = 'a';
 							trigger_event triggerEvent = periodic;
 							uint32_t io_debounce_ms = DEFAULT_DEBOUNCE_TIME;
+							unsigned tf_averaging = 0;
+							unsigned tf_sampleRate = 0;
 						#endif
 
 						bool isCounter = false;
@@ -397,6 +581,11 @@ void logger::loadConfig(const std::string &configJSON)
 							tinkerforge_uid = s->element("tinkerforge_uid")->value()->getString();
 						} catch(int e) {}
 
+						std::string tinkerforge_daemon;
+						try {
+							tinkerforge_daemon = s->element("tinkerforge_daemon")->value()->getString();
+						} catch(int e) {}
+
 						#ifdef OPTION_TINKERFORGE
 							try {
 								channel = static_cast<uint8_t>(s->element("channel")->value()->getInt());
@@ -444,6 +633,18 @@ void logger::loadConfig(const std::string &configJSON)
 							try {
 								io_debounce_ms = static_cast<uint32_t>(s->element("io_debounce")->durationInMS());
 							} catch(int e) {}
+
+							try {
+								int averaging = s->element("averaging")->value()->getInt();
+								if(averaging > 0)
+									tf_averaging = static_cast<unsigned>(averaging);
+							} catch(int e) {}
+
+							try {
+								int sampleRate = s->element("sample_rate")->value()->getInt();
+								if(sampleRate > 0)
+									tf_sampleRate = static_cast<unsigned>(sampleRate);
+							} catch(int e) {}
 						#endif
 
 						try {
@@ -478,6 +679,24 @@ void logger::loadConfig(const std::string &configJSON)
 						{
 						}
 
+						bool compressMeasurements = defaultCompression;
+						try {
+							compressMeasurements = s->element("compress")->value()->getBool();
+						} catch(int e) {}
+
+						numberFormat sensorFormat;
+						try {
+							std::string decimals = s->element("decimals")->value()->getString();
+							if(!sensorFormat.setFromString(decimals))
+							{
+								std::stringstream ss;
+								ss << "Sensor " << (i+1) << " (" << sensorID << "): \'" << decimals << "\' is not a valid number of decimals.";
+								error(ss.str());
+							}
+						} catch(int e) {}
+
+						size_t nSensorsBefore = _sensors.size();
+
 						if(sensorJSONfile.size() > 0)  // Create a JSON sensor
 						{
 							sensorJSON* jsonSensor = new sensorJSON(this, sensorID, mqttPublishTopic, homematicPublishISE, sensorJSONfile, &sensorJSONkeys, isCounter, sensorFactor, sensorOffset, sensorMinimumRestPeriod, sensorRetryTime, _rBuffer);
@@ -486,8 +705,31 @@ void logger::loadConfig(const std::string &configJSON)
 						else if(tinkerforge_uid.size() > 0)
 						{
 							#ifdef OPTION_TINKERFORGE
-								sensorTinkerforge* tfSensor = new sensorTinkerforge(this, sensorID, mqttPublishTopic, homematicPublishISE, _tfDaemon, tinkerforge_uid, triggerEvent, isCounter, channel, ioPort, io_debounce_ms, sensorFactor, sensorOffset, sensorMinimumRestPeriod, sensorRetryTime);
+								// Bound to a daemon by name; without a name, the UID decides
+								// if there is more than one daemon.
+								tinkerforge* tfDaemon = NULL;
+								if(tinkerforge_daemon.size() > 0)
+								{
+									tfDaemon = tinkerforgeDaemon(tinkerforge_daemon);
+									if(tfDaemon == NULL)
+									{
+										error("Sensor \'" + sensorID + "\': unknown Tinkerforge Brick Daemon \'" + tinkerforge_daemon + "\'.");
+										continue;
+									}
+								}
+								else if(_tfDaemons.size() == 1)
+									tfDaemon = _tfDaemons.at(0);
+
+								sensorTinkerforge* tfSensor = new sensorTinkerforge(this, sensorID, mqttPublishTopic, homematicPublishISE, tfDaemon, tinkerforge_uid, triggerEvent, isCounter, channel, ioPort, io_debounce_ms, sensorFactor, sensorOffset, sensorMinimumRestPeriod, sensorRetryTime);
+								tfSensor->setAveraging(tf_averaging);
+								tfSensor->setSampleRate(tf_sampleRate);
 								_sensors.push_back(tfSensor);
+
+								for(size_t d=0; d<_tfDaemons.size(); ++d)
+								{
+									if((tfDaemon == NULL) || (tfDaemon == _tfDaemons.at(d)))
+										_tfDaemons.at(d)->addSensor(tfSensor);
+								}
 							#else
 								error("Cannot add Tinkerforge sensor. This version of Sensorlogger was compiled without support for Tinkerforge.");
 							#endif
@@ -506,6 +748,12 @@ void logger::loadConfig(const std::string &configJSON)
 							sensorHomematic* homematicSensor = new sensorHomematic(this, _homematic, sensorID, mqttPublishTopic, homematicPublishISE, homematicSubscribeISE, isCounter, sensorFactor, sensorOffset, sensorMinimumRestPeriod, sensorRetryTime);
 							_sensors.push_back(homematicSensor);
 						}
+
+						if(_sensors.size() > nSensorsBefore)
+						{
+							_sensors.back()->setNumberFormat(sensorFormat);
+							_sensors.back()->setCompression(compressMeasurements);
+						}
 					}
 					catch(int e)
 					{
@@ -630,6 +878,8 @@ void logger::loadConfig(const std::string &configJSON)
 										else if(colOpString == "freq")          {colOp = freq;}
 										else if(colOpString == "freq_min")      {colOp = freq_min;}
 										else if(colOpString == "freq_max")      {colOp = freq_max;}
+										else if(colOpString == "freq_percentile") {colOp = freq_percentile;}
+										else if(colOpString == "gust_factor")   {colOp = gust_factor;}
 										else if(colOpString == "stddev")        {colOp = stdDevMean;}
 										else if(colOpString == "stddev_mean")   {colOp = stdDevMean;}
 										else if(colOpString == "stddev_median") {colOp = stdDevMedian;}
@@ -670,7 +920,25 @@ void logger::loadConfig(const std::string &configJSON)
 										colHomematicPublishISE = currentCol->element("homematic_publish")->value()->getString();
 									} catch(int e) {}
 
+									double percentile = (colOp == gust_factor) ? DEFAULT_GUST_PERCENTILE : DEFAULT_FREQ_PERCENTILE;
+									try {
+										percentile = currentCol->element("percentile")->value()->getDouble();
+									} catch(int e) {}
+
+									numberFormat colFormat;
+									try {
+										std::string decimals = currentCol->element("decimals")->value()->getString();
+										if(!colFormat.setFromString(decimals))
+										{
+											std::stringstream ss;
+											ss << "Error in configuration for logbook #" << (i+1) << ", column #" << (c+1) <<": \'" << decimals << "\' is not a valid number of decimals.";
+											error(ss.str());
+										}
+									} catch(int e) {}
+
 									column* newColumn = new column(colSensor, l, title, unit, evaluationPeriod, colOp, confidenceAbsolute, confidenceSigma, colMqttPublishTopic, colHomematicPublishISE, countFactor);
+									newColumn->setNumberFormat(colFormat);
+									newColumn->setPercentile(percentile);
 									l->addColumn(newColumn);
 								}
 								catch(int e)
@@ -702,6 +970,25 @@ void logger::loadConfig(const std::string &configJSON)
 			}
 		}
 
+		// The logbook columns define how long measurements have to be kept:
+		planMeasurementMemory();
+
+		if(_journal->enabled() && !_replayMode)
+		{
+			_journal->setSensors(_sensors);
+			_journal->start();
+			info("Writing raw sample journal to " + _journal->getPath());
+		}
+
+		// Warm restart from the last checkpoint:
+		if(_checkpoint->enabled())
+		{
+			uint64_t current = currentTimestamp();
+			size_t nRestored = _checkpoint->restore(_sensors, current);
+			info("Restored " + std::to_string(nRestored) + " measurements from the checkpoint file.");
+			_checkpoint->start();
+		}
+
 		// MQTT Configuration:
 		if(configFile.existAndNotNull("mqtt"))
 		{
@@ -765,6 +1052,48 @@ void logger::loadConfig(const std::string &configJSON)
 								
 							}
 
+							unsigned mqttMaxQueueSize = DEFAULT_MQTT_MAX_QUEUE_SIZE;
+							try
+							{
+								mqttMaxQueueSize = static_cast<unsigned>(mqttNode->element("max_queue_size")->value()->getInt());
+							}
+							catch(int e) { }
+
+							double mqttMaxPublishRate = DEFAULT_MQTT_MAX_PUBLISH_RATE;
+							try
+							{
+								mqttMaxPublishRate = mqttNode->element("max_publish_rate")->value()->getDouble();
+							}
+							catch(int e) { }
+
+							unsigned mqttMaxInFlight = DEFAULT_MQTT_MAX_INFLIGHT;
+							try
+							{
+								mqttMaxInFlight = static_cast<unsigned>(mqttNode->element("max_inflight")->value()->getInt());
+							}
+							catch(int e) { }
+
+							unsigned mqttSpoolSize = DEFAULT_MQTT_SPOOL_SIZE;
+							try
+							{
+								mqttSpoolSize = static_cast<unsigned>(mqttNode->element("spool_size")->value()->getInt());
+							}
+							catch(int e) { }
+
+							std::string mqttSpoolFile;
+							try
+							{
+								mqttSpoolFile = mqttNode->element("spool_file")->value()->getString();
+							}
+							catch(int e) { }
+
+							double mqttSpoolReplayRate = DEFAULT_MQTT_SPOOL_REPLAY_RATE;
+							try
+							{
+								mqttSpoolReplayRate = mqttNode->element("spool_replay_rate")->value()->getDouble();
+							}
+							catch(int e) { }
+
 							bool mqttSubscribeEnabled = true;
 							try
 							{
@@ -825,6 +1154,12 @@ void logger::loadConfig(const std::string &configJSON)
 								b->enablePublish(mqttPublishEnabled);
 								b->enableSubscribe(mqttSubscribeEnabled);
 								b->setTopicDomain(mqtt_topic_domain);
+								b->setMaxQueueSize(mqttMaxQueueSize);
+								b->setMaxPublishRate(mqttMaxPublishRate);
+								b->setMaxInFlight(mqttMaxInFlight);
+								b->setSpoolSize(mqttSpoolSize);
+								b->setSpoolFile(mqttSpoolFile);
+								b->setSpoolReplayRate(mqttSpoolReplayRate);
 
 								_mqttManager->addBroker(b);
 							}
@@ -853,6 +1188,62 @@ void logger::loadConfig(const std::string &configJSON)
 	}
 }
 
+// Sets the capacity of each sensor's measurement storage, such that the longest
+// evaluation period fits. With a memory limit, the available memory is shared
+// fairly: sensors that need less than an equal share get what they need,
+// the rest is split evenly among the others.
+void logger::planMeasurementMemory()
+{
+	std::vector<size_t> order;
+	for(size_t i=0; i<_sensors.size(); ++i)
+		order.push_back(i);
+
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return (_sensors.at(a)->requiredCapacity() * _sensors.at(a)->bytesPerMeasurement()) < (_sensors.at(b)->requiredCapacity() * _sensors.at(b)->bytesPerMeasurement());
+	});
+
+	uint64_t remaining = _memoryLimit;  // bytes
+	for(size_t k=0; k<order.size(); ++k)
+	{
+		sensor* s = _sensors.at(order.at(k));
+		size_t capacity = s->requiredCapacity();
+
+		if(_memoryLimit > 0)
+		{
+			uint64_t share = remaining / (order.size() - k);
+			if(static_cast<uint64_t>(capacity) * s->bytesPerMeasurement() > share)
+			{
+				capacity = static_cast<size_t>(share / s->bytesPerMeasurement());
+
+				std::stringstream ss;
+				ss << "Memory limit: sensor " << s->getSensorID() << " can only keep " << capacity << " of " << s->requiredCapacity() << " measurements.";
+				warning(ss.str());
+			}
+
+			remaining -= std::min(remaining, static_cast<uint64_t>(capacity) * s->bytesPerMeasurement());
+		}
+
+		s->setCapacity(capacity);
+	}
+
+	// Startup report:
+	size_t total = 0;
+	for(size_t i=0; i<_sensors.size(); ++i)
+	{
+		std::stringstream ss;
+		ss << "Sensor " << _sensors.at(i)->getSensorID() << ": up to " << _sensors.at(i)->getCapacity() << " measurements, " << (_sensors.at(i)->plannedMemory() + 1023) / 1024 << " kB";
+		info(ss.str());
+
+		total += _sensors.at(i)->plannedMemory();
+	}
+
+	std::stringstream ss;
+	ss << "Planned memory for measurements: " << (total + 1023) / 1024 << " kB";
+	if(_memoryLimit > 0)
+		ss << " (limit for raw measurements: " << _memoryLimit / 1024 << " kB)";
+	info(ss.str());
+}
+
 std::string logger::getLogFilename() const
 {
 	return _logFilename;
@@ -897,14 +1288,22 @@ sensor* logger::getSensor(size_t n)
 
 uint64_t logger::currentTimestamp() const
 {
-	const auto now = std::chrono::system_clock::now();
-	uint64_t timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count());
+	return _clock->now();
+}
 
-	return timestamp;
+uint64_t logger::monotonicTimestamp() const
+{
+	return _clock->monotonic();
+}
+
+void logger::setClock(loggerClock* clock)
+{
+	_clock = clock;
 }
 
 std::string logger::httpRequest(const std::string url)
 {
+	TRACE_SCOPE("http", url);
 	#ifdef OPTION_CURL
 		if(_curl)
 		{
@@ -928,6 +1327,9 @@ std::string logger::httpRequest(const std::string url)
 				std::string easyReadError = curl_easy_strerror(res);
 				error("HTTP(S) request failed: " + easyReadError);
 
+				if(res == CURLE_OPERATION_TIMEDOUT)
+					throw E_HTTP_TIMEOUT;
+
 				throw E_HTTP_REQUEST_FAILED;
 			}
 
@@ -941,9 +1343,329 @@ std::string logger::httpRequest(const std::string url)
 	#endif
 }
 
+// Sensors that have never been read (event-driven ones) are left out.
+void logger::reportTelemetry(uint64_t currentTimestamp)
+{
+	if(_telemetryInterval == 0)
+		return;
+
+	if(_timestamp_lastTelemetry == 0)
+	{
+		_timestamp_lastTelemetry = currentTimestamp;
+		return;
+	}
+
+	if(timeDiff(currentTimestamp, _timestamp_lastTelemetry) < _telemetryInterval)
+		return;
+
+	readReport r;
+	for(size_t i=0; i<_sensors.size(); ++i)
+	{
+		sensor* s = _sensors.at(i);
+		if(s->telemetry()->nReads() == 0)
+			continue;
+
+		s->telemetry()->report(r);
+		r.nTruncated = s->nTruncated();
+		debug("Sensor " + s->getSensorID() + ": " + r.summary());
+
+		if(_telemetryTopic.size() > 0)
+			mqttPublish(_telemetryTopic + "/" + s->getSensorID(), r.json());
+	}
+
+	_timestamp_lastTelemetry = currentTimestamp;
+}
+
+void logger::recordSample(const sensor* s, uint64_t timestamp, double value)
+{
+	if(!_replayMode)
+		_journal->add(s, timestamp, value);
+}
+
+void logger::setReplayMode()
+{
+	_replayMode = true;
+	setClock(&_replayClock);
+}
+
+// Returns the number of logbook entries written.
+size_t logger::writeReplayLogbooks()
+{
+	size_t nEntries = 0;
+	for(size_t i=0; i<_logbooks.size(); ++i)
+	{
+		uint64_t next = _logbooks.at(i)->getTimestampForNextLogEntry();
+		_logbooks.at(i)->write(NULL, NULL);
+
+		if(_logbooks.at(i)->getTimestampForNextLogEntry() != next)
+			++nEntries;
+	}
+
+	return nEntries;
+}
+
+// Writes all logbook entries that are due before the given time.
+size_t logger::replayLogbooksUntil(uint64_t timestamp)
+{
+	size_t nEntries = 0;
+	while(_logbooks.size() > 0)
+	{
+		uint64_t next = _logbooks.at(0)->getTimestampForNextLogEntry();
+		for(size_t i=1; i<_logbooks.size(); ++i)
+			next = std::min(next, _logbooks.at(i)->getTimestampForNextLogEntry());
+
+		if(next >= timestamp)
+			break;
+
+		_replayClock.set(next);
+		nEntries += writeReplayLogbooks();
+	}
+
+	_replayClock.set(timestamp);
+	return nEntries;
+}
+
+/* Feeds all samples of a journal (directory of segments or a single segment)
+   or of CSV files to the sensors, in the order in which they were recorded,
+   and writes the logbook entries as if Sensorlogger had been running at
+   that time. Nothing is published to MQTT or HomeMatic.
+   Returns the number of samples. */
+uint64_t logger::replay(const std::string &journalPath)
+{
+	std::string path = journalPath;
+	if(path.size() == 0)
+		path = _journal->getPath();
+
+	std::vector<std::string> files = sampleJournal::segmentFiles(path);
+	if(files.size() == 0)
+	{
+		error("No journal found at \'" + path + "\'.");
+		return 0;
+	}
+
+	uint64_t nReplayed = 0;
+	uint64_t nSkipped  = 0;  // unknown sensors
+	uint64_t nBackward = 0;  // older than an earlier file's samples
+	uint64_t nEntries  = 0;
+	uint64_t lastTimestamp = 0;
+	bool started = false;
+
+	std::vector<std::string> sensorIDs;
+	std::vector<journalSample> samples;
+	std::vector<sensor*> fileSensors;
+
+	const auto replayStart = std::chrono::steady_clock::now();
+
+	for(size_t f=0; f<files.size(); ++f)
+	{
+		bool valid;
+		if(sampleJournal::isCSV(files.at(f)))
+			valid = sampleJournal::readCSV(files.at(f), sensorIDs, samples);
+		else
+			valid = sampleJournal::readSegment(files.at(f), sensorIDs, samples);
+
+		if(!valid)
+		{
+			warning("Cannot read journal file " + files.at(f));
+			continue;
+		}
+
+		// The virtual clock must not run backwards: samples of a file are
+		// replayed in time order, and samples that are older than those of
+		// an earlier file are left out.
+		std::stable_sort(samples.begin(), samples.end(), [](const journalSample &a, const journalSample &b) {
+			return a.timestamp < b.timestamp;
+		});
+
+		// Sensors are identified by their ID, the configuration may have changed:
+		fileSensors.assign(sensorIDs.size(), NULL);
+		for(size_t i=0; i<sensorIDs.size(); ++i)
+		{
+			try {
+				fileSensors.at(i) = getSensor(sensorIDs.at(i));
+			} catch(int e) { }
+		}
+
+		for(size_t i=0; i<samples.size(); ++i)
+		{
+			sensor* s = fileSensors.at(samples.at(i).sensorIndex);
+			if(s == NULL)
+			{
+				++nSkipped;
+				continue;
+			}
+
+			uint64_t timestamp = samples.at(i).timestamp;
+			if(started && (timestamp < lastTimestamp))
+			{
+				++nBackward;
+				continue;
+			}
+
+			lastTimestamp = timestamp;
+			if(!started)
+			{
+				// The logbooks and counters start with the journal's time:
+				_replayClock.set(timestamp);
+				for(size_t l=0; l<_logbooks.size(); ++l)
+					_logbooks.at(l)->setTimestampForNextLogEntry();
+
+				for(size_t k=0; k<_sensors.size(); ++k)
+					_sensors.at(k)->resetCounters();
+
+				started = true;
+			}
+
+			nEntries += replayLogbooksUntil(timestamp);
+			s->addRawMeasurement(samples.at(i).value, timestamp);
+			++nReplayed;
+
+			nEntries += writeReplayLogbooks();
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+
+	std::stringstream report;
+	report << "Replayed " << nReplayed << " samples from " << files.size() << " files and wrote " << nEntries << " logbook entries in " << std::fixed << std::setprecision(3) << seconds << " s";
+	if(seconds > 0)
+		report << " (" << std::setprecision(0) << (static_cast<double>(nReplayed) / seconds) << " samples/s)";
+	report << ".";
+	info(report.str());
+
+	if(nSkipped > 0)
+		warning(std::to_string(nSkipped) + " samples belong to sensors that are not configured.");
+
+	if(nBackward > 0)
+		warning(std::to_string(nBackward) + " samples were skipped because they are older than the samples of an earlier file.");
+
+	return nReplayed;
+}
+
 void logger::setUpConnections()
 {
 	_mqttManager->connectToMQTTBrokers();
+	setUpMetrics();
+
+	#ifdef OPTION_TRACE
+		tracer::installSignalHandler();
+		info("Tracing: send SIGUSR1 to write the latest events to " + _traceFile);
+	#endif
+}
+
+#ifdef OPTION_TRACE
+void logger::dumpTrace()
+{
+	size_t nEvents = tracer::dump(_traceFile);
+	if(nEvents > 0)
+		info("Wrote " + std::to_string(nEvents) + " trace events to " + _traceFile);
+	else
+		error("Cannot write trace file " + _traceFile);
+}
+#endif
+
+// All metrics are created here, before the endpoint is started.
+void logger::setUpMetrics()
+{
+	if((_metricsPort == 0) && (_metricsTopic.size() == 0))
+		return;
+
+	_metrics = new metricsRegistry();
+
+	_metricTrigger = _metrics->newHistogram("sensorlogger_trigger_duration_seconds", "Duration of a trigger cycle.");
+
+	const char* stageNames[N_TRIGGER_STAGES] = {"tinkerforge", "measure", "logbooks", "mqtt", "checkpoint"};
+	for(size_t i=0; i<N_TRIGGER_STAGES; ++i)
+		_metricStage[i] = _metrics->newHistogram("sensorlogger_stage_duration_seconds", "Duration of the stages of a trigger cycle.", "stage", stageNames[i]);
+
+	for(size_t i=0; i<_sensors.size(); ++i)
+	{
+		sensor* s = _sensors.at(i);
+		s->setSampleMetric(_metrics->newCounter("sensorlogger_sensor_samples_total", "Samples accepted by the sensor.", "sensor", s->getSensorID()));
+		_metricSensorMeasurements.push_back(_metrics->newGauge("sensorlogger_sensor_measurements", "Measurements held in memory.", "sensor", s->getSensorID()));
+		_metricSensorMemory.push_back(_metrics->newGauge("sensorlogger_sensor_memory_bytes", "Memory used for the sensor's measurements and rollups.", "sensor", s->getSensorID()));
+		_metricSensorReadFailures.push_back(_metrics->newGauge("sensorlogger_sensor_read_failures", "Consecutive read failures.", "sensor", s->getSensorID()));
+		_metricSensorTruncated.push_back(_metrics->newCounter("sensorlogger_sensor_truncated_total", "Measurements dropped because the capacity was reached.", "sensor", s->getSensorID()));
+	}
+
+	_metricJournalBuffered = _metrics->newGauge("sensorlogger_journal_buffered", "Samples waiting to be written to the journal.");
+	_metricJournalLost     = _metrics->newCounter("sensorlogger_journal_lost_total", "Samples that could not be written to the journal.");
+
+	#ifdef OPTION_MQTT
+		for(size_t i=0; i<_mqttManager->nBrokers(); ++i)
+		{
+			mqttBroker* b = _mqttManager->getBroker(i);
+			std::string name = b->getHost() + ":" + std::to_string(b->getPort());
+			_metricMQTTQueued.push_back(_metrics->newGauge("sensorlogger_mqtt_queued", "Messages in the publish queue.", "broker", name));
+			_metricMQTTSpooled.push_back(_metrics->newGauge("sensorlogger_mqtt_spooled", "Messages spooled while disconnected.", "broker", name));
+			_metricMQTTInFlight.push_back(_metrics->newGauge("sensorlogger_mqtt_inflight", "Published messages waiting for acknowledgement.", "broker", name));
+			_metricMQTTPublished.push_back(_metrics->newCounter("sensorlogger_mqtt_published_total", "Messages published.", "broker", name));
+			_metricMQTTCoalesced.push_back(_metrics->newCounter("sensorlogger_mqtt_coalesced_total", "Queued messages replaced by a newer message for the same topic.", "broker", name));
+			_metricMQTTDropped.push_back(_metrics->newCounter("sensorlogger_mqtt_dropped_total", "Messages dropped because the queue was full.", "broker", name));
+		}
+	#endif
+
+	if(_metricsPort > 0)
+	{
+		if(_metrics->start(_metricsAddress, _metricsPort))
+			info("Metrics available at http://" + _metricsAddress + ":" + std::to_string(_metricsPort) + "/metrics");
+		else
+			error("Cannot serve metrics at " + _metricsAddress + ":" + std::to_string(_metricsPort) + ".");
+	}
+}
+
+void logger::stageFinished(trigger_stage stage, uint64_t &stageStart)
+{
+	if(_metrics != NULL)
+	{
+		uint64_t now = monotonicTimestamp();
+		_metricStage[stage]->observe(timeDiff(now, stageStart));
+		stageStart = now;
+	}
+}
+
+// Gauges are taken from the main thread, the exporter only reads them.
+void logger::updateMetrics(uint64_t currentTimestamp, uint64_t triggerStart)
+{
+	if(_metrics == NULL)
+		return;
+
+	_metricTrigger->observe(timeDiff(monotonicTimestamp(), triggerStart));
+
+	for(size_t i=0; i<_sensors.size(); ++i)
+	{
+		const sensor* s = _sensors.at(i);
+		_metricSensorMeasurements.at(i)->set(static_cast<double>(s->nMeasurements()));
+		_metricSensorMemory.at(i)->set(static_cast<double>(s->memoryUsage()));
+		_metricSensorReadFailures.at(i)->set(static_cast<double>(s->getReadFailures()));
+		_metricSensorTruncated.at(i)->set(s->nTruncated());
+	}
+
+	_metricJournalBuffered->set(static_cast<double>(_journal->nBuffered()));
+
+	#ifdef OPTION_MQTT
+		for(size_t i=0; i<_metricMQTTQueued.size(); ++i)
+		{
+			const mqttBroker* b = _mqttManager->getBroker(i);
+			_metricMQTTQueued.at(i)->set(static_cast<double>(b->nQueued()));
+			_metricMQTTSpooled.at(i)->set(static_cast<double>(b->nSpooled()));
+			_metricMQTTInFlight.at(i)->set(static_cast<double>(b->nInFlight()));
+			_metricMQTTPublished.at(i)->set(b->nPublished());
+			_metricMQTTCoalesced.at(i)->set(b->nCoalesced());
+			_metricMQTTDropped.at(i)->set(b->nDropped());
+		}
+	#endif
+
+	if(_metricsTopic.size() > 0)
+	{
+		if(_timestamp_lastMetrics == 0)
+			_timestamp_lastMetrics = currentTimestamp;
+		else if(timeDiff(currentTimestamp, _timestamp_lastMetrics) >= _metricsInterval)
+		{
+			mqttPublish(_metricsTopic, _metrics->json());
+			_timestamp_lastMetrics = currentTimestamp;
+		}
+	}
 }
 
 void logger::executeSystemCommand(const std::string &command)
@@ -986,14 +1708,126 @@ void logger::homematicPublish(const std::string &iseID, const std::string &paylo
 		_homematic->publish(iseID, payload);
 }
 
+#ifdef OPTION_TINKERFORGE
+void logger::checkBrickDaemon(tinkerforge* daemon, uint64_t current)
+{
+	daemon->updateRecovery(current);
+	if(daemon->recovering())
+		return;
+
+	size_t nSensorsFailedTooMuch = 0;
+	for(size_t i=0; i<_sensors.size(); ++i)
+	{
+		if(_sensors.at(i)->type() == sensor_tinkerforge)
+		{
+			sensorTinkerforge* s = dynamic_cast<sensorTinkerforge*>(_sensors.at(i));
+			if((s->getDaemon() == daemon) && (s->getReadFailures() > 0))
+			{
+				if(s->getReadFailures() >= daemon->getMaxReadFailures())
+				{
+					if(nSensorsFailedTooMuch == 0)
+					{
+						error("Too many Tinkerforge Bricklet read failures at " + daemon->getName() + ":");
+					}
+
+					std::stringstream ss;
+					ss << "  Bricklet \'" << s->getUID() << "\' ("<< getDeviceType_name(s->getDeviceType()) << "): " << s->getReadFailures() << " read failures.";
+					error(ss.str());
+
+					++nSensorsFailedTooMuch;
+				}
+			}
+		}
+	}
+
+	if(nSensorsFailedTooMuch > 0)
+	{
+		// Reset the read failures of all sensors at this daemon:
+		for(size_t i=0; i<_sensors.size(); ++i)
+		{
+			if((_sensors.at(i)->type() == sensor_tinkerforge) && (dynamic_cast<sensorTinkerforge*>(_sensors.at(i))->getDaemon() == daemon))
+				_sensors.at(i)->resetReadFailures();
+		}
+
+		// The commands run in the background; the other sensors and the logbooks go on.
+		if(daemon->restartAttempts() >= daemon->getMaxRestartAttempts())
+		{
+			daemon->resetRestartAttempts();
+			
+			if(daemon->getSystemRestartCommand().size() > 0)
+			{
+				error("Trying to reboot the entire system...");
+				_checkpoint->flush(_sensors, current);
+				daemon->startRecovery(daemon->getSystemRestartCommand(), true, current);
+			}
+
+			return;
+		}
+
+		if(daemon->getRestartCommand().size() > 0)
+		{
+			error("Trying to restart Brick Daemon " + daemon->getName() + " (attempt " + std::to_string(daemon->restartAttempts() + 1) + ")...");
+			daemon->startRecovery(daemon->getRestartCommand(), false, current);
+		}
+	}
+}
+#endif
+
 void logger::trigger()
 {
+	#ifdef OPTION_TRACE
+		if(tracer::dumpRequested())
+			dumpTrace();
+	#endif
+
+	TRACE_SCOPE("trigger");
 	uint64_t current = currentTimestamp();
 	_rBuffer->cleanUp(current);
 
+	uint64_t triggerStart = 0;
+	if(_metrics != NULL)
+		triggerStart = monotonicTimestamp();
+	uint64_t stageStart = triggerStart;
+
+	#ifdef OPTION_TINKERFORGE
+		// Periodic Tinkerforge sensors are polled concurrently, and all Brick Daemons in parallel:
+		std::vector<std::vector<sensorTinkerforge*> > tfMeasured(_tfDaemons.size());
+		std::function<void(size_t)> pollDaemon = [&](size_t d)
+		{
+			_tfDaemons.at(d)->pollSensors(current, tfMeasured.at(d));
+		};
+
+		if(_tfDaemonPool != NULL)
+			_tfDaemonPool->run(_tfDaemons.size(), pollDaemon);
+		else if(_tfDaemons.size() > 0)
+			pollDaemon(0);
+
+		for(size_t d=0; d<tfMeasured.size(); ++d)
+		{
+			for(size_t i=0; i<tfMeasured.at(d).size(); ++i)
+			{
+				try
+				{
+					tfMeasured.at(d).at(i)->publishLastEvent();
+				}
+				catch(int e)
+				{
+				}
+			}
+		}
+
+		stageFinished(stage_tinkerforge, stageStart);
+	#endif
+
 	for(size_t i=0; i<_sensors.size(); ++i)
 	{
 		sensor* s = _sensors.at(i);
+
+		#ifdef OPTION_TINKERFORGE
+			if((s->type() == sensor_tinkerforge) && (s->getTriggerEvent() == periodic))
+				continue;
+		#endif
+
 		try
 		{
 			if(s->measure(current))
@@ -1011,6 +1845,7 @@ void logger::trigger()
 			std::cerr<<"Error "<<e<<" when measuring at sensor #"<<(i+1)<<"."<<std::endl;
 		}
 	}
+	stageFinished(stage_measure, stageStart);
 
 	for(size_t i=0; i<_logbooks.size(); ++i)
 	{
@@ -1022,61 +1857,30 @@ void logger::trigger()
 			std::cerr<<"Error "<<e<<" when writing logbook "<<(i+1)<<"."<<std::endl;
 		}
 	}
+	stageFinished(stage_logbooks, stageStart);
 
-	#ifdef OPTION_TINKERFORGE
-		// Check if a restart of the Tinkerforge Brick Daemon might be necessary:
-		size_t nSensorsFailedTooMuch = 0;
-		for(size_t i=0; i<_sensors.size(); ++i)
-		{
-			if(_sensors.at(i)->type() == sensor_tinkerforge)
-			{
-				sensorTinkerforge* s = dynamic_cast<sensorTinkerforge*>(_sensors.at(i));
-				if(s->getReadFailures() > 0)
-				{
-					if(s->getReadFailures() >= _max_tinkerforge_read_failures)
-					{
-						if(nSensorsFailedTooMuch == 0)
-						{
-							error("Too many Tinkerforge Bricklet read failures:");
-						}
-
-						std::stringstream ss;
-						ss << "  Bricklet \'" << s->getUID() << "\' ("<< getDeviceType_name(s->getDeviceType()) << "): " << s->getReadFailures() << " read failures.";
-						error(ss.str());
+	_mqttManager->processQueues(current);
+	stageFinished(stage_mqtt, stageStart);
 
-						++nSensorsFailedTooMuch;
-					}
-				}
-			}
-		}
+	if(_checkpoint->update(_sensors, current) > 0)
+		error("Failed to write checkpoint file.");
+	stageFinished(stage_checkpoint, stageStart);
 
-		if(nSensorsFailedTooMuch > 0)
-		{
-			// Reset all sensor read failures:
-			for(size_t i=0; i<_sensors.size(); ++i)
-				_sensors.at(i)->resetReadFailures();
+	uint64_t nJournalLost = _journal->nLost();
+	if(nJournalLost > 0)
+	{
+		warning(std::to_string(nJournalLost) + " samples could not be written to the journal.");
+		if(_metrics != NULL)
+			_metricJournalLost->add(nJournalLost);
+	}
 
-			if(_brickd_restart_attempt_counter >= _max_brickd_restart_attempts)
-			{
-				_brickd_restart_attempt_counter = 0;
-				
-				if(_cmd_readFailures_critical.size() > 0)
-				{
-					error("Trying to reboot the entire system...");
-					executeSystemCommand(_cmd_readFailures_critical);
-					std::this_thread::sleep_for(std::chrono::seconds(2));
-				}
+	reportTelemetry(current);
 
-				return;
-			}
-
-			if(_cmd_readFailures.size() > 0)
-			{
-				error("Trying to restart Brick Daemon...");
-				executeSystemCommand(_cmd_readFailures);
-				++_brickd_restart_attempt_counter;
-				std::this_thread::sleep_for(std::chrono::seconds(30));
-			}
-		}
+	#ifdef OPTION_TINKERFORGE
+		// Check if a restart of a Tinkerforge Brick Daemon might be necessary:
+		for(size_t d=0; d<_tfDaemons.size(); ++d)
+			checkBrickDaemon(_tfDaemons.at(d), current);
 	#endif
+
+	updateMetrics(current, triggerStart);
 }
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "logwriter.h"
+
+#include "sensorlogger.h"
+
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+
+logWriter::logWriter()
+{
+	_file          = NULL;
+	_maxFileSize   = DEFAULT_LOGFILE_MAX_SIZE;
+	_nRotations    = DEFAULT_LOGFILE_ROTATIONS;
+	_flushInterval = DEFAULT_LOGFILE_FLUSH_INTERVAL;
+
+	_head  = 0;
+	_count = 0;
+	_nOverwritten = 0;
+	_buffer.resize(DEFAULT_LOG_BUFFER_SIZE);
+
+	_lastSweep = 0;
+
+	_thread = NULL;
+	_stop   = false;
+}
+
+logWriter::~logWriter()
+{
+	stop();
+}
+
+void logWriter::setFile(const std::string &filename)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	closeFile();
+	_filename = filename;
+}
+
+void logWriter::setRotation(uint64_t maxFileSize, unsigned nRotations)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_maxFileSize = maxFileSize;
+	_nRotations  = nRotations;
+}
+
+void logWriter::setFlushInterval(uint64_t flushInterval)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_flushInterval = std::max(flushInterval, static_cast<uint64_t>(10));
+}
+
+void logWriter::setBufferSize(size_t nLines)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Only before anything has been buffered:
+	if(_count == 0)
+	{
+		_buffer.resize(std::max(nLines, static_cast<size_t>(16)));
+		_head = 0;
+	}
+}
+
+void logWriter::start()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(_thread == NULL)
+	{
+		_stop   = false;
+		_thread = new std::thread(&logWriter::run, this);
+	}
+}
+
+void logWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(_thread == NULL)
+			return;
+
+		flushRepetitions(std::time(NULL), true);
+		_stop = true;
+	}
+
+	_wakeUp.notify_one();
+	_thread->join();
+	delete _thread;
+	_thread = NULL;
+
+	closeFile();
+}
+
+// Called with locked mutex.
+void logWriter::enqueue(std::time_t time, const std::string &text)
+{
+	size_t pos;
+	if(_count < _buffer.size())
+	{
+		pos = (_head + _count) % _buffer.size();
+		++_count;
+	}
+	else
+	{
+		// Buffer full: overwrite the oldest line.
+		pos   = _head;
+		_head = (_head + 1) % _buffer.size();
+		++_nOverwritten;
+	}
+
+	_buffer[pos].time = time;
+	_buffer[pos].text = text;
+}
+
+// Called with locked mutex. Summarizes the repetitions of messages
+// whose interval is over (or of all messages) and forgets messages
+// that have not been repeated.
+void logWriter::flushRepetitions(std::time_t now, bool all)
+{
+	if(!all && (now == _lastSweep))
+		return;
+
+	_lastSweep = now;
+
+	for(std::unordered_map<std::string, repeatState>::iterator it = _repeats.begin(); it != _repeats.end(); )
+	{
+		if(all || ((now - it->second.timeWritten) >= LOG_REPEAT_INTERVAL))
+		{
+			if(it->second.nSuppressed > 0)
+			{
+				enqueue(now, "Message repeated " + std::to_string(it->second.nSuppressed) + " times: " + it->first);
+
+				// A series that goes on is summarized again after the next interval:
+				it->second.timeWritten = now;
+				it->second.nSuppressed = 0;
+				++it;
+				continue;
+			}
+
+			it = _repeats.erase(it);
+			continue;
+		}
+
+		++it;
+	}
+}
+
+void logWriter::write(const std::string &text, bool urgent)
+{
+	std::time_t now = std::time(NULL);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		flushRepetitions(now, false);
+
+		std::unordered_map<std::string, repeatState>::iterator it = _repeats.find(text);
+		if(it != _repeats.end())
+		{
+			++(it->second.nSuppressed);
+			return;
+		}
+
+		enqueue(now, text);
+
+		if(_repeats.size() < LOG_REPEAT_MAX_TEXTS)
+		{
+			repeatState r;
+			r.timeWritten = now;
+			r.nSuppressed = 0;
+			_repeats[text] = r;
+		}
+
+		if(_thread == NULL)
+		{
+			// Writer not running (yet): write directly.
+			while(_count > 0)
+			{
+				writeLine(_buffer[_head]);
+				_head = (_head + 1) % _buffer.size();
+				--_count;
+			}
+
+			if(_file != NULL)
+				fflush(_file);
+
+			return;
+		}
+	}
+
+	if(urgent)
+		_wakeUp.notify_one();
+}
+
+void logWriter::run()
+{
+	std::vector<logLine> lines;
+	uint64_t nOverwritten = 0;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(true)
+	{
+		_wakeUp.wait_for(lock, std::chrono::milliseconds(_flushInterval));
+
+		// Summaries are due even if no new messages arrive:
+		if(!_stop)
+			flushRepetitions(std::time(NULL), false);
+
+		// Take all buffered lines and write them without holding the lock:
+		lines.clear();
+		while(_count > 0)
+		{
+			lines.push_back(std::move(_buffer[_head]));
+			_head = (_head + 1) % _buffer.size();
+			--_count;
+		}
+
+		nOverwritten  = _nOverwritten;
+		_nOverwritten = 0;
+		bool stopNow  = _stop;
+
+		lock.unlock();
+
+		if(nOverwritten > 0)
+		{
+			logLine lost;
+			lost.time = std::time(NULL);
+			lost.text = "Warning: log buffer full, " + std::to_string(nOverwritten) + " messages were lost.";
+			writeLine(lost);
+		}
+
+		for(size_t i=0; i<lines.size(); ++i)
+			writeLine(lines[i]);
+
+		if(_file != NULL)
+			fflush(_file);
+
+		lock.lock();
+
+		if(stopNow && (_count == 0))
+			break;
+	}
+}
+
+bool logWriter::openFile()
+{
+	if((_file == NULL) && (_filename.size() > 0))
+	{
+		_file = fopen(_filename.c_str(), "a");
+		if(_file == NULL)
+			std::cerr << "Cannot open logfile to write: " << _filename << std::endl;
+	}
+
+	return (_file != NULL);
+}
+
+void logWriter::closeFile()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		_file = NULL;
+	}
+}
+
+void logWriter::rotate()
+{
+	closeFile();
+
+	if(_nRotations == 0)
+	{
+		remove(_filename.c_str());
+		return;
+	}
+
+	// sensorlogger.log.2 -> sensorlogger.log.3, ...
+	for(unsigned i=_nRotations; i>1; --i)
+	{
+		std::string older = _filename + "." + std::to_string(i);
+		std::string newer = _filename + "." + std::to_string(i-1);
+		rename(newer.c_str(), older.c_str());
+	}
+
+	std::string first = _filename + ".1";
+	rename(_filename.c_str(), first.c_str());
+}
+
+void logWriter::writeLine(const logLine &line)
+{
+	if(!openFile())
+		return;
+
+	struct tm timeinfo;
+	localtime_r(&line.time, &timeinfo);
+
+	char timeString[64];
+	snprintf(timeString, sizeof(timeString), "%04d-%02d-%02d %02d:%02d:%02d > ",
+		timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+		timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+
+	fputs(timeString, _file);
+	fputs(line.text.c_str(), _file);
+	fputc('\n', _file);
+
+	if(_maxFileSize > 0)
+	{
+		long fileSize = ftell(_file);
+		if((fileSize > 0) && (static_cast<uint64_t>(fileSize) >= _maxFileSize))
+			rotate();
+	}
+}
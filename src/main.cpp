@@ -1,18 +1,75 @@
 #include <string>
 #include <thread>
+#include <csignal>
+#include <cstring>
 #include "logger.h"
 
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signal)
+{
+	stopRequested = 1;
+}
+
+// SIGTERM (e.g. from systemd) and SIGINT end the measurement loop, so that
+// the logger's destructor writes the last checkpoint, the journal buffer,
+// the log file and the MQTT spool. A second signal ends the process at once.
+static void installStopHandlers()
+{
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = requestStop;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESETHAND;
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGINT, &action, NULL);
+}
+
 int main(int argc, char const *argv[])
 {
 	std::string configFile = "sensorlogger.json";
 
-	if(argc > 1)
+	// sensorlogger [config file] [--replay [journal]]
+	bool replay = false;
+	std::string journalPath;
+
+	for(int i=1; i<argc; ++i)
 	{
-		configFile = argv[1];
+		std::string arg = argv[i];
+		if(arg == "--replay")
+		{
+			replay = true;
+			if((i+1) < argc)
+				journalPath = argv[++i];
+		}
+		else
+		{
+			configFile = arg;
+		}
 	}
 
 	logger me;
 
+	if(replay)
+	{
+		me.setReplayMode();
+
+		try
+		{
+			me.loadConfig(configFile);
+		}
+		catch(int e)
+		{
+			std::cerr<<"Error: "<<e<<std::endl;
+			return e;
+		}
+
+		if(me.replay(journalPath) == 0)
+			return 1;
+
+		return 0;
+	}
+
 	// Start up and read configuration:
 	try
 	{		
@@ -25,12 +82,15 @@ int main(int argc, char const *argv[])
 		return e;
 	}
 
-	// Infinite measurement loop
-	while(true)
+	installStopHandlers();
+
+	// Measurement loop, until Sensorlogger is stopped:
+	while(stopRequested == 0)
 	{
 		me.trigger();
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
 
+	me.info("Stopping Sensorlogger.");
 	return 0;
 }
\ No newline at end of file
@@ -10,9 +10,29 @@ uint64_t timeDiff(uint64_t timestamp1, uint64_t timestamp2)
 }
 
 
+uint64_t rollupPeriod(rollupTier tier)
+{
+	switch(tier)
+	{
+		case(rollup_minute): return 60000;
+		case(rollup_hour):   return 3600000;
+		case(rollup_none):   break;
+	}
+
+	return 0;
+}
+
 measurements::measurements()
 {
 	_minimumRestPeriod = 0;
+	_capacity   = DEFAULT_MAX_MEASUREMENTS;
+	_nTruncated = 0;
+	_compress   = false;
+	_nInBlocks  = 0;
+	_earliestToKeep = 0;
+
+	for(size_t t=0; t<N_ROLLUP_TIERS; ++t)
+		_rollupTimeToKeep[t] = 0;
 }
 
 measurements::~measurements()
@@ -25,6 +45,80 @@ void measurements::setMinimumRestPeriod(uint64_t ms)
 	_minimumRestPeriod = ms;
 }
 
+void measurements::setCapacity(size_t capacity)
+{
+	_capacity = std::max(capacity, static_cast<size_t>(1));
+}
+
+size_t measurements::getCapacity() const
+{
+	return _capacity;
+}
+
+uint64_t measurements::nTruncated() const
+{
+	return _nTruncated;
+}
+
+void measurements::setCompression(bool compress)
+{
+	_compress = compress;
+}
+
+bool measurements::getCompression() const
+{
+	return _compress;
+}
+
+size_t measurements::bytesPerMeasurement() const
+{
+	if(_compress)
+		return COMPRESSED_MEASUREMENT_SIZE;
+
+	return MEASUREMENT_SIZE;
+}
+
+size_t measurements::memoryUsage() const
+{
+	size_t bytes = _values.size() * MEASUREMENT_SIZE;
+	for(size_t i=0; i<_blocks.size(); ++i)
+		bytes += _blocks[i].memory();
+
+	return bytes;
+}
+
+// Compresses the oldest uncompressed values into a new block.
+void measurements::sealBlock()
+{
+	_blocks.push_back(sampleBlock());
+	_blocks.back().encode(_timestamps, _values, SAMPLEBLOCK_SIZE);
+	_nInBlocks += SAMPLEBLOCK_SIZE;
+
+	_values.erase(_values.begin(), _values.begin() + SAMPLEBLOCK_SIZE);
+	_timestamps.erase(_timestamps.begin(), _timestamps.begin() + SAMPLEBLOCK_SIZE);
+}
+
+// Re-encodes the front block without its expired values.
+void measurements::trimFrontBlock()
+{
+	std::vector<double> values;
+	std::vector<uint64_t> timestamps;
+	_blocks.front().decode(_earliestToKeep - 1, values, &timestamps);
+
+	_nInBlocks -= _blocks.front().count();
+	_blocks.pop_front();
+
+	if(values.size() > 0)
+	{
+		std::deque<double> blockValues(values.begin(), values.end());
+		std::deque<uint64_t> blockTimestamps(timestamps.begin(), timestamps.end());
+
+		_blocks.push_front(sampleBlock());
+		_blocks.front().encode(blockTimestamps, blockValues, values.size());
+		_nInBlocks += values.size();
+	}
+}
+
 void measurements::addValue(double value, uint64_t timestamp)
 {
 	// Obey minimum rest time:
@@ -34,15 +128,39 @@ void measurements::addValue(double value, uint64_t timestamp)
 
 	if(timeDiff(timestamp, lastTimeStamp) >= _minimumRestPeriod)
 	{
-		_values.push_back(value);
-		_timestamps.push_back(timestamp);
+		appendValue(value, timestamp);
+		addToRollups(value, timestamp);
 	}
+}
 
-	// Keep only up to MAX_MEASUREMENTS values in memory to avoid overflow:
-	while(_values.size() > MAX_MEASUREMENTS)
+void measurements::appendValue(double value, uint64_t timestamp)
+{
+	_values.push_back(value);
+	_timestamps.push_back(timestamp);
+
+	if(_compress && (_values.size() >= 2*SAMPLEBLOCK_SIZE))
+		sealBlock();
+
+	// Keep only up to the sensor's capacity in memory to avoid overflow:
+	while((_nInBlocks + _values.size()) > _capacity)
 	{
-		_values.erase(_values.begin());
-		_timestamps.erase(_timestamps.begin());
+		if((_blocks.size() > 0) && (_blocks.front().firstTimestamp() < _earliestToKeep))
+		{
+			// Expired values must not push out values that are still needed:
+			trimFrontBlock();
+		}
+		else if(_blocks.size() > 0)
+		{
+			_nInBlocks  -= _blocks.front().count();
+			_nTruncated += _blocks.front().count();
+			_blocks.pop_front();
+		}
+		else
+		{
+			_values.pop_front();
+			_timestamps.pop_front();
+			++_nTruncated;
+		}
 	}
 }
 
@@ -67,14 +185,20 @@ void measurements::setOnlyValue(double value, uint64_t timestamp)
 
 void measurements::clean(uint64_t earliest_timestamp_to_keep)
 {
-	for(int i=0; i<static_cast<int>(_values.size()); ++i)
+	_earliestToKeep = earliest_timestamp_to_keep;
+
+	// Blocks are removed once all of their values have expired.
+	while((_blocks.size() > 0) && (_blocks.front().lastTimestamp() < earliest_timestamp_to_keep))
 	{
-		if(_timestamps.at(i) < earliest_timestamp_to_keep)
-		{
-			_values.erase(_values.begin()+i);
-			_timestamps.erase(_timestamps.begin()+i);
-			--i;
-		}
+		_nInBlocks -= _blocks.front().count();
+		_blocks.pop_front();
+	}
+
+	// Values are stored in chronological order:
+	while((_timestamps.size() > 0) && (_timestamps.front() < earliest_timestamp_to_keep))
+	{
+		_values.pop_front();
+		_timestamps.pop_front();
 	}
 }
 
@@ -82,11 +206,185 @@ void measurements::clear()
 {
 	_values.clear();
 	_timestamps.clear();
+	_blocks.clear();
+	_nInBlocks = 0;
+
+	for(size_t t=0; t<N_ROLLUP_TIERS; ++t)
+		_rollups[t].clear();
+}
+
+void measurements::accumulateRollupTimeToKeep(rollupTier tier, uint64_t timeToKeep)
+{
+	if(tier == rollup_none)
+		return;
+
+	if(_rollupTimeToKeep[tier] < timeToKeep)
+		_rollupTimeToKeep[tier] = timeToKeep;
+}
+
+void measurements::addToRollups(double value, uint64_t timestamp)
+{
+	for(size_t t=0; t<N_ROLLUP_TIERS; ++t)
+	{
+		if(_rollupTimeToKeep[t] == 0)
+			continue;
+
+		uint64_t period = rollupPeriod(static_cast<rollupTier>(t));
+		uint64_t end = ((timestamp + period - 1) / period) * period;
+
+		std::deque<rollup> &tier = _rollups[t];
+		if((tier.size() > 0) && (tier.back().end == end))
+		{
+			rollup &r = tier.back();
+			++r.count;
+			r.sum   += value;
+			r.sumsq += value*value;
+			r.min    = std::min(r.min, value);
+			r.max    = std::max(r.max, value);
+		}
+		else
+		{
+			rollup r;
+			r.end   = end;
+			r.count = 1;
+			r.sum   = value;
+			r.sumsq = value*value;
+			r.min   = value;
+			r.max   = value;
+			tier.push_back(r);
+		}
+	}
+}
+
+void measurements::cleanRollups(uint64_t currentTimestamp)
+{
+	for(size_t t=0; t<N_ROLLUP_TIERS; ++t)
+	{
+		// One extra period, because evaluations start at the beginning of a logbook cycle:
+		uint64_t keep = _rollupTimeToKeep[t] + rollupPeriod(static_cast<rollupTier>(t));
+
+		while((_rollups[t].size() > 0) && ((_rollups[t].front().end + keep) <= currentTimestamp))
+			_rollups[t].pop_front();
+	}
+}
+
+uint64_t measurements::getLastTimestamp() const
+{
+	if(_timestamps.size() > 0)
+		return _timestamps.back();
+
+	if(_blocks.size() > 0)
+		return _blocks.back().lastTimestamp();
+
+	return 0;
+}
+
+void measurements::valuesSince(uint64_t startTimestamp, std::vector<uint64_t> &timestamps, std::vector<double> &values) const
+{
+	for(size_t b=0; b<_blocks.size(); ++b)
+	{
+		if(_blocks[b].lastTimestamp() > startTimestamp)
+			_blocks[b].decode(startTimestamp, values, &timestamps);
+	}
+
+	for(size_t i=0; i<_values.size(); ++i)
+	{
+		if(_timestamps[i] > startTimestamp)
+		{
+			timestamps.push_back(_timestamps[i]);
+			values.push_back(_values[i]);
+		}
+	}
+}
+
+// Rollups that have received values after startTimestamp (including the open ones).
+void measurements::rollupsSince(rollupTier tier, uint64_t startTimestamp, std::vector<rollup> &rollups) const
+{
+	if(tier == rollup_none)
+		return;
+
+	uint64_t period = rollupPeriod(tier);
+	for(size_t i=0; i<_rollups[tier].size(); ++i)
+	{
+		if((_rollups[tier][i].end + period) > startTimestamp)
+			rollups.push_back(_rollups[tier][i]);
+	}
+}
+
+// Restored values keep their order; anything not newer than the last value is ignored.
+void measurements::restoreValue(double value, uint64_t timestamp)
+{
+	if(timestamp > getLastTimestamp())
+		appendValue(value, timestamp);
+}
+
+void measurements::restoreRollup(rollupTier tier, const rollup &r)
+{
+	if((tier == rollup_none) || (_rollupTimeToKeep[tier] == 0))
+		return;
+
+	std::deque<rollup> &rollups = _rollups[tier];
+	if((rollups.size() > 0) && (rollups.back().end == r.end))
+		rollups.back() = r;  // newer snapshot of the same period
+	else if((rollups.size() == 0) || (rollups.back().end < r.end))
+		rollups.push_back(r);
+}
+
+size_t measurements::plannedRollupMemory() const
+{
+	size_t bytes = 0;
+	for(size_t t=0; t<N_ROLLUP_TIERS; ++t)
+	{
+		if(_rollupTimeToKeep[t] > 0)
+		{
+			uint64_t period = rollupPeriod(static_cast<rollupTier>(t));
+			bytes += static_cast<size_t>(_rollupTimeToKeep[t] / period + 2) * sizeof(rollup);
+		}
+	}
+
+	return bytes;
+}
+
+rollup measurements::rollupStatistics(rollupTier tier, uint64_t startTimestamp) const
+{
+	rollup total;
+	total.end   = 0;
+	total.count = 0;
+	total.sum   = 0;
+	total.sumsq = 0;
+	total.min   = 0;
+	total.max   = 0;
+
+	if(tier == rollup_none)
+		return total;
+
+	// Newest first, until the start of the evaluation period:
+	const std::deque<rollup> &rollups = _rollups[tier];
+	for(std::deque<rollup>::const_reverse_iterator r = rollups.rbegin(); r != rollups.rend(); ++r)
+	{
+		if(r->end <= startTimestamp)
+			break;
+
+		if(total.count == 0)
+		{
+			total.end = r->end;
+			total.min = r->min;
+			total.max = r->max;
+		}
+
+		total.count += r->count;
+		total.sum   += r->sum;
+		total.sumsq += r->sumsq;
+		total.min    = std::min(total.min, r->min);
+		total.max    = std::max(total.max, r->max);
+	}
+
+	return total;
 }
 
 size_t measurements::nMeasurements() const
 {
-	return _values.size();
+	return _nInBlocks + _values.size();
 }
 
 double measurements::getLastValue() const
@@ -103,6 +401,12 @@ std::vector<double>* measurements::valuesInConfidence(uint64_t startTimestamp, d
 {
 	// Create a new vector with everything that is in time range:
 	std::vector<double>* valuesToKeep = new std::vector<double>();
+	for(size_t b=0; b<_blocks.size(); ++b)
+	{
+		if(_blocks[b].lastTimestamp() > startTimestamp)
+			_blocks[b].decode(startTimestamp, *valuesToKeep);
+	}
+
 	for(size_t i=0; i<_values.size(); ++i)
 	{
 		if(_timestamps.at(i) > startTimestamp)  // (startTimestamp, newest]
@@ -256,5 +560,45 @@ double measurementFunctions::stdDevMedian(const std::vector<double>* values)
 		return sqrt(sum);
 	}
 
+	return 0;
+}
+
+double measurementFunctions::mean(const rollup &r)
+{
+	if(r.count > 0)
+		return r.sum / static_cast<double>(r.count);
+
+	throw E_NO_MEASUREMENTS;
+}
+
+double measurementFunctions::maximum(const rollup &r)
+{
+	if(r.count > 0)
+		return r.max;
+
+	throw E_NO_MEASUREMENTS;
+}
+
+double measurementFunctions::minimum(const rollup &r)
+{
+	if(r.count > 0)
+		return r.min;
+
+	throw E_NO_MEASUREMENTS;
+}
+
+double measurementFunctions::stdDevMean(const rollup &r)
+{
+	// Standard deviation around mean value
+	if(r.count > 1)
+	{
+		double n = static_cast<double>(r.count);
+		double m = r.sum / n;
+		double variance = r.sumsq / n - m*m;
+
+		if(variance > 0)
+			return sqrt(variance);
+	}
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,441 @@
+#include "metrics.h"
+#include "numberformat.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// From 100 µs to 10 s:
+static const uint64_t histogramBounds[METRIC_HISTOGRAM_BUCKETS] = {
+	100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+	100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+
+static void appendNumber(double value, std::string &out)
+{
+	numberFormat f;
+	f.setShortest();
+	f.append(value, out);
+}
+
+static std::string seconds(uint64_t us)
+{
+	std::string s;
+	appendNumber(static_cast<double>(us) / 1000000.0, s);
+	return s;
+}
+
+static std::string escaped(const std::string &text)
+{
+	std::string e;
+	for(size_t i=0; i<text.size(); ++i)
+	{
+		if((text[i] == '\\') || (text[i] == '"'))
+			e += '\\';
+		e += text[i];
+	}
+
+	return e;
+}
+
+
+metric::metric(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue)
+{
+	_name = name;
+	_help = help;
+	_labelName = labelName;
+	_labelValue = labelValue;
+}
+
+metric::~metric()
+{
+
+}
+
+const std::string& metric::name() const
+{
+	return _name;
+}
+
+const std::string& metric::help() const
+{
+	return _help;
+}
+
+const std::string& metric::labelValue() const
+{
+	return _labelValue;
+}
+
+std::string metric::labels(const std::string &extra) const
+{
+	std::string l;
+	if(_labelName.size() > 0)
+		l = _labelName + "=\"" + escaped(_labelValue) + "\"";
+
+	if(extra.size() > 0)
+	{
+		if(l.size() > 0)
+			l += ",";
+		l += extra;
+	}
+
+	if(l.size() > 0)
+		return "{" + l + "}";
+
+	return l;
+}
+
+
+metricCounter::metricCounter(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue) : metric(name, help, labelName, labelValue)
+{
+	_value = 0;
+}
+
+metric_type metricCounter::type() const
+{
+	return metric_counter;
+}
+
+void metricCounter::add(uint64_t n)
+{
+	_value.fetch_add(n, std::memory_order_relaxed);
+}
+
+void metricCounter::set(uint64_t value)
+{
+	_value.store(value, std::memory_order_relaxed);
+}
+
+uint64_t metricCounter::value() const
+{
+	return _value.load(std::memory_order_relaxed);
+}
+
+void metricCounter::writePrometheus(std::string &out) const
+{
+	out += _name + labels("") + " " + std::to_string(value()) + "\n";
+}
+
+void metricCounter::writeJSON(std::string &out) const
+{
+	out += std::to_string(value());
+}
+
+
+metricGauge::metricGauge(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue) : metric(name, help, labelName, labelValue)
+{
+	_value = 0;
+}
+
+metric_type metricGauge::type() const
+{
+	return metric_gauge;
+}
+
+void metricGauge::set(double value)
+{
+	_value.store(value, std::memory_order_relaxed);
+}
+
+double metricGauge::value() const
+{
+	return _value.load(std::memory_order_relaxed);
+}
+
+void metricGauge::writePrometheus(std::string &out) const
+{
+	out += _name + labels("") + " ";
+	appendNumber(value(), out);
+	out += "\n";
+}
+
+void metricGauge::writeJSON(std::string &out) const
+{
+	appendNumber(value(), out);
+}
+
+
+metricHistogram::metricHistogram(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue) : metric(name, help, labelName, labelValue)
+{
+	for(size_t i=0; i<=METRIC_HISTOGRAM_BUCKETS; ++i)
+		_buckets[i] = 0;
+
+	_count = 0;
+	_sum = 0;
+}
+
+metric_type metricHistogram::type() const
+{
+	return metric_histogram;
+}
+
+void metricHistogram::observe(uint64_t duration)
+{
+	size_t b = 0;
+	while((b < METRIC_HISTOGRAM_BUCKETS) && (duration > histogramBounds[b]))
+		++b;
+
+	_buckets[b].fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(duration, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// An observation that is made during the export may show
+// in the buckets, but not yet in the count, or vice versa.
+void metricHistogram::writePrometheus(std::string &out) const
+{
+	uint64_t cumulated = 0;
+	for(size_t b=0; b<METRIC_HISTOGRAM_BUCKETS; ++b)
+	{
+		cumulated += _buckets[b].load(std::memory_order_relaxed);
+		out += _name + "_bucket" + labels("le=\"" + seconds(histogramBounds[b]) + "\"") + " " + std::to_string(cumulated) + "\n";
+	}
+
+	cumulated += _buckets[METRIC_HISTOGRAM_BUCKETS].load(std::memory_order_relaxed);
+	out += _name + "_bucket" + labels("le=\"+Inf\"") + " " + std::to_string(cumulated) + "\n";
+	out += _name + "_sum" + labels("") + " " + seconds(_sum.load(std::memory_order_relaxed)) + "\n";
+	out += _name + "_count" + labels("") + " " + std::to_string(cumulated) + "\n";
+}
+
+void metricHistogram::writeJSON(std::string &out) const
+{
+	out += "{\"count\":" + std::to_string(_count.load(std::memory_order_relaxed));
+	out += ",\"sum\":" + seconds(_sum.load(std::memory_order_relaxed)) + "}";
+}
+
+
+metricsRegistry::metricsRegistry()
+{
+	_socket = -1;
+	_thread = NULL;
+	_stop = false;
+}
+
+metricsRegistry::~metricsRegistry()
+{
+	stop();
+
+	for(size_t i=0; i<_metrics.size(); ++i)
+		delete _metrics.at(i);
+}
+
+metricCounter* metricsRegistry::newCounter(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue)
+{
+	metricCounter* m = new metricCounter(name, help, labelName, labelValue);
+	_metrics.push_back(m);
+	return m;
+}
+
+metricGauge* metricsRegistry::newGauge(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue)
+{
+	metricGauge* m = new metricGauge(name, help, labelName, labelValue);
+	_metrics.push_back(m);
+	return m;
+}
+
+metricHistogram* metricsRegistry::newHistogram(const std::string &name, const std::string &help, const std::string &labelName, const std::string &labelValue)
+{
+	metricHistogram* m = new metricHistogram(name, help, labelName, labelValue);
+	_metrics.push_back(m);
+	return m;
+}
+
+void metricsRegistry::families(std::vector<std::vector<const metric*> > &f) const
+{
+	f.clear();
+	for(size_t i=0; i<_metrics.size(); ++i)
+	{
+		size_t k = 0;
+		while((k < f.size()) && (f[k].front()->name() != _metrics[i]->name()))
+			++k;
+
+		if(k == f.size())
+			f.push_back(std::vector<const metric*>());
+
+		f[k].push_back(_metrics[i]);
+	}
+}
+
+std::string metricsRegistry::prometheus() const
+{
+	std::vector<std::vector<const metric*> > f;
+	families(f);
+
+	std::string out;
+	for(size_t k=0; k<f.size(); ++k)
+	{
+		const metric* first = f[k].front();
+		out += "# HELP " + first->name() + " " + first->help() + "\n";
+		out += "# TYPE " + first->name() + " ";
+		if(first->type() == metric_counter)
+			out += "counter\n";
+		else if(first->type() == metric_gauge)
+			out += "gauge\n";
+		else
+			out += "histogram\n";
+
+		for(size_t i=0; i<f[k].size(); ++i)
+			f[k][i]->writePrometheus(out);
+	}
+
+	return out;
+}
+
+// One key per family; labeled families are objects with one key per label value.
+std::string metricsRegistry::json() const
+{
+	std::vector<std::vector<const metric*> > f;
+	families(f);
+
+	std::string out = "{";
+	for(size_t k=0; k<f.size(); ++k)
+	{
+		if(k > 0)
+			out += ",";
+
+		out += "\"" + f[k].front()->name() + "\":";
+		if(f[k].front()->labelValue().size() == 0)
+		{
+			f[k].front()->writeJSON(out);
+		}
+		else
+		{
+			out += "{";
+			for(size_t i=0; i<f[k].size(); ++i)
+			{
+				if(i > 0)
+					out += ",";
+
+				out += "\"" + escaped(f[k][i]->labelValue()) + "\":";
+				f[k][i]->writeJSON(out);
+			}
+			out += "}";
+		}
+	}
+	out += "}";
+
+	return out;
+}
+
+bool metricsRegistry::start(const std::string &address, unsigned short port)
+{
+	if(_thread != NULL)
+		return true;
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if(inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+		return false;
+
+	_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(_socket < 0)
+		return false;
+
+	int reuse = 1;
+	setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	if((bind(_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) || (listen(_socket, 4) != 0))
+	{
+		close(_socket);
+		_socket = -1;
+		return false;
+	}
+
+	_stop = false;
+	_thread = new std::thread(&metricsRegistry::serve, this);
+	return true;
+}
+
+void metricsRegistry::stop()
+{
+	if(_thread == NULL)
+		return;
+
+	_stop = true;
+	_thread->join();
+	delete _thread;
+	_thread = NULL;
+
+	close(_socket);
+	_socket = -1;
+}
+
+// Requests are answered one after another; a scrape takes
+// well below a millisecond, and the port is local.
+void metricsRegistry::serve()
+{
+	pollfd p;
+	p.fd = _socket;
+	p.events = POLLIN;
+
+	while(!_stop)
+	{
+		p.revents = 0;
+		if(poll(&p, 1, 500) <= 0)
+			continue;
+
+		int client = accept4(_socket, NULL, NULL, SOCK_CLOEXEC);
+		if(client < 0)
+			continue;
+
+		timeval timeout;
+		timeout.tv_sec = 1;
+		timeout.tv_usec = 0;
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		respond(client);
+		close(client);
+	}
+}
+
+void metricsRegistry::respond(int client)
+{
+	std::string request;
+	char buffer[1024];
+	while((request.find("\r\n\r\n") == std::string::npos) && (request.size() < METRICS_MAX_REQUEST_SIZE))
+	{
+		ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+		if(n > 0)
+			request.append(buffer, static_cast<size_t>(n));
+		else if((n < 0) && (errno == EINTR))
+			continue;
+		else
+			break;
+	}
+
+	std::string status = "200 OK";
+	std::string body;
+	if((request.compare(0, 13, "GET /metrics ") == 0) || (request.compare(0, 6, "GET / ") == 0))
+		body = prometheus();
+	else
+	{
+		status = "404 Not Found";
+		body = "Metrics are available at /metrics\n";
+	}
+
+	std::string response = "HTTP/1.0 " + status + "\r\n";
+	response += "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+	response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+	response += "Connection: close\r\n\r\n";
+	response += body;
+
+	size_t sent = 0;
+	while(sent < response.size())
+	{
+		ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if(n > 0)
+			sent += static_cast<size_t>(n);
+		else if((n < 0) && (errno == EINTR))
+			continue;
+		else
+			break;
+	}
+}
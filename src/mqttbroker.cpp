@@ -7,8 +7,26 @@
 #include "sensor.h"
 #include "sensor_mqtt.h"
 #include "json.h"
+#include "measurements.h"
 
-mqttBroker::mqttBroker(logger* root)
+#include <algorithm>
+
+mqttPublishListener::mqttPublishListener(mqttBroker* broker)
+{
+	_broker = broker;
+}
+
+void mqttPublishListener::on_failure(const mqtt::token& tok)
+{
+	_broker->publishFinished(false, tok);
+}
+
+void mqttPublishListener::on_success(const mqtt::token& tok)
+{
+	_broker->publishFinished(true, tok);
+}
+
+mqttBroker::mqttBroker(logger* root) : _publishListener(this)
 {
 	_root = root;
 	_host = "";
@@ -21,6 +39,14 @@ mqttBroker::mqttBroker(logger* root)
 
 	_mqttClient = NULL;
 	_isConnected = false;
+
+	_maxInFlight = DEFAULT_MQTT_MAX_INFLIGHT;
+	_nInFlight   = 0;
+	_session     = 0;
+	_nPublished  = 0;
+	_nFailed     = 0;
+	_timestamp_lastStatistics = 0;
+	_nDropped_lastStatistics  = 0;
 }
 
 mqttBroker::~mqttBroker()
@@ -129,6 +155,43 @@ void mqttBroker::setConnectedPayload(const std::string& connectedpayload)
 	_connected_payload = connectedpayload;
 }
 
+void mqttBroker::setMaxQueueSize(size_t maxQueueSize)
+{
+	_queue.setMaxSize(maxQueueSize);
+}
+
+void mqttBroker::setMaxPublishRate(double messagesPerSecond)
+{
+	_queue.setMaxRate(messagesPerSecond);
+}
+
+void mqttBroker::setMaxInFlight(unsigned maxInFlight)
+{
+	_maxInFlight = std::max(maxInFlight, 1u);
+}
+
+void mqttBroker::setSpoolSize(size_t spoolSize)
+{
+	_spool.setMaxMemory(spoolSize);
+}
+
+void mqttBroker::setSpoolFile(const std::string &spoolFile)
+{
+	_spool.setFile(spoolFile, DEFAULT_MQTT_SPOOL_FILE_SIZE);
+
+	if(_spool.size() > 0)
+	{
+		std::stringstream ss;
+		ss << "MQTT spool file " << spoolFile << " contains " << _spool.size() << " messages from a previous run.";
+		_root->info(ss.str());
+	}
+}
+
+void mqttBroker::setSpoolReplayRate(double messagesPerSecond)
+{
+	_spool.setReplayRate(messagesPerSecond);
+}
+
 
 void mqttBroker::generateClientID()
 {
@@ -157,6 +220,86 @@ bool mqttBroker::doRetain() const
 	return _retained;
 }
 
+size_t mqttBroker::nQueued() const
+{
+	return _queue.size();
+}
+
+size_t mqttBroker::nSpooled() const
+{
+	return _spool.size();
+}
+
+unsigned mqttBroker::nInFlight() const
+{
+	return _nInFlight;
+}
+
+uint64_t mqttBroker::nPublished() const
+{
+	return _nPublished;
+}
+
+uint64_t mqttBroker::nCoalesced() const
+{
+	return _queue.nCoalesced();
+}
+
+uint64_t mqttBroker::nDropped() const
+{
+	return _queue.nDropped() + _spool.nDropped();
+}
+
+uint64_t mqttBroker::nFailed() const
+{
+	return _nFailed;
+}
+
+std::string mqttBroker::queueStatistics() const
+{
+	std::stringstream ss;
+	ss << "MQTT Broker " << _host << ":" << _port << ": ";
+	ss << nPublished() << " published, ";
+	ss << nQueued() << " queued, ";
+	ss << nSpooled() << " spooled, ";
+	ss << nInFlight() << " in flight, ";
+	ss << nCoalesced() << " coalesced, ";
+	ss << nDropped() << " dropped, ";
+	ss << nFailed() << " failed.";
+	return ss.str();
+}
+
+// Frees the in-flight slot of a token from the given session.
+// Tokens of an earlier session no longer hold a slot.
+bool mqttBroker::releaseInFlight(unsigned session)
+{
+	if(session != _session)
+		return false;
+
+	unsigned n = _nInFlight;
+	while(n > 0)
+	{
+		if(_nInFlight.compare_exchange_weak(n, n - 1))
+			return true;
+	}
+
+	return false;
+}
+
+// Called from paho's callback thread.
+void mqttBroker::publishFinished(bool success, const mqtt::token& tok)
+{
+	if(success)
+		++_nPublished;
+	else
+		++_nFailed;
+
+	unsigned session = static_cast<unsigned>(reinterpret_cast<uintptr_t>(tok.get_user_context()));
+	// A freed slot lets the queue continue without waiting for the next trigger.
+	if(releaseInFlight(session) && _isConnected)
+		sendQueued(_root->currentTimestamp());
+}
+
 
 void mqttBroker::reconnect()
 {
@@ -194,6 +337,10 @@ void mqttBroker::on_success(const mqtt::token& tok)
 // (Re)connection success
 void mqttBroker::connected(const std::string& cause)
 {
+	// Tokens of the lost session may never complete;
+	// they must not block the new one.
+	++_session;
+	_nInFlight = 0;
 	_isConnected = true;
 
 	if(!_connected_topic.empty())
@@ -221,6 +368,16 @@ void mqttBroker::connected(const std::string& cause)
 			} catch(int e) {}
 		}
 	}
+
+	// Replay messages that were published while disconnected:
+	if(!_spool.empty())
+	{
+		std::stringstream ss;
+		ss << "Sending " << _spool.size() << " spooled messages to MQTT Broker at " << _host << ":" << _port << ".";
+		_root->info(ss.str());
+
+		sendQueued(_root->currentTimestamp());
+	}
 }
 
 // Callback for when the connection is lost.
@@ -241,71 +398,86 @@ void mqttBroker::connection_lost(const std::string& cause)
 }
 
 // Callback for when a message arrives.
+// Topic and payload are only viewed in paho's message buffer; a copy
+// is made only if the payload has to be parsed as a JSON document.
 void mqttBroker::message_arrived(mqtt::const_message_ptr msg)
 {
-	std::string topic = msg->get_topic();
-	std::string payload = msg->to_string();
+	const std::string& topicRef   = msg->get_topic();
+	const mqtt::binary& payloadRef = msg->get_payload();
 
-	for(size_t i=0; i<_root->nSensors(); ++i)
+	std::string_view topic(topicRef);
+	std::string_view payload(payloadRef.data(), payloadRef.size());
+
+	std::vector<std::pair<std::string, sensorMQTT*>>::const_iterator it = std::lower_bound(_subscriptions.begin(), _subscriptions.end(), topic,
+		[](const std::pair<std::string, sensorMQTT*>& sub, std::string_view t) { return std::string_view(sub.first) < t; });
+
+	for(; it != _subscriptions.end(); ++it)
 	{
-		sensor* s = _root->getSensor(i);
-		if(s->type() == sensor_mqtt)
+		if(std::string_view(it->first) != topic)
+			break;
+
+		dispatch(it->second, topic, payload);
+	}
+}
+
+void mqttBroker::dispatch(sensorMQTT* smqtt, std::string_view topic, std::string_view payload)
+{
+	// Are we supposed to find a key in this JSON object?
+	if(smqtt->nJSONkeys() > 0)
+	{
+		try
 		{
-			sensorMQTT* smqtt = dynamic_cast<sensorMQTT*>(s);
+			json jsonPayload;
+			jsonPayload.setContent(payload);
+			jsonPayload.parse();
 
-			if(topic == smqtt->getMQTTSubscribeTopic())
+			jsonNode* node = jsonPayload.root();
+			for(size_t key=0; key<smqtt->nJSONkeys(); ++key)
 			{
-				// Are we supposed to find a key in this JSON object?
-				if(smqtt->nJSONkeys() > 0)
-				{
-					try
-					{
-						json jsonPayload;
-						jsonPayload.setContent(payload);
-						jsonPayload.parse();
-
-						jsonNode* node = jsonPayload.root();
-						for(size_t key=0; key<smqtt->nJSONkeys(); ++key)
-						{
-							try
-							{ 
-								node = node->element(smqtt->jsonKey(key));
-							}
-							catch(int e)
-							{
-								std::stringstream ss;
-								ss << "Error finding value for JSON key \'" << smqtt->jsonKey(key) << "\' in MQTT message. Topic: \'" << topic << "\', Payload: '" << payload << "\'.";
-								_root->error(ss.str());
-								throw e;
-							}
-						}
-
-						double value = node->value()->getDouble();
-						if(smqtt->addRawMeasurement(value))
-						{
-							smqtt->publishLastEvent();
-						}
-					}
-					catch(int e)
-					{
-						std::stringstream ss;
-						ss << "Error parsing JSON payload in MQTT message. Topic: \'" << topic << "\', Payload: '" << payload << "\'.";
-						_root->error(ss.str());
-					}
+				try
+				{ 
+					node = node->element(smqtt->jsonKey(key));
 				}
-				else
+				catch(int e)
 				{
-					try
-					{
-						double value = atof(payload.c_str());
-						if(smqtt->addRawMeasurement(value))
-						{
-							smqtt->publishLastEvent();
-						}
-						
-					} catch(int e) {}
+					std::stringstream ss;
+					ss << "Error finding value for JSON key \'" << smqtt->jsonKey(key) << "\' in MQTT message. Topic: \'" << topic << "\', Payload: '" << payload << "\'.";
+					_root->error(ss.str());
+					throw e;
 				}
 			}
+
+			double value = node->value()->getDouble();
+			if(smqtt->addRawMeasurement(value))
+			{
+				smqtt->publishLastEvent();
+			}
+		}
+		catch(int e)
+		{
+			std::stringstream ss;
+			ss << "Error parsing JSON payload in MQTT message. Topic: \'" << topic << "\', Payload: '" << payload << "\'.";
+			_root->error(ss.str());
+		}
+	}
+	else
+	{
+		double value = 0;
+		if(parseDouble(payload, value))
+		{
+			try
+			{
+				if(smqtt->addRawMeasurement(value))
+				{
+					smqtt->publishLastEvent();
+				}
+			} catch(int e) {}
+		}
+		else
+		{
+			std::stringstream ss;
+			ss << "MQTT payload is not a number. Topic: \'" << topic << "\', Payload: '" << payload << "\'.";
+			_root->error(ss.str());
 		}
 	}
 }
@@ -315,11 +487,30 @@ void mqttBroker::delivery_complete(mqtt::delivery_token_ptr token)
 
 }
 
+void mqttBroker::buildSubscriptionIndex()
+{
+	_subscriptions.clear();
+
+	for(size_t i=0; i<_root->nSensors(); ++i)
+	{
+		sensor* s = _root->getSensor(i);
+		if(s->type() == sensor_mqtt)
+		{
+			sensorMQTT* smqtt = dynamic_cast<sensorMQTT*>(s);
+			_subscriptions.push_back(std::make_pair(smqtt->getMQTTSubscribeTopic(), smqtt));
+		}
+	}
+
+	std::stable_sort(_subscriptions.begin(), _subscriptions.end(),
+		[](const std::pair<std::string, sensorMQTT*>& a, const std::pair<std::string, sensorMQTT*>& b) { return a.first < b.first; });
+}
+
 void mqttBroker::connectToMQTTBroker()
 {
 	if(_host.size() > 0)
 	{
 		generateClientID();
+		buildSubscriptionIndex();
 
 		_connOpts.set_keep_alive_interval(MQTT_KEEPALIVE_INTERVAL);
 		_connOpts.set_clean_session(true);
@@ -350,14 +541,90 @@ void mqttBroker::connectToMQTTBroker()
 
 void mqttBroker::publish(const std::string &topic, const std::string &payload, bool enforce)
 {
-	if(_publish_enabled || enforce)
+	if(enforce)
 	{
+		// Status messages bypass the queue.
 		if(_isConnected)
+			_mqttClient->publish(topic, payload.c_str(), payload.size(), _qos, _retained);
+	}
+	else if(_publish_enabled && isValidTopic(topic))
+	{
+		// While connected, new messages take the queue; spooled
+		// messages are replayed as a separate, rate-limited backlog.
+		if(_isConnected)
+		{
+			_queue.push(topic, payload);
+		}
+		else
 		{
-			if(isValidTopic(topic) || enforce)
+			mqttMessage m;
+			m.topic   = topic;
+			m.payload = payload;
+			_spool.push(m);
+		}
+
+		if(_isConnected)
+			sendQueued(_root->currentTimestamp());
+	}
+}
+
+void mqttBroker::sendQueued(uint64_t currentTimestamp)
+{
+	// Only one thread sends at a time to keep the message order.
+	// Whatever is left will be sent by the next call.
+	std::unique_lock<std::mutex> lock(_sendMutex, std::try_to_lock);
+	if(!lock.owns_lock())
+		return;
+
+	// Live messages from the queue go first, so the replay rate only
+	// throttles the backlog in the spool, not the current values.
+	// The backlog is older than what has already been sent live, so it
+	// is never retained: the broker keeps the latest value of a topic.
+	mqttMessage m;
+	unsigned session = _session;
+	while(_isConnected && (_nInFlight < _maxInFlight))
+	{
+		bool retained = _retained;
+		if(!_queue.pop(m, currentTimestamp))
+		{
+			if(!_queue.empty() || !_spool.pop(m, currentTimestamp))
+				break;
+
+			retained = false;
+		}
+
+		++_nInFlight;
+		try {
+			_mqttClient->publish(m.topic, m.payload.c_str(), m.payload.size(), _qos, retained, reinterpret_cast<void*>(static_cast<uintptr_t>(session)), _publishListener);
+		}
+		catch (const mqtt::exception& exc) {
+			++_nFailed;
+			releaseInFlight(session);
+		}
+	}
+}
+
+void mqttBroker::processQueue(uint64_t currentTimestamp)
+{
+	if(_mqttClient != NULL)
+	{
+		sendQueued(currentTimestamp);
+
+		if(timeDiff(currentTimestamp, _timestamp_lastStatistics) >= MQTT_STATISTICS_INTERVAL)
+		{
+			if(nDropped() > _nDropped_lastStatistics)
 			{
-				_mqttClient->publish(topic, payload.c_str(), payload.size(), _qos, _retained);
+				std::stringstream ss;
+				ss << "MQTT publish queue overflow: " << (nDropped() - _nDropped_lastStatistics) << " messages dropped. " << queueStatistics();
+				_root->warning(ss.str());
 			}
+			else
+			{
+				_root->debug(queueStatistics());
+			}
+
+			_nDropped_lastStatistics  = nDropped();
+			_timestamp_lastStatistics = currentTimestamp;
 		}
 	}
 }
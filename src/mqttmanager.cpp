@@ -1,5 +1,6 @@
 #include "mqttmanager.h"
 #include "mqttbroker.h"
+#include "trace.h"
 
 mqttManager::mqttManager()
 {
@@ -17,6 +18,16 @@ void mqttManager::addBroker(mqttBroker* broker)
 	_brokers.push_back(broker);
 }
 
+size_t mqttManager::nBrokers() const
+{
+	return _brokers.size();
+}
+
+mqttBroker* mqttManager::getBroker(size_t i)
+{
+	return _brokers.at(i);
+}
+
 void mqttManager::connectToMQTTBrokers()
 {
 	#ifdef OPTION_MQTT
@@ -29,10 +40,21 @@ void mqttManager::connectToMQTTBrokers()
 
 void mqttManager::publish(const std::string &topic, const std::string &payload)
 {
+	TRACE_SCOPE("mqtt.publish", topic);
 	#ifdef OPTION_MQTT
 		for(size_t i=0; i<_brokers.size(); ++i)
 		{
 			_brokers.at(i)->publish(topic, payload, false);
 		}
 	#endif
+}
+
+void mqttManager::processQueues(uint64_t currentTimestamp)
+{
+	#ifdef OPTION_MQTT
+		for(size_t i=0; i<_brokers.size(); ++i)
+		{
+			_brokers.at(i)->processQueue(currentTimestamp);
+		}
+	#endif
 }
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "mqttqueue.h"
+
+#include "sensorlogger.h"
+
+#include <algorithm>
+
+rateLimiter::rateLimiter()
+{
+	_rate   = 0;
+	_tokens = 0;
+	_timestamp_lastRefill = 0;
+}
+
+void rateLimiter::setRate(double eventsPerSecond)
+{
+	_rate = std::max(eventsPerSecond, 0.0);
+}
+
+double rateLimiter::getRate() const
+{
+	return _rate;
+}
+
+bool rateLimiter::acquire(uint64_t currentTimestamp)
+{
+	if(_rate <= 0)
+		return true;
+
+	if(currentTimestamp > _timestamp_lastRefill)
+	{
+		double burst = std::max(_rate, 1.0);
+		_tokens = std::min(burst, _tokens + _rate * static_cast<double>(currentTimestamp - _timestamp_lastRefill) / 1000.0);
+		_timestamp_lastRefill = currentTimestamp;
+	}
+
+	if(_tokens < 1.0)
+		return false;
+
+	_tokens -= 1.0;
+	return true;
+}
+
+
+mqttQueue::mqttQueue()
+{
+	_nextSeq = 0;
+	_maxSize = DEFAULT_MQTT_MAX_QUEUE_SIZE;
+	_limiter.setRate(DEFAULT_MQTT_MAX_PUBLISH_RATE);
+
+	_nEnqueued  = 0;
+	_nCoalesced = 0;
+	_nDropped   = 0;
+}
+
+mqttQueue::~mqttQueue()
+{
+	clear();
+}
+
+void mqttQueue::setMaxSize(size_t maxSize)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_maxSize = std::max(maxSize, static_cast<size_t>(1));
+	while(_entries.size() > _maxSize)
+	{
+		popFront();
+		++_nDropped;
+	}
+}
+
+void mqttQueue::setMaxRate(double messagesPerSecond)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_limiter.setRate(messagesPerSecond);
+}
+
+size_t mqttQueue::getMaxSize() const
+{
+	return _maxSize;
+}
+
+double mqttQueue::getMaxRate() const
+{
+	return _limiter.getRate();
+}
+
+void mqttQueue::popFront()
+{
+	std::unordered_map<std::string, uint64_t>::iterator pending = _pendingTopics.find(_entries.front().message.topic);
+	if((pending != _pendingTopics.end()) && (pending->second == _entries.front().seq))
+		_pendingTopics.erase(pending);
+
+	_entries.pop_front();
+}
+
+bool mqttQueue::push(const std::string &topic, const std::string &payload)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	++_nEnqueued;
+
+	// The broker has not yet received the previous value for this topic:
+	// replace it, it would be outdated anyway when it is finally sent.
+	std::unordered_map<std::string, uint64_t>::iterator pending = _pendingTopics.find(topic);
+	if(pending != _pendingTopics.end())
+	{
+		size_t pos = static_cast<size_t>(pending->second - _entries.front().seq);
+		_entries.at(pos).message.payload = payload;
+		++_nCoalesced;
+		return true;
+	}
+
+	bool nothingDropped = true;
+	if(_entries.size() >= _maxSize)
+	{
+		popFront();
+		++_nDropped;
+		nothingDropped = false;
+	}
+
+	queueEntry entry;
+	entry.seq = _nextSeq++;
+	entry.message.topic   = topic;
+	entry.message.payload = payload;
+
+	_pendingTopics[topic] = entry.seq;
+	_entries.push_back(std::move(entry));
+
+	return nothingDropped;
+}
+
+bool mqttQueue::pop(mqttMessage &message, uint64_t currentTimestamp)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(_entries.empty())
+		return false;
+
+	if(!_limiter.acquire(currentTimestamp))
+		return false;
+
+	message = std::move(_entries.front().message);
+	_pendingTopics.erase(message.topic);
+	_entries.pop_front();
+
+	return true;
+}
+
+size_t mqttQueue::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+
+bool mqttQueue::empty() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.empty();
+}
+
+void mqttQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_pendingTopics.clear();
+}
+
+uint64_t mqttQueue::nEnqueued() const
+{
+	return _nEnqueued;
+}
+
+uint64_t mqttQueue::nCoalesced() const
+{
+	return _nCoalesced;
+}
+
+uint64_t mqttQueue::nDropped() const
+{
+	return _nDropped;
+}
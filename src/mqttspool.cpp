@@ -0,0 +1,296 @@
+#include "mqttspool.h"
+
+#include "sensorlogger.h"
+
+#include <vector>
+#include <unistd.h>
+
+mqttSpool::mqttSpool()
+{
+	_maxMemory   = DEFAULT_MQTT_SPOOL_SIZE;
+	_maxFileSize = DEFAULT_MQTT_SPOOL_FILE_SIZE;
+	_file        = NULL;
+	_readOffset  = 0;
+	_nOnDisk     = 0;
+
+	_nSpooled = 0;
+	_nDropped = 0;
+
+	_limiter.setRate(DEFAULT_MQTT_SPOOL_REPLAY_RATE);
+}
+
+mqttSpool::~mqttSpool()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(_filename.size() > 0)
+	{
+		// Keep everything that has not been sent yet for the next start:
+		// rewrite the spool file with the messages from memory first.
+		std::vector<mqttMessage> remaining(_memory.begin(), _memory.end());
+		mqttMessage m;
+		while(readRecord(m))
+			remaining.push_back(m);
+
+		closeFile();
+		resetFile();
+
+		for(size_t i=0; i<remaining.size(); ++i)
+			writeRecord(remaining.at(i));
+	}
+
+	closeFile();
+}
+
+void mqttSpool::setMaxMemory(size_t maxMessages)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_maxMemory = maxMessages;
+	while(_memory.size() > _maxMemory)
+	{
+		_memory.pop_front();
+		++_nDropped;
+	}
+}
+
+void mqttSpool::setFile(const std::string &filename, uint64_t maxFileSize)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	closeFile();
+
+	_filename    = filename;
+	_maxFileSize = maxFileSize;
+	_readOffset  = 0;
+	_nOnDisk     = 0;
+
+	if(_filename.size() > 0)
+	{
+		// Count records left over from a previous run:
+		if(openFile())
+		{
+			size_t nRecords = 0;
+			mqttMessage m;
+			while(readRecord(m))
+				++nRecords;
+
+			// A record that was torn by a crash would block everything
+			// that is appended behind it: cut the file after the last
+			// complete record.
+			fflush(_file);
+			if(ftruncate(fileno(_file), _readOffset) != 0)
+			{
+				closeFile();
+				resetFile();
+				nRecords = 0;
+			}
+
+			_readOffset = 0;
+			_nOnDisk    = nRecords;
+		}
+	}
+}
+
+void mqttSpool::setReplayRate(double messagesPerSecond)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_limiter.setRate(messagesPerSecond);
+}
+
+bool mqttSpool::enabled() const
+{
+	return (_maxMemory > 0);
+}
+
+bool mqttSpool::openFile()
+{
+	if(_file == NULL)
+	{
+		_file = fopen(_filename.c_str(), "a+b");
+	}
+
+	return (_file != NULL);
+}
+
+void mqttSpool::closeFile()
+{
+	if(_file != NULL)
+	{
+		fclose(_file);
+		_file = NULL;
+	}
+}
+
+void mqttSpool::resetFile()
+{
+	// Truncate:
+	FILE* f = fopen(_filename.c_str(), "wb");
+	if(f != NULL)
+		fclose(f);
+
+	_readOffset = 0;
+	_nOnDisk    = 0;
+}
+
+// Record format: uint32 topic length, topic, uint32 payload length, payload.
+bool mqttSpool::writeRecord(const mqttMessage &message)
+{
+	if(!openFile())
+		return false;
+
+	fseek(_file, 0, SEEK_END);
+	long fileSize = ftell(_file);
+	uint64_t recordSize = 2*sizeof(uint32_t) + message.topic.size() + message.payload.size();
+
+	if((fileSize < 0) || ((static_cast<uint64_t>(fileSize) + recordSize) > _maxFileSize))
+		return false;
+
+	uint32_t topicLength   = static_cast<uint32_t>(message.topic.size());
+	uint32_t payloadLength = static_cast<uint32_t>(message.payload.size());
+
+	bool success = (fwrite(&topicLength, sizeof(topicLength), 1, _file) == 1);
+	success = success && (fwrite(message.topic.data(), 1, topicLength, _file) == topicLength);
+	success = success && (fwrite(&payloadLength, sizeof(payloadLength), 1, _file) == 1);
+	success = success && (fwrite(message.payload.data(), 1, payloadLength, _file) == payloadLength);
+	fflush(_file);
+
+	if(success)
+		++_nOnDisk;
+
+	return success;
+}
+
+bool mqttSpool::readRecord(mqttMessage &message)
+{
+	if(!openFile())
+		return false;
+
+	if(fseek(_file, _readOffset, SEEK_SET) != 0)
+		return false;
+
+	uint32_t topicLength, payloadLength;
+	if(fread(&topicLength, sizeof(topicLength), 1, _file) != 1)
+		return false;
+
+	if(topicLength > _maxFileSize)  // corrupt record
+		return false;
+
+	message.topic.resize(topicLength);
+	if(fread(&message.topic[0], 1, topicLength, _file) != topicLength)
+		return false;
+
+	if(fread(&payloadLength, sizeof(payloadLength), 1, _file) != 1)
+		return false;
+
+	if(payloadLength > _maxFileSize)
+		return false;
+
+	message.payload.resize(payloadLength);
+	if(fread(&message.payload[0], 1, payloadLength, _file) != payloadLength)
+		return false;
+
+	_readOffset = ftell(_file);
+	if(_nOnDisk > 0)
+		--_nOnDisk;
+
+	return true;
+}
+
+void mqttSpool::refillFromFile()
+{
+	// Read back the oldest half of the memory's capacity:
+	size_t nRefill = std::max(_maxMemory / 2, static_cast<size_t>(1));
+
+	mqttMessage m;
+	while(_memory.size() < nRefill)
+	{
+		if(!readRecord(m))
+		{
+			// End of file or a truncated last record.
+			_nOnDisk = 0;
+			break;
+		}
+
+		_memory.push_back(m);
+	}
+
+	if(_nOnDisk == 0)
+	{
+		// Everything has been read back.
+		closeFile();
+		resetFile();
+	}
+}
+
+void mqttSpool::push(const mqttMessage &message)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(!enabled())
+	{
+		++_nDropped;
+		return;
+	}
+
+	++_nSpooled;
+
+	// Once messages went to the file, newer ones have to follow them there to keep the order.
+	if((_memory.size() >= _maxMemory) || (_nOnDisk > 0))
+	{
+		if(_filename.size() > 0)
+		{
+			if(!writeRecord(message))
+				++_nDropped;
+
+			return;
+		}
+
+		// No spool file: make room by dropping the oldest message.
+		_memory.pop_front();
+		++_nDropped;
+	}
+
+	_memory.push_back(message);
+}
+
+bool mqttSpool::pop(mqttMessage &message, uint64_t currentTimestamp)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(_memory.empty() && (_nOnDisk > 0))
+		refillFromFile();
+
+	if(_memory.empty())
+		return false;
+
+	if(!_limiter.acquire(currentTimestamp))
+		return false;
+
+	message = std::move(_memory.front());
+	_memory.pop_front();
+
+	return true;
+}
+
+size_t mqttSpool::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _memory.size() + _nOnDisk;
+}
+
+bool mqttSpool::empty() const
+{
+	return (size() == 0);
+}
+
+uint64_t mqttSpool::nSpooled() const
+{
+	return _nSpooled;
+}
+
+uint64_t mqttSpool::nDropped() const
+{
+	return _nDropped;
+}
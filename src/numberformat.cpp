@@ -0,0 +1,127 @@
+#include "numberformat.h"
+
+#include "json.h"
+
+#include <charconv>
+
+numberFormat::numberFormat()
+{
+	setGeneral();
+}
+
+void numberFormat::setGeneral()
+{
+	_style     = numberGeneral;
+	_precision = 6;
+}
+
+void numberFormat::setDecimals(int decimals)
+{
+	_style     = numberFixed;
+	_precision = decimals;
+
+	if(_precision < 0)
+		_precision = 0;
+	if(_precision > 17)
+		_precision = 17;
+}
+
+void numberFormat::setShortest()
+{
+	_style     = numberShortest;
+	_precision = 0;
+}
+
+bool numberFormat::setFromString(const std::string &decimals)
+{
+	if(decimals == "shortest")
+	{
+		setShortest();
+		return true;
+	}
+
+	long n;
+	if(isIntInString(decimals) && parseLong(decimals, n) && (n >= 0))
+	{
+		setDecimals(static_cast<int>(n));
+		return true;
+	}
+
+	return false;
+}
+
+numberStyle numberFormat::getStyle() const
+{
+	return _style;
+}
+
+int numberFormat::getPrecision() const
+{
+	return _precision;
+}
+
+size_t numberFormat::format(double value, char* buffer, size_t bufferSize) const
+{
+	char* last = buffer + bufferSize;
+	std::to_chars_result result;
+	result.ec = std::errc::value_too_large;
+
+	switch(_style)
+	{
+		case(numberShortest):
+			result = std::to_chars(buffer, last, value);
+			break;
+		case(numberFixed):
+			result = std::to_chars(buffer, last, value, std::chars_format::fixed, _precision);
+			break;
+		case(numberGeneral):
+			result = std::to_chars(buffer, last, value, std::chars_format::general, _precision);
+			break;
+	}
+
+	// Huge values do not fit as fixed-point numbers:
+	if(result.ec != std::errc())
+		result = std::to_chars(buffer, last, value, std::chars_format::general, 17);
+
+	if(result.ec != std::errc())
+		return 0;
+
+	size_t length = static_cast<size_t>(result.ptr - buffer);
+
+	// Small negative values that are rounded to zero should not keep their sign ("-0.00").
+	if((length > 1) && (buffer[0] == '-'))
+	{
+		bool onlyZeros = true;
+		for(size_t i=1; i<length; ++i)
+		{
+			if(buffer[i] != '0' && buffer[i] != '.')
+			{
+				onlyZeros = false;
+				break;
+			}
+		}
+
+		if(onlyZeros)
+		{
+			for(size_t i=1; i<length; ++i)
+				buffer[i-1] = buffer[i];
+			--length;
+		}
+	}
+
+	return length;
+}
+
+void numberFormat::append(double value, std::string &out) const
+{
+	char buffer[NUMBERFORMAT_BUFFER_SIZE];
+	size_t length = format(value, buffer, sizeof(buffer));
+	out.append(buffer, length);
+}
+
+std::string numberFormat::format(double value) const
+{
+	char buffer[NUMBERFORMAT_BUFFER_SIZE];
+	size_t length = format(value, buffer, sizeof(buffer));
+	return std::string(buffer, length);
+}
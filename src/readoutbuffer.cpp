@@ -4,6 +4,7 @@
 readoutFile::readoutFile(const std::string& filename)
 {
 	_content.clear();
+	_error = 0;
 	_last_read_timestamp = 0;
 
 	setFilename(filename);
@@ -46,6 +47,7 @@ std::string readoutFile::getContent(logger* root, uint64_t currentTimestamp)
 	if((currentTimestamp - _last_read_timestamp) > BUFFERTIME)
 	{
 		_content.clear();
+		_error = 0;
 
 		if(_isHTTP)
 		{
@@ -56,6 +58,7 @@ std::string readoutFile::getContent(logger* root, uint64_t currentTimestamp)
 			catch(int e)
 			{
 				root->error("Cannot read from: " + _filename);
+				_error = e;
 			}
 		}
 		else   // file in file system
@@ -86,7 +89,12 @@ std::string readoutFile::getContent(logger* root, uint64_t currentTimestamp)
 
 		_last_read_timestamp = currentTimestamp;
 	}
-	
+
+	// A failed request is not repeated for the other sensors
+	// that read from this file within the buffer time:
+	if(_error != 0)
+		throw _error;
+
 	return _content;
 }
 
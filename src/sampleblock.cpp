@@ -0,0 +1,235 @@
+#include "sampleblock.h"
+
+#include <cstring>
+#include <algorithm>
+
+static uint64_t doubleBits(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static double bitsDouble(uint64_t bits)
+{
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static unsigned leadingZeros(uint64_t x)
+{
+	return (x == 0) ? 64 : static_cast<unsigned>(__builtin_clzll(x));
+}
+
+static unsigned trailingZeros(uint64_t x)
+{
+	return (x == 0) ? 64 : static_cast<unsigned>(__builtin_ctzll(x));
+}
+
+sampleBlock::sampleBlock()
+{
+	_nBits = 0;
+	_count = 0;
+	_firstTimestamp = 0;
+	_lastTimestamp  = 0;
+}
+
+void sampleBlock::writeBits(uint64_t value, unsigned nBits)
+{
+	// Most significant bit first.
+	for(unsigned i=nBits; i>0; --i)
+	{
+		size_t word = _nBits / 64;
+		if(word >= _bits.size())
+			_bits.push_back(0);
+
+		if((value >> (i-1)) & 1)
+			_bits[word] |= (static_cast<uint64_t>(1) << (63 - (_nBits % 64)));
+
+		++_nBits;
+	}
+}
+
+uint64_t sampleBlock::readBits(size_t &position, unsigned nBits) const
+{
+	uint64_t value = 0;
+	for(unsigned i=0; i<nBits; ++i)
+	{
+		uint64_t bit = (_bits[position / 64] >> (63 - (position % 64))) & 1;
+		value = (value << 1) | bit;
+		++position;
+	}
+
+	return value;
+}
+
+void sampleBlock::encode(const std::deque<uint64_t> &timestamps, const std::deque<double> &values, size_t n)
+{
+	_bits.clear();
+	_nBits = 0;
+	_count = n;
+
+	if(n == 0)
+		return;
+
+	_firstTimestamp = timestamps[0];
+	_lastTimestamp  = timestamps[n-1];
+
+	int64_t  previousDelta = 0;
+	uint64_t previousValue = doubleBits(values[0]);
+	unsigned previousLeading  = 64;
+	unsigned previousTrailing = 0;
+
+	writeBits(previousValue, 64);
+
+	for(size_t i=1; i<n; ++i)
+	{
+		// Timestamp: delta of delta, in variable length.
+		int64_t delta = static_cast<int64_t>(timestamps[i] - timestamps[i-1]);
+		int64_t dod   = delta - previousDelta;
+		previousDelta = delta;
+
+		if(dod == 0)
+		{
+			writeBits(0, 1);
+		}
+		else if((dod >= -63) && (dod <= 64))
+		{
+			writeBits(2, 2);   // 10
+			writeBits(static_cast<uint64_t>(dod + 63), 7);
+		}
+		else if((dod >= -2047) && (dod <= 2048))
+		{
+			writeBits(6, 3);   // 110
+			writeBits(static_cast<uint64_t>(dod + 2047), 12);
+		}
+		else
+		{
+			writeBits(7, 3);   // 111
+			writeBits(static_cast<uint64_t>(dod), 64);
+		}
+
+		// Value: XOR with previous value.
+		uint64_t current = doubleBits(values[i]);
+		uint64_t x = current ^ previousValue;
+		previousValue = current;
+
+		if(x == 0)
+		{
+			writeBits(0, 1);
+			continue;
+		}
+
+		unsigned leading  = std::min(leadingZeros(x), 31u);
+		unsigned trailing = trailingZeros(x);
+
+		if((previousLeading < 64) && (leading >= previousLeading) && (trailing >= previousTrailing))
+		{
+			// Meaningful bits fit into the previous window.
+			writeBits(2, 2);   // 10
+			unsigned length = 64 - previousLeading - previousTrailing;
+			writeBits(x >> previousTrailing, length);
+		}
+		else
+		{
+			writeBits(3, 2);   // 11
+			unsigned length = 64 - leading - trailing;  // 1..64
+			writeBits(leading, 5);
+			writeBits(length - 1, 6);
+			writeBits(x >> trailing, length);
+
+			previousLeading  = leading;
+			previousTrailing = trailing;
+		}
+	}
+
+	_bits.shrink_to_fit();
+}
+
+void sampleBlock::decode(uint64_t startTimestamp, std::vector<double> &values, std::vector<uint64_t>* timestamps) const
+{
+	if(_count == 0)
+		return;
+
+	size_t position = 0;
+
+	uint64_t timestamp = _firstTimestamp;
+	int64_t  previousDelta = 0;
+	uint64_t previousValue = readBits(position, 64);
+	unsigned previousLeading  = 64;
+	unsigned previousTrailing = 0;
+
+	if(timestamp > startTimestamp)
+	{
+		values.push_back(bitsDouble(previousValue));
+		if(timestamps != NULL)
+			timestamps->push_back(timestamp);
+	}
+
+	for(size_t i=1; i<_count; ++i)
+	{
+		int64_t dod = 0;
+		if(readBits(position, 1) == 1)
+		{
+			if(readBits(position, 1) == 0)
+				dod = static_cast<int64_t>(readBits(position, 7)) - 63;
+			else if(readBits(position, 1) == 0)
+				dod = static_cast<int64_t>(readBits(position, 12)) - 2047;
+			else
+				dod = static_cast<int64_t>(readBits(position, 64));
+		}
+
+		previousDelta += dod;
+		timestamp += static_cast<uint64_t>(previousDelta);
+
+		if(readBits(position, 1) == 1)
+		{
+			uint64_t x;
+			if(readBits(position, 1) == 0)
+			{
+				unsigned length = 64 - previousLeading - previousTrailing;
+				x = readBits(position, length) << previousTrailing;
+			}
+			else
+			{
+				unsigned leading = static_cast<unsigned>(readBits(position, 5));
+				unsigned length  = static_cast<unsigned>(readBits(position, 6)) + 1;
+				unsigned trailing = 64 - leading - length;
+				x = readBits(position, length) << trailing;
+
+				previousLeading  = leading;
+				previousTrailing = trailing;
+			}
+
+			previousValue ^= x;
+		}
+
+		if(timestamp > startTimestamp)
+		{
+			values.push_back(bitsDouble(previousValue));
+			if(timestamps != NULL)
+				timestamps->push_back(timestamp);
+		}
+	}
+}
+
+size_t sampleBlock::count() const
+{
+	return _count;
+}
+
+uint64_t sampleBlock::firstTimestamp() const
+{
+	return _firstTimestamp;
+}
+
+uint64_t sampleBlock::lastTimestamp() const
+{
+	return _lastTimestamp;
+}
+
+size_t sampleBlock::memory() const
+{
+	return sizeof(sampleBlock) + _bits.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,436 @@
+#include "samplejournal.h"
+
+#include "sensorlogger.h"
+#include "sensor.h"
+#include "json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define JOURNAL_MAGIC     "SLJ1"
+#define JOURNAL_EXTENSION ".slj"
+#define CSV_EXTENSION     ".csv"
+
+/* Segment format: magic, uint16 number of sensors, for each sensor
+   uint16 length and sensor ID; then the samples, each as
+   uint16 sensor index, uint64 timestamp, double value.
+   Segment files are named after the timestamp of their first sample,
+   so that sorting them by name puts them in chronological order. */
+
+#define JOURNAL_RECORD_SIZE (sizeof(uint16_t) + sizeof(uint64_t) + sizeof(double))
+
+static bool hasExtension(const std::string &name, const std::string &extension)
+{
+	return (name.size() > extension.size()) && (name.compare(name.size() - extension.size(), extension.size(), extension) == 0);
+}
+
+sampleJournal::sampleJournal()
+{
+	_maxSegmentSize = DEFAULT_JOURNAL_SEGMENT_SIZE;
+	_maxSegments    = 0;
+	_flushInterval  = DEFAULT_JOURNAL_FLUSH_INTERVAL;
+
+	_maxBuffer      = DEFAULT_JOURNAL_BUFFER_SIZE;
+	_nDropped       = 0;
+	_nWriteFailures = 0;
+
+	_segment     = NULL;
+	_segmentSize = 0;
+
+	_thread = NULL;
+	_stop   = false;
+}
+
+sampleJournal::~sampleJournal()
+{
+	stop();
+}
+
+void sampleJournal::setPath(const std::string &path)
+{
+	_path = path;
+
+	// Without trailing slash:
+	while((_path.size() > 1) && (_path.back() == '/'))
+		_path.pop_back();
+}
+
+void sampleJournal::setSegmentSize(uint64_t maxSegmentSize)
+{
+	_maxSegmentSize = std::max(maxSegmentSize, static_cast<uint64_t>(4096));
+}
+
+void sampleJournal::setMaxSegments(unsigned maxSegments)
+{
+	_maxSegments = maxSegments;
+}
+
+void sampleJournal::setSensors(const std::vector<sensor*> &sensors)
+{
+	_sensorIDs.clear();
+	_sensorIndex.clear();
+
+	for(size_t i=0; i<sensors.size(); ++i)
+	{
+		_sensorIndex[sensors[i]] = static_cast<uint16_t>(_sensorIDs.size());
+		_sensorIDs.push_back(sensors[i]->getSensorID());
+	}
+}
+
+bool sampleJournal::enabled() const
+{
+	return (_path.size() > 0);
+}
+
+const std::string& sampleJournal::getPath() const
+{
+	return _path;
+}
+
+void sampleJournal::start()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if(enabled() && (_thread == NULL))
+	{
+		mkdir(_path.c_str(), 0755);
+
+		_stop   = false;
+		_thread = new std::thread(&sampleJournal::run, this);
+	}
+}
+
+void sampleJournal::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(_thread == NULL)
+			return;
+
+		_stop = true;
+	}
+
+	_wakeUp.notify_one();
+	_thread->join();
+	delete _thread;
+	_thread = NULL;
+
+	closeSegment();
+}
+
+// May be called from any thread (sensor callbacks, MQTT).
+void sampleJournal::add(const sensor* s, uint64_t timestamp, double value)
+{
+	std::unordered_map<const sensor*, uint16_t>::const_iterator index = _sensorIndex.find(s);
+	if(index == _sensorIndex.end())
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if((_thread == NULL) || (_buffer.size() >= _maxBuffer))
+	{
+		++_nDropped;
+		return;
+	}
+
+	journalSample sample;
+	sample.sensorIndex = index->second;
+	sample.timestamp   = timestamp;
+	sample.value       = value;
+	_buffer.push_back(sample);
+}
+
+uint64_t sampleJournal::nLost()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	uint64_t n = _nDropped + _nWriteFailures;
+	_nDropped = 0;
+	_nWriteFailures = 0;
+
+	return n;
+}
+
+size_t sampleJournal::nBuffered()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _buffer.size();
+}
+
+void sampleJournal::run()
+{
+	std::vector<journalSample> samples;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(true)
+	{
+		_wakeUp.wait_for(lock, std::chrono::milliseconds(_flushInterval));
+
+		samples.clear();
+		samples.swap(_buffer);
+		bool stopNow = _stop;
+
+		lock.unlock();
+
+		uint64_t nFailed = 0;
+		if((samples.size() > 0) && !writeSamples(samples))
+			nFailed = samples.size();
+
+		lock.lock();
+		_nWriteFailures += nFailed;
+
+		if(stopNow)
+			break;
+	}
+}
+
+bool sampleJournal::openSegment(uint64_t firstTimestamp)
+{
+	closeSegment();
+
+	char name[32];
+	snprintf(name, sizeof(name), "%013llu", static_cast<unsigned long long>(firstTimestamp));
+	std::string filename = _path + "/" + name + JOURNAL_EXTENSION;
+
+	_segment = fopen(filename.c_str(), "wb");
+	if(_segment == NULL)
+		return false;
+
+	std::string header(JOURNAL_MAGIC);
+	uint16_t nSensors = static_cast<uint16_t>(_sensorIDs.size());
+	header.append(reinterpret_cast<const char*>(&nSensors), sizeof(nSensors));
+	for(size_t i=0; i<_sensorIDs.size(); ++i)
+	{
+		uint16_t idLength = static_cast<uint16_t>(_sensorIDs[i].size());
+		header.append(reinterpret_cast<const char*>(&idLength), sizeof(idLength));
+		header.append(_sensorIDs[i], 0, idLength);
+	}
+
+	_segmentSize = fwrite(header.data(), 1, header.size(), _segment);
+
+	deleteOldSegments();
+
+	return (_segmentSize == header.size());
+}
+
+void sampleJournal::closeSegment()
+{
+	if(_segment != NULL)
+	{
+		fclose(_segment);
+		_segment = NULL;
+	}
+}
+
+void sampleJournal::deleteOldSegments()
+{
+	if(_maxSegments == 0)
+		return;
+
+	std::vector<std::string> files = segmentFiles(_path);
+	std::vector<std::string> segments;
+	for(size_t i=0; i<files.size(); ++i)
+	{
+		if(hasExtension(files[i], JOURNAL_EXTENSION))
+			segments.push_back(files[i]);
+	}
+
+	for(size_t i=0; (i + _maxSegments) < segments.size(); ++i)
+		remove(segments[i].c_str());
+}
+
+bool sampleJournal::writeSamples(const std::vector<journalSample> &samples)
+{
+	char record[JOURNAL_RECORD_SIZE];
+	bool success = true;
+
+	for(size_t i=0; i<samples.size(); ++i)
+	{
+		if((_segment == NULL) || ((_segmentSize + JOURNAL_RECORD_SIZE) > _maxSegmentSize))
+		{
+			if(!openSegment(samples[i].timestamp))
+				return false;
+		}
+
+		memcpy(record, &samples[i].sensorIndex, sizeof(uint16_t));
+		memcpy(record + sizeof(uint16_t), &samples[i].timestamp, sizeof(uint64_t));
+		memcpy(record + sizeof(uint16_t) + sizeof(uint64_t), &samples[i].value, sizeof(double));
+
+		if(fwrite(record, 1, JOURNAL_RECORD_SIZE, _segment) != JOURNAL_RECORD_SIZE)
+			success = false;
+
+		_segmentSize += JOURNAL_RECORD_SIZE;
+	}
+
+	if(fflush(_segment) != 0)
+		success = false;
+
+	return success;
+}
+
+// A single file, or all segments (and CSV files) in a directory in the order of their names.
+std::vector<std::string> sampleJournal::segmentFiles(const std::string &path)
+{
+	std::vector<std::string> files;
+
+	DIR* dir = opendir(path.c_str());
+	if(dir == NULL)
+	{
+		struct stat fileInfo;
+		if(stat(path.c_str(), &fileInfo) == 0)
+			files.push_back(path);
+
+		return files;
+	}
+
+	struct dirent* entry;
+	while((entry = readdir(dir)) != NULL)
+	{
+		std::string name(entry->d_name);
+		if(hasExtension(name, JOURNAL_EXTENSION) || hasExtension(name, CSV_EXTENSION))
+			files.push_back(path + "/" + name);
+	}
+
+	closedir(dir);
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+bool sampleJournal::readSegment(const std::string &filename, std::vector<std::string> &sensorIDs, std::vector<journalSample> &samples)
+{
+	sensorIDs.clear();
+	samples.clear();
+
+	FILE* f = fopen(filename.c_str(), "rb");
+	if(f == NULL)
+		return false;
+
+	char magic[4];
+	uint16_t nSensors = 0;
+	bool valid = (fread(magic, 1, 4, f) == 4) && (memcmp(magic, JOURNAL_MAGIC, 4) == 0);
+	valid = valid && (fread(&nSensors, sizeof(nSensors), 1, f) == 1);
+
+	for(uint16_t i=0; valid && (i<nSensors); ++i)
+	{
+		uint16_t idLength = 0;
+		valid = (fread(&idLength, sizeof(idLength), 1, f) == 1);
+
+		std::string id(idLength, '\0');
+		valid = valid && ((idLength == 0) || (fread(&id[0], 1, idLength, f) == idLength));
+		sensorIDs.push_back(id);
+	}
+
+	if(!valid)
+	{
+		fclose(f);
+		return false;
+	}
+
+	// A record that was cut off at the end is ignored.
+	char record[JOURNAL_RECORD_SIZE];
+	journalSample sample;
+	while(fread(record, 1, JOURNAL_RECORD_SIZE, f) == JOURNAL_RECORD_SIZE)
+	{
+		memcpy(&sample.sensorIndex, record, sizeof(uint16_t));
+		memcpy(&sample.timestamp, record + sizeof(uint16_t), sizeof(uint64_t));
+		memcpy(&sample.value, record + sizeof(uint16_t) + sizeof(uint64_t), sizeof(double));
+
+		if(sample.sensorIndex < nSensors)
+			samples.push_back(sample);
+	}
+
+	fclose(f);
+	return true;
+}
+
+bool sampleJournal::isCSV(const std::string &filename)
+{
+	return hasExtension(filename, CSV_EXTENSION);
+}
+
+// Local time "YYYY-MM-DD hh:mm:ss" or ms since the epoch; 0 if invalid.
+static uint64_t parseTimestamp(const std::string &text)
+{
+	int year, month, day, hour, minute, second;
+	if(sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) == 6)
+	{
+		struct tm timeinfo;
+		memset(&timeinfo, 0, sizeof(timeinfo));
+		timeinfo.tm_year  = year - 1900;
+		timeinfo.tm_mon   = month - 1;
+		timeinfo.tm_mday  = day;
+		timeinfo.tm_hour  = hour;
+		timeinfo.tm_min   = minute;
+		timeinfo.tm_sec   = second;
+		timeinfo.tm_isdst = -1;
+
+		std::time_t t = mktime(&timeinfo);
+		if(t < 0)
+			return 0;
+
+		return static_cast<uint64_t>(t) * 1000;
+	}
+
+	long ms = 0;
+	if(!parseLong(text, ms) || (ms < 0))
+		return 0;
+
+	return static_cast<uint64_t>(ms);
+}
+
+bool sampleJournal::readCSV(const std::string &filename, std::vector<std::string> &sensorIDs, std::vector<journalSample> &samples)
+{
+	sensorIDs.clear();
+	samples.clear();
+
+	std::ifstream csv(filename.c_str());
+	if(!csv.is_open())
+		return false;
+
+	std::map<std::string, uint16_t> index;
+	std::string line;
+	while(std::getline(csv, line))
+	{
+		if((line.size() == 0) || (line[0] == '#'))
+			continue;
+
+		size_t first = line.find_first_of(";,\t");
+		if(first == std::string::npos)
+			continue;
+
+		size_t second = line.find_first_of(";,\t", first + 1);
+		if(second == std::string::npos)
+			continue;
+
+		journalSample sample;
+		sample.timestamp = parseTimestamp(line.substr(0, first));
+		if(sample.timestamp == 0)
+			continue;  // e.g. header line
+
+		std::string id = line.substr(first + 1, second - first - 1);
+		std::map<std::string, uint16_t>::iterator i = index.find(id);
+		if(i == index.end())
+		{
+			i = index.insert(std::make_pair(id, static_cast<uint16_t>(sensorIDs.size()))).first;
+			sensorIDs.push_back(id);
+		}
+		sample.sensorIndex = i->second;
+
+		if(!parseDouble(std::string_view(line).substr(second + 1), sample.value))
+			continue;
+
+		samples.push_back(sample);
+	}
+
+	// Replay in chronological order:
+	std::stable_sort(samples.begin(), samples.end(), [](const journalSample &a, const journalSample &b) { return a.timestamp < b.timestamp; });
+
+	return true;
+}
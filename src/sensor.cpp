@@ -1,9 +1,12 @@
 #include "sensor.h"
 
+#include "sensorlogger.h"
 #include "counter.h"
 #include "logger.h"
 #include "measurements.h"
 #include "json.h"
+#include "metrics.h"
+#include "trace.h"
 
 #include <algorithm>
 
@@ -11,6 +14,8 @@ sensor::sensor()
 {
 	resetReadFailures();
 	_keepValuesFor_ms = 0;
+	_nTruncatedReported = 0;
+	_timestamp_lastTruncationWarning = 0;
 	setCounter(false);
 	setTriggerEvent(periodic);
 
@@ -19,6 +24,7 @@ sensor::sensor()
 	setRetryTime(0);
 	_lastValuePublished = false;
 	_timestamp_lastMeasurement = 0;
+	_metricSamples = NULL;
 }
 
 sensor::~sensor()
@@ -33,6 +39,7 @@ sensor::~sensor()
 void sensor::clean(uint64_t currentTimestamp)
 {
 	_m->clean(currentTimestamp - _keepValuesFor_ms);
+	_m->cleanRollups(currentTimestamp);
 }
 
 void sensor::accumulateMaxTimeToKeep(uint64_t timeToKeep)
@@ -41,6 +48,79 @@ void sensor::accumulateMaxTimeToKeep(uint64_t timeToKeep)
 		_keepValuesFor_ms = timeToKeep;
 }
 
+void sensor::accumulateRollupTimeToKeep(rollupTier tier, uint64_t timeToKeep)
+{
+	_m->accumulateRollupTimeToKeep(tier, timeToKeep);
+}
+
+size_t sensor::requiredCapacity() const
+{
+	if(isCounter())  // only the last value is kept
+		return 1;
+
+	uint64_t restPeriod = std::max(_minimumRestPeriod, static_cast<uint64_t>(1));
+	size_t capacity = static_cast<size_t>(_keepValuesFor_ms / restPeriod) + 2;
+
+	// The oldest compressed block is only removed once all of its values
+	// have expired; room for them saves re-encoding it.
+	if(_m->getCompression())
+		capacity += SAMPLEBLOCK_SIZE;
+
+	return capacity;
+}
+
+void sensor::setCapacity(size_t capacity)
+{
+	_m->setCapacity(capacity);
+}
+
+void sensor::setCompression(bool compress)
+{
+	_m->setCompression(compress);
+}
+
+size_t sensor::bytesPerMeasurement() const
+{
+	return _m->bytesPerMeasurement();
+}
+
+size_t sensor::memoryUsage() const
+{
+	return _m->memoryUsage() + _m->plannedRollupMemory();
+}
+
+size_t sensor::getCapacity() const
+{
+	return _m->getCapacity();
+}
+
+size_t sensor::plannedMemory() const
+{
+	return _m->getCapacity() * _m->bytesPerMeasurement() + _m->plannedRollupMemory();
+}
+
+uint64_t sensor::nTruncated() const
+{
+	return _m->nTruncated();
+}
+
+void sensor::checkTruncation(uint64_t currentTimestamp)
+{
+	uint64_t nTruncatedNow = _m->nTruncated();
+	if(nTruncatedNow > _nTruncatedReported)
+	{
+		if((_timestamp_lastTruncationWarning == 0) || (timeDiff(currentTimestamp, _timestamp_lastTruncationWarning) >= TRUNCATION_WARNING_INTERVAL))
+		{
+			std::stringstream ss;
+			ss << "Sensor " << _sensorID << ": " << (nTruncatedNow - _nTruncatedReported) << " measurements dropped because the capacity of " << _m->getCapacity() << " measurements was reached. Statistics of long evaluation periods are incomplete.";
+			_root->warning(ss.str());
+
+			_nTruncatedReported = nTruncatedNow;
+			_timestamp_lastTruncationWarning = currentTimestamp;
+		}
+	}
+}
+
 counter* sensor::newCounter()
 {
 	counter* c = new counter(_root->currentTimestamp());
@@ -48,6 +128,21 @@ counter* sensor::newCounter()
 	return c;
 }
 
+size_t sensor::nCounters() const
+{
+	return _counters.size();
+}
+
+counter* sensor::getCounter(size_t i)
+{
+	return _counters.at(i);
+}
+
+measurements* sensor::getMeasurements()
+{
+	return _m;
+}
+
 void sensor::setPointerToLogger(logger* root)
 {
 	_root = root;
@@ -99,6 +194,11 @@ void sensor::setHomematicPublishISE(const std::string &homematicPublishISE)
 	_homematicPublishISE = homematicPublishISE;
 }
 
+void sensor::setNumberFormat(const numberFormat &format)
+{
+	_format = format;
+}
+
 void sensor::addJSONkey(const std::string &key)
 {
 	if(key.size() > 0)
@@ -176,6 +276,25 @@ std::string sensor::getMQTTPublishTopic() const
 	return _mqttPublishTopic;
 }
 
+readTelemetry* sensor::telemetry()
+{
+	return &_telemetry;
+}
+
+void sensor::setSampleMetric(metricCounter* samples)
+{
+	_metricSamples = samples;
+}
+
+void sensor::recordRead(read_result result, uint64_t startTime, int errorCode)
+{
+	uint64_t latency = timeDiff(_root->monotonicTimestamp(), startTime);
+	if(result == read_ok)
+		_telemetry.record(result, latency, 0, 0);
+	else
+		_telemetry.record(result, latency, errorCode, _root->currentTimestamp());
+}
+
 uint64_t sensor::getReadFailures() const
 {
 	return _nReadFailures;
@@ -212,19 +331,11 @@ void sensor::resetCounters()
 		_counters.at(i)->reset(currentTimestamp);
 }
 
-/*
-void sensor::count()
-{
-	uint64_t currentTimestamp = _root->currentTimestamp();
-	count(currentTimestamp);
-}
-*/
-
-void sensor::count(uint64_t currentTimestamp)
+void sensor::count(uint64_t eventTime)
 {
 	// Increase count for all counters:
 	for(size_t i=0; i<_counters.size(); ++i)
-		_counters.at(i)->count(currentTimestamp);
+		_counters.at(i)->count(eventTime);
 }
 
 size_t sensor::nMeasurements() const
@@ -234,7 +345,20 @@ size_t sensor::nMeasurements() const
 
 bool sensor::addRawMeasurement(double value)
 {
-	uint64_t currentTimestamp = _root->currentTimestamp();
+	return addRawMeasurement(value, _root->currentTimestamp());
+}
+
+bool sensor::addRawMeasurement(double value, uint64_t currentTimestamp)
+{
+	return addRawMeasurement(value, currentTimestamp, _root->monotonicTimestamp());
+}
+
+/* Event sources that know when an event happened (e.g. an input
+   callback) pass both times, taken as early as possible. The monotonic
+   event time gives counters the exact distance between pulses,
+   independent of the rest period's time slots. */
+bool sensor::addRawMeasurement(double value, uint64_t currentTimestamp, uint64_t eventTime)
+{
 	resetReadFailures();
 
 	if(timeDiff(_timestamp_lastMeasurement, currentTimestamp) >= _minimumRestPeriod)
@@ -245,7 +369,13 @@ bool sensor::addRawMeasurement(double value)
 		_timestamp_lastMeasurement = currentTimeslot;
 		clean(currentTimeslot);
 
-		count(currentTimeslot);
+		_root->recordSample(this, currentTimestamp, value);
+
+		metricCounter* samples = _metricSamples.load(std::memory_order_relaxed);
+		if(samples != NULL)
+			samples->add();
+
+		count(eventTime);
 
 		double convertedValue = _factor * (value + _offset);
 
@@ -256,6 +386,7 @@ bool sensor::addRawMeasurement(double value)
 		else
 		{
 			_m->addValue(convertedValue, currentTimeslot);
+			checkTruncation(currentTimeslot);
 		}
 		
 		_lastValuePublished = false;
@@ -271,6 +402,11 @@ std::vector<double>* sensor::valuesInConfidence(uint64_t startTimestamp, double
 	return _m->valuesInConfidence(startTimestamp, absolute, nSigma);
 }
 
+rollup sensor::rollupStatistics(rollupTier tier, uint64_t startTimestamp) const
+{
+	return _m->rollupStatistics(tier, startTimestamp);
+}
+
 void sensor::reset()
 {
 	_m->clear();
@@ -286,9 +422,8 @@ void sensor::publishLastEvent()
 {
 	if(!_lastValuePublished)
 	{
-		std::stringstream ssPayload;
-		ssPayload << getLastValue();
-		std::string payload = ssPayload.str();
+		TRACE_SCOPE("publish", _sensorID);
+		std::string payload = _format.format(getLastValue());
 
 		if(_mqttPublishTopic.size() > 0)
 		{
@@ -3,6 +3,7 @@
 #include "logger.h"
 #include "homematic.h"
 #include "measurements.h"
+#include "trace.h"
 
 sensorHomematic::sensorHomematic(logger* root, homematic* hmPtr, const std::string &sensorID, const std::string &mqttPublishTopic, const std::string &homematicPublishISE, const std::string &homematicSubscribeISE, bool isCounter, double factor, double offset, uint64_t minimumRestPeriod, uint64_t retryTime)
 {
@@ -39,10 +40,12 @@ bool sensorHomematic::measure(uint64_t currentTimestamp)
 {
 	if(timeDiff(_timestamp_lastMeasurement, currentTimestamp) >= _minimumRestPeriod)
 	{
+		TRACE_SCOPE("measure", _sensorID);
 		clean(currentTimestamp);
 
 		if(_homematic != NULL)
 		{
+			uint64_t startTime = _root->monotonicTimestamp();
 			try
 			{
 				std::string valueString = _homematic->getValue(_iseID);
@@ -52,15 +55,17 @@ bool sensorHomematic::measure(uint64_t currentTimestamp)
 				if(valueString.size() > 0)
 					value = atof(valueString.c_str());
 
+				recordRead(read_ok, startTime);
 				return addRawMeasurement(value);
 			}
 			catch(int e)
 			{
+				recordRead((e == E_HTTP_TIMEOUT) ? read_timeout : read_error, startTime, e);
 				addReadFailure();
 
 				// homematic::getValue already reports errors.
 				// Only report other errors here...
-				if(e != E_CANNOT_READ_HM_SYSVAR)
+				if((e != E_CANNOT_READ_HM_SYSVAR) && (e != E_HTTP_TIMEOUT))
 					_root->error("Cannot read HomeMatic system variable for sensor: " + _sensorID);
 			}
 		}
@@ -4,6 +4,7 @@
 #include "readoutbuffer.h"
 #include "logger.h"
 #include "measurements.h"
+#include "trace.h"
 
 sensorJSON::sensorJSON(logger* root, const std::string &sensorID, const std::string &mqttPublishTopic, const std::string &homematicPublishISE, const std::string &jsonFile, const std::vector<std::string>* jsonKeys, bool isCounter, double factor, double offset, uint64_t minimumRestPeriod, uint64_t retryTime, readoutBuffer* buffer)
 {
@@ -36,8 +37,10 @@ bool sensorJSON::measure(uint64_t currentTimestamp)
 {
 	if(timeDiff(_timestamp_lastMeasurement, currentTimestamp) >= _minimumRestPeriod)
 	{
+		TRACE_SCOPE("measure", _sensorID);
 		clean(currentTimestamp);
 
+		uint64_t startTime = _root->monotonicTimestamp();
 		try
 		{
 			if(_jsonKey.size() > 0)
@@ -53,11 +56,13 @@ bool sensorJSON::measure(uint64_t currentTimestamp)
 				}
 
 				double value = node->value()->getDouble();
+				recordRead(read_ok, startTime);
 				return addRawMeasurement(value);
 			}
 		}
 		catch(int e)
 		{
+			recordRead((e == E_HTTP_TIMEOUT) ? read_timeout : read_error, startTime, e);
 			addReadFailure();
 			_root->error("Cannot read JSON sensor: " + _sensorID);
 		}
@@ -24,7 +24,7 @@ sensor_type sensorMQTT::type() const
 	return sensor_mqtt;
 }
 
-std::string sensorMQTT::getMQTTSubscribeTopic() const
+const std::string& sensorMQTT::getMQTTSubscribeTopic() const
 {
 	return _mqttSubscribeTopic;
 }
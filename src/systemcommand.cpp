@@ -0,0 +1,129 @@
+#include "systemcommand.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+systemCommand::systemCommand()
+{
+	_pid = -1;
+	_outputPipe = -1;
+	_exitStatus = -1;
+}
+
+systemCommand::~systemCommand()
+{
+	// A command that is still running is left alone;
+	// it might be the one that restarts the system.
+	closePipe();
+	if(_pid > 0)
+		waitpid(_pid, NULL, WNOHANG);
+}
+
+void systemCommand::closePipe()
+{
+	if(_outputPipe >= 0)
+	{
+		close(_outputPipe);
+		_outputPipe = -1;
+	}
+}
+
+bool systemCommand::start(const std::string &command)
+{
+	if(_pid > 0)
+		return false;
+
+	_command = command;
+	_output.clear();
+	_exitStatus = -1;
+
+	int fds[2];
+	if(pipe2(fds, O_CLOEXEC) != 0)
+		return false;
+
+	pid_t pid = fork();
+	if(pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if(pid == 0)
+	{
+		// Child: only async-signal-safe calls until exec.
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		execl("/bin/sh", "sh", "-c", _command.c_str(), (char*)NULL);
+		_exit(127);
+	}
+
+	close(fds[1]);
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+	_pid = pid;
+	_outputPipe = fds[0];
+	return true;
+}
+
+void systemCommand::readOutput()
+{
+	if(_outputPipe < 0)
+		return;
+
+	char buffer[4096];
+	while(true)
+	{
+		ssize_t n = read(_outputPipe, buffer, sizeof(buffer));
+		if(n > 0)
+			_output.append(buffer, static_cast<size_t>(n));
+		else if((n < 0) && (errno == EINTR))
+			continue;
+		else
+		{
+			if(n == 0)  // all writers are gone
+				closePipe();
+			break;
+		}
+	}
+}
+
+bool systemCommand::running()
+{
+	if(_pid <= 0)
+		return false;
+
+	readOutput();
+
+	int status = 0;
+	pid_t result = waitpid(_pid, &status, WNOHANG);
+	if(result == 0)
+		return true;
+
+	if((result == _pid) && WIFEXITED(status))
+		_exitStatus = WEXITSTATUS(status);
+
+	_pid = -1;
+
+	// Whatever the command wrote before it exited:
+	readOutput();
+	closePipe();
+	return false;
+}
+
+const std::string& systemCommand::command() const
+{
+	return _command;
+}
+
+const std::string& systemCommand::output() const
+{
+	return _output;
+}
+
+int systemCommand::exitStatus() const
+{
+	return _exitStatus;
+}
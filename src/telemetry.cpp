@@ -0,0 +1,130 @@
+#include "telemetry.h"
+#include "numberformat.h"
+
+#include <vector>
+#include <algorithm>
+#include <sstream>
+
+readTelemetry::readTelemetry()
+{
+	_nOK = 0;
+	_nTimeouts = 0;
+	_nErrors = 0;
+	_lastError = 0;
+	_timestamp_lastError = 0;
+
+	_nReads = 0;
+	_sumLatency = 0;
+	_maxLatency = 0;
+}
+
+void readTelemetry::record(read_result result, uint64_t latency, int errorCode, uint64_t currentTimestamp)
+{
+	if(result == read_ok)
+	{
+		_nOK.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		if(result == read_timeout)
+			_nTimeouts.fetch_add(1, std::memory_order_relaxed);
+		else
+			_nErrors.fetch_add(1, std::memory_order_relaxed);
+
+		_lastError.store(errorCode, std::memory_order_relaxed);
+		_timestamp_lastError.store(currentTimestamp, std::memory_order_relaxed);
+	}
+
+	_nReads.fetch_add(1, std::memory_order_relaxed);
+	_sumLatency.fetch_add(latency, std::memory_order_relaxed);
+	_latencies.add(latency);
+
+	uint64_t maxLatency = _maxLatency.load(std::memory_order_relaxed);
+	while((latency > maxLatency)
+		&& !_maxLatency.compare_exchange_weak(maxLatency, latency, std::memory_order_relaxed))
+	{ }
+}
+
+uint64_t readTelemetry::nReads() const
+{
+	return _nOK + _nTimeouts + _nErrors;
+}
+
+// Reads that are recorded while the report is taken
+// may end up in this or the next report interval.
+void readTelemetry::report(readReport &r)
+{
+	r.nOK       = _nOK;
+	r.nTimeouts = _nTimeouts;
+	r.nErrors   = _nErrors;
+	r.lastError = _lastError;
+	r.timestamp_lastError = _timestamp_lastError;
+	r.nTruncated = 0;
+
+	r.nReads = _nReads.exchange(0);
+	uint64_t sumLatency = _sumLatency.exchange(0);
+	uint64_t maxLatency = _maxLatency.exchange(0);
+
+	std::vector<uint64_t> merged;
+	_latencies.addTo(merged);
+	_latencies.clear();
+
+	r.meanLatency = 0;
+	if(r.nReads > 0)
+		r.meanLatency = 0.001 * static_cast<double>(sumLatency) / static_cast<double>(r.nReads);
+
+	// Percentiles are bucket centers; they must not exceed the maximum:
+	r.maxLatency  = 0.001 * static_cast<double>(maxLatency);
+	r.latency_p50 = std::min(0.001 * intervalHistogram::quantile(merged, 0.50), r.maxLatency);
+	r.latency_p95 = std::min(0.001 * intervalHistogram::quantile(merged, 0.95), r.maxLatency);
+}
+
+std::string readReport::summary() const
+{
+	numberFormat ms;
+	ms.setDecimals(1);
+
+	std::stringstream ss;
+	ss << nReads << " reads";
+	if(nReads > 0)
+	{
+		ss << ", latency mean " << ms.format(meanLatency) << " ms";
+		ss << ", p50 " << ms.format(latency_p50) << " ms";
+		ss << ", p95 " << ms.format(latency_p95) << " ms";
+		ss << ", max " << ms.format(maxLatency) << " ms";
+	}
+
+	ss << ". Total: " << nOK << " ok, " << nTimeouts << " timeouts, " << nErrors << " errors";
+	if(lastError != 0)
+		ss << ", last error " << lastError;
+	if(nTruncated > 0)
+		ss << ", " << nTruncated << " measurements truncated";
+	ss << ".";
+
+	return ss.str();
+}
+
+std::string readReport::json() const
+{
+	numberFormat ms;
+	ms.setDecimals(3);
+
+	std::string payload = "{\"reads\":" + std::to_string(nReads);
+	payload += ",\"latency_ms\":{\"mean\":";
+	ms.append(meanLatency, payload);
+	payload += ",\"p50\":";
+	ms.append(latency_p50, payload);
+	payload += ",\"p95\":";
+	ms.append(latency_p95, payload);
+	payload += ",\"max\":";
+	ms.append(maxLatency, payload);
+	payload += "},\"ok\":" + std::to_string(nOK);
+	payload += ",\"timeouts\":" + std::to_string(nTimeouts);
+	payload += ",\"errors\":" + std::to_string(nErrors);
+	payload += ",\"last_error\":" + std::to_string(lastError);
+	payload += ",\"last_error_time\":" + std::to_string(timestamp_lastError / 1000);
+	payload += ",\"truncated\":" + std::to_string(nTruncated);
+	payload += "}";
+
+	return payload;
+}
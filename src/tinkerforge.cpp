@@ -1,16 +1,35 @@
 #ifdef OPTION_TINKERFORGE
 
 #include "tinkerforge.h"
+#include "tinkerforge_devices.h"
+#include "trace.h"
 
 #include "logger.h"
+#include "measurements.h"
 #include "sensor_tinkerforge.h"
 #include "sensorlogger.h"
+#include "systemcommand.h"
+#include "workerpool.h"
 
 tinkerforge::tinkerforge(logger* root)
 {
 	_root = root;
 	_ipcon = NULL;
 	_timeout = DEFAULT_TINKERFORGE_TIMEOUT;
+	_enumerating = false;
+	_enumerationTimeout = DEFAULT_ENUMERATION_TIMEOUT;
+	_timestamp_enumerationStart = 0;
+	_pollThreads = DEFAULT_TINKERFORGE_POLL_THREADS;
+	_pollPool = NULL;
+	_pollingConcurrently = false;
+	_maxReadFailures = DEFAULT_MAX_BRICKLET_READ_FAILURES;
+	_maxRestartAttempts = DEFAULT_MAX_BRICKD_RESTART_ATTEMPTS;
+	_restartAttemptCounter = 0;
+	_recoveryState = recovery_idle;
+	_recoveryCommand = NULL;
+	_recoveryBackoff = 0;
+	_timestamp_recoveryEnd = 0;
+	_port = 4223;
 	disconnect_and_prepare();
 }
 
@@ -19,6 +38,20 @@ tinkerforge::tinkerforge(logger*root, const std::string &host, unsigned short po
 	_root = root;
 	_ipcon = NULL;
 	_timeout = DEFAULT_TINKERFORGE_TIMEOUT;
+	_enumerating = false;
+	_enumerationTimeout = DEFAULT_ENUMERATION_TIMEOUT;
+	_timestamp_enumerationStart = 0;
+	_pollThreads = DEFAULT_TINKERFORGE_POLL_THREADS;
+	_pollPool = NULL;
+	_pollingConcurrently = false;
+	_maxReadFailures = DEFAULT_MAX_BRICKLET_READ_FAILURES;
+	_maxRestartAttempts = DEFAULT_MAX_BRICKD_RESTART_ATTEMPTS;
+	_restartAttemptCounter = 0;
+	_recoveryState = recovery_idle;
+	_recoveryCommand = NULL;
+	_recoveryBackoff = 0;
+	_timestamp_recoveryEnd = 0;
+	_port = 4223;
 	disconnect_and_prepare();
 
 	setHost(host);
@@ -27,9 +60,21 @@ tinkerforge::tinkerforge(logger*root, const std::string &host, unsigned short po
 
 tinkerforge::~tinkerforge()
 {
-	ipcon_disconnect(_ipcon);
-	ipcon_destroy(_ipcon);
-	delete _ipcon;
+	if(_pollPool != NULL)
+		delete _pollPool;
+
+	if(_recoveryCommand != NULL)
+		delete _recoveryCommand;
+
+	disconnect();
+
+	for(std::unordered_map<std::string, tfBricklet*>::iterator it = _bricklets.begin(); it != _bricklets.end(); ++it)
+		delete it->second;
+}
+
+void tinkerforge::setName(const std::string &name)
+{
+	_name = name;
 }
 
 void tinkerforge::setHost(const std::string &host)
@@ -42,6 +87,44 @@ void tinkerforge::setPort(unsigned short port)
 	_port = port;
 }
 
+void tinkerforge::setMaxReadFailures(unsigned maxReadFailures)
+{
+	_maxReadFailures = maxReadFailures;
+}
+
+void tinkerforge::setMaxRestartAttempts(unsigned maxRestartAttempts)
+{
+	_maxRestartAttempts = maxRestartAttempts;
+}
+
+void tinkerforge::setRestartCommand(const std::string &command)
+{
+	_cmdRestart = command;
+}
+
+void tinkerforge::setSystemRestartCommand(const std::string &command)
+{
+	_cmdRestartSystem = command;
+}
+
+void tinkerforge::setEnumerationTimeout(uint64_t enumerationTimeout)
+{
+	_enumerationTimeout = enumerationTimeout;
+}
+
+std::string tinkerforge::getName() const
+{
+	if(_name.size() > 0)
+		return _name;
+
+	return _host + ":" + std::to_string(_port);
+}
+
+logger* tinkerforge::ptLogger() const
+{
+	return _root;
+}
+
 std::string tinkerforge::getHost() const
 {
 	return _host;
@@ -52,11 +135,405 @@ unsigned short tinkerforge::getPort() const
 	return _port;
 }
 
+unsigned tinkerforge::getMaxReadFailures() const
+{
+	return _maxReadFailures;
+}
+
+unsigned tinkerforge::getMaxRestartAttempts() const
+{
+	return _maxRestartAttempts;
+}
+
+const std::string& tinkerforge::getRestartCommand() const
+{
+	return _cmdRestart;
+}
+
+const std::string& tinkerforge::getSystemRestartCommand() const
+{
+	return _cmdRestartSystem;
+}
+
+unsigned tinkerforge::restartAttempts() const
+{
+	return _restartAttemptCounter;
+}
+
+void tinkerforge::resetRestartAttempts()
+{
+	_restartAttemptCounter = 0;
+}
+
+bool tinkerforge::recovering() const
+{
+	return (_recoveryState != recovery_idle);
+}
+
+bool tinkerforge::startRecovery(const std::string &command, bool systemRestart, uint64_t currentTimestamp)
+{
+	if(_recoveryState != recovery_idle)
+		return false;
+
+	if(_recoveryCommand == NULL)
+		_recoveryCommand = new systemCommand();
+
+	_root->info("Execute system command: " + command);
+	if(!_recoveryCommand->start(command))
+	{
+		_root->error("Executing the command failed.");
+		return false;
+	}
+
+	if(systemRestart)
+	{
+		_recoveryBackoff = BRICKD_RECOVERY_BACKOFF;
+	}
+	else
+	{
+		// Exponential backoff: each further restart waits twice as long.
+		_recoveryBackoff = BRICKD_RECOVERY_BACKOFF;
+		for(unsigned i=0; (i<_restartAttemptCounter) && (_recoveryBackoff < BRICKD_RECOVERY_MAX_BACKOFF); ++i)
+			_recoveryBackoff *= 2;
+
+		if(_recoveryBackoff > BRICKD_RECOVERY_MAX_BACKOFF)
+			_recoveryBackoff = BRICKD_RECOVERY_MAX_BACKOFF;
+
+		++_restartAttemptCounter;
+	}
+
+	_timestamp_recoveryEnd = currentTimestamp;
+	_recoveryState = recovery_running;
+	return true;
+}
+
+void tinkerforge::updateRecovery(uint64_t currentTimestamp)
+{
+	if(_recoveryState == recovery_running)
+	{
+		if(_recoveryCommand->running())
+			return;
+
+		if(_recoveryCommand->output().size() > 0)
+			_root->info(_recoveryCommand->output());
+
+		if(_recoveryCommand->exitStatus() != 0)
+			_root->error("Command \'" + _recoveryCommand->command() + "\' failed with exit status " + std::to_string(_recoveryCommand->exitStatus()) + ".");
+
+		std::stringstream ss;
+		ss << "Waiting " << (_recoveryBackoff / 1000) << " s before Bricklets at " << getName() << " are polled again.";
+		_root->info(ss.str());
+
+		_timestamp_recoveryEnd = currentTimestamp;
+		_recoveryState = recovery_backoff;
+	}
+	else if(_recoveryState == recovery_backoff)
+	{
+		if(timeDiff(_timestamp_recoveryEnd, currentTimestamp) >= _recoveryBackoff)
+		{
+			_timestamp_recoveryEnd = currentTimestamp;
+			_recoveryState = recovery_idle;
+			_root->info("Polling Bricklets at " + getName() + " again.");
+		}
+	}
+	else if((_restartAttemptCounter > 0) && (timeDiff(_timestamp_recoveryEnd, currentTimestamp) >= BRICKD_HEALTHY_PERIOD))
+	{
+		_restartAttemptCounter = 0;
+	}
+}
+
+uint64_t tinkerforge::getEnumerationTimeout() const
+{
+	return _enumerationTimeout;
+}
+
+void tinkerforge::setPollThreads(unsigned pollThreads)
+{
+	if(pollThreads < 1)
+		pollThreads = 1;
+
+	_pollThreads = pollThreads;
+}
+
+unsigned tinkerforge::getPollThreads() const
+{
+	return _pollThreads;
+}
+
+void tinkerforge::addSensor(sensorTinkerforge* s)
+{
+	// Only called while the configuration is loaded,
+	// the index is read-only once connections are made.
+	tfBricklet* &bricklet = _bricklets[s->getUID()];
+	if(bricklet == NULL)
+	{
+		bricklet = new tfBricklet();
+		bricklet->uid    = s->getUID();
+		bricklet->daemon = this;
+		bricklet->driver = NULL;
+		bricklet->device = NULL;
+		bricklet->configured = false;
+	}
+
+	bricklet->sensors.push_back(s);
+}
+
+void tinkerforge::deviceEnumerated(const std::string &uid, uint16_t device_identifier, uint8_t enumeration_type)
+{
+	if(enumeration_type == IPCON_ENUMERATION_TYPE_DISCONNECTED)
+	{
+		_root->warning("Bricklet \'" + uid + "\' has been disconnected from " + getName() + ".");
+		return;
+	}
+
+	if(device_identifier <= 20)  // Bricks
+		return;
+
+	std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.find(uid);
+
+	// A Bricklet that has just been connected or restarted has lost its configuration:
+	if((enumeration_type == IPCON_ENUMERATION_TYPE_CONNECTED) && (it != _bricklets.end()))
+		it->second->configured = false;
+
+	std::stringstream ss;
+	ss<<"Found Bricklet \'"<<uid<<"\' with device identifier "<<getDeviceType_nice(device_identifier) <<" at "<<getName()<<".";
+	_root->info(ss.str());
+
+	if(it == _bricklets.end())
+		return;
+
+	const std::vector<sensorTinkerforge*> &sensors = it->second->sensors;
+	for(size_t i=0; i<sensors.size(); ++i)
+	{
+		sensorTinkerforge* tfsensor = sensors.at(i);
+		if(!tfsensor->bindDaemon(this))
+		{
+			std::stringstream bss;
+			bss << "  Bricklet \'" << uid << "\' is already read from " << tfsensor->getDaemon()->getName() << ".";
+			_root->warning(bss.str());
+			continue;
+		}
+
+		tfsensor->setDeviceType(static_cast<unsigned>(device_identifier));
+		if(tfsensor->getTriggerEvent() != periodic)
+		{
+			std::stringstream cbss;
+			cbss << "  Register callback for Bricklet \'" << tfsensor->getUID() << "\' (" << getDeviceType_name(tfsensor->getDeviceType()) << "), debounce period: "<< tfsensor->getDebounceTime() << " ms.";
+			_root->info(cbss.str());
+
+			tfsensor->registerCallback();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_enumerationMutex);
+		_enumeratedUIDs.insert(uid);
+	}
+	checkEnumeration();
+}
+
+// A UID needs no more waiting if this daemon has found it or
+// all of its sensors are read from another daemon.
+bool tinkerforge::isResolved(const tfBricklet* bricklet) const
+{
+	if(_enumeratedUIDs.count(bricklet->uid) > 0)
+		return true;
+
+	for(size_t i=0; i<bricklet->sensors.size(); ++i)
+	{
+		tinkerforge* daemon = bricklet->sensors.at(i)->getDaemon();
+		if((daemon == NULL) || (daemon == this))
+			return false;
+	}
+
+	return true;
+}
+
+bool tinkerforge::isEnumerated(const std::string &uid)
+{
+	std::lock_guard<std::mutex> lock(_enumerationMutex);
+	return (_enumeratedUIDs.count(uid) > 0);
+}
+
+bool tinkerforge::enumerationPending()
+{
+	checkEnumeration();
+
+	std::lock_guard<std::mutex> lock(_enumerationMutex);
+	return _enumerating;
+}
+
+void tinkerforge::checkEnumeration()
+{
+	std::lock_guard<std::mutex> lock(_enumerationMutex);
+	if(!_enumerating)
+		return;
+
+	bool complete = true;
+	for(std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.begin(); it != _bricklets.end(); ++it)
+	{
+		if(!isResolved(it->second))
+		{
+			complete = false;
+			break;
+		}
+	}
+
+	uint64_t duration = timeDiff(_timestamp_enumerationStart, _root->currentTimestamp());
+	if(complete)
+	{
+		_enumerating = false;
+
+		std::stringstream ss;
+		ss << "Enumeration of Tinkerforge Bricklets at " << getName() << " done after " << duration << " ms.";
+		_root->info(ss.str());
+	}
+	else if(duration >= _enumerationTimeout)
+	{
+		_enumerating = false;
+
+		std::stringstream ss;
+		ss << "Enumeration of Tinkerforge Bricklets at " << getName() << " timed out after " << _enumerationTimeout << " ms. Bricklets not found:";
+		for(std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.begin(); it != _bricklets.end(); ++it)
+		{
+			if(!isResolved(it->second))
+				ss << " \'" << it->first << "\'";
+		}
+		_root->warning(ss.str());
+	}
+}
+
+void* tinkerforge::device(tfBricklet* bricklet, const tfDeviceDriver* driver)
+{
+	std::lock_guard<std::mutex> lock(_devicesMutex);
+	if(bricklet->driver != driver)
+	{
+		// The device identifier has changed since the handle was created:
+		if(bricklet->device != NULL)
+			bricklet->driver->destroy(bricklet->device);
+
+		bricklet->device = NULL;
+		bricklet->driver = driver;
+	}
+
+	if(bricklet->device == NULL)
+	{
+		bricklet->device = driver->create(bricklet->uid.c_str(), _ipcon);
+		bricklet->configured = false;
+	}
+
+	return bricklet->device;
+}
+
+// Device handles must be destroyed before their IP connection.
+void tinkerforge::destroyDevices()
+{
+	std::lock_guard<std::mutex> lock(_devicesMutex);
+	for(std::unordered_map<std::string, tfBricklet*>::iterator it = _bricklets.begin(); it != _bricklets.end(); ++it)
+	{
+		if(it->second->device != NULL)
+		{
+			it->second->driver->destroy(it->second->device);
+			it->second->device = NULL;
+		}
+	}
+}
+
+int tinkerforge::read(sensorTinkerforge* s, const tfDeviceDriver* driver, double &value)
+{
+	std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.find(s->getUID());
+	if(it == _bricklets.end())
+		return E_INVALID_UID;
+
+	TRACE_SCOPE("brickd.read", it->first);
+
+	void* d = device(it->second, driver);
+	if(!it->second->configured)
+	{
+		int result = configure(it->second, driver, d);
+		if(result < 0)
+			return result;
+	}
+
+	tfChannel channel = {s->getChannel(), s->getBitMask(), s->getIOPort()};
+	return driver->read(d, channel, value);
+}
+
+// Sets up averaging on the Bricklet, as requested by the first of its
+// sensors that has oversampling settings.
+int tinkerforge::configure(tfBricklet* bricklet, const tfDeviceDriver* driver, void* d)
+{
+	tfOversampling oversampling = {0, 0};
+	for(size_t i=0; i<bricklet->sensors.size(); ++i)
+	{
+		sensorTinkerforge* s = bricklet->sensors.at(i);
+		if((s->getDaemon() == this) && ((s->getAveraging() > 0) || (s->getSampleRate() > 0)))
+		{
+			oversampling.averaging  = s->getAveraging();
+			oversampling.sampleRate = s->getSampleRate();
+			break;
+		}
+	}
+
+	if((oversampling.averaging == 0) && (oversampling.sampleRate == 0))
+	{
+		bricklet->configured = true;
+		return E_OK;
+	}
+
+	std::string bricklet_name = "Bricklet \'" + bricklet->uid + "\' (" + getDeviceType_name(driver->deviceIdentifier) + "):";
+
+	// Each setting on its own, so that one the Bricklet does not
+	// support does not keep the other one from being applied:
+	std::vector<std::string> applied, unsupported;
+	tfOversampling settings[2] = {{oversampling.averaging, 0}, {0, oversampling.sampleRate}};
+	for(size_t i=0; i<2; ++i)
+	{
+		if((settings[i].averaging == 0) && (settings[i].sampleRate == 0))
+			continue;
+
+		std::string name;
+		if(settings[i].averaging > 0)
+			name = " averaging " + std::to_string(settings[i].averaging);
+		else
+			name = " sample rate " + std::to_string(settings[i].sampleRate) + "/s";
+
+		int result = driver->configure(d, settings[i]);
+		if(result == E_NOT_SUPPORTED)
+			unsupported.push_back(name);  // not worth another attempt
+		else if(result < 0)
+			return result;
+		else
+			applied.push_back(name);
+	}
+
+	for(size_t i=0; i<unsupported.size(); ++i)
+		_root->warning(bricklet_name + unsupported.at(i) + " is not supported.");
+
+	for(size_t i=0; i<applied.size(); ++i)
+		_root->info(bricklet_name + applied.at(i) + " configured.");
+
+	bricklet->configured = true;
+	return E_OK;
+}
+
+int tinkerforge::enableCallback(sensorTinkerforge* s, const tfDeviceDriver* driver)
+{
+	std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.find(s->getUID());
+	if(it == _bricklets.end())
+		return E_INVALID_UID;
+
+	tfCallbackSettings settings = {s->getChannel(), s->getIOPort(), s->getDebounceTime(), static_cast<uint32_t>(s->getMinimumRestPeriod())};
+	return driver->enableCallback(device(it->second, driver), settings, it->second);
+}
+
 bool tinkerforge::disconnect()
 {
 	if(_ipcon != NULL)
 	{
+		// Stops the callback thread, which might be using a handle:
 		ipcon_disconnect(_ipcon);
+		destroyDevices();
 		ipcon_destroy(_ipcon);
 		delete _ipcon;
 	}
@@ -79,10 +556,18 @@ bool tinkerforge::disconnect_and_prepare()
 
 bool tinkerforge::reconnect()
 {
+	// Nothing to connect to while the Brick Daemon is restarted:
+	if(_recoveryState != recovery_idle)
+		return false;
+
+	if(_pollingConcurrently)
+		return (ipcon_get_connection_state(_ipcon) == IPCON_CONNECTION_STATE_CONNECTED);
+
 	if(_host.size() > 0)
 	{
 		if(ipcon_get_connection_state(_ipcon) == IPCON_CONNECTION_STATE_DISCONNECTED)
 		{
+			TRACE_SCOPE("brickd.connect", getName());
 			disconnect_and_prepare();
 
 			// Connect to brickd
@@ -101,32 +586,17 @@ bool tinkerforge::reconnect()
 				ss << "Successfully connected to Tinkerforge Brick Daemon at " << _host << ":" << _port << ".";
 				_root->info(ss.str());
 				
+				// Sensors are resolved by the enumeration callbacks while the trigger loop
+				// continues. Sensors with a known device type can be polled right away.
 				_root->info("Enumerating Tinkerforge Bricklets...");
-				ipcon_register_callback(_ipcon, IPCON_CALLBACK_ENUMERATE, (void (*)(void))enumerateTFSensors, _root);
-				ipcon_enumerate(_ipcon);
-				std::this_thread::sleep_for(std::chrono::milliseconds(10000));
-				_root->info("Enumeration of Tinkerforge Bricklets done.");
-
-				/*
-				_root->info("Registering Tinkerforge callbacks...");
-				for(size_t i=0; i<_root->nSensors(); ++i)
 				{
-					if(_root->getSensor(i)->type() == sensor_tinkerforge)
-					{
-						sensorTinkerforge* tfSensor = dynamic_cast<sensorTinkerforge*>(_root->getSensor(i));
-
-						if(tfSensor->getTriggerEvent() != periodic)
-						{
-							std::stringstream cbss;
-							cbss << "  Register callback for Bricklet \'" << tfSensor->getUID() << "\' (" << getDeviceType_name(tfSensor->getDeviceType()) << "), debounce period: "<< tfSensor->getDebounceTime() << " ms.";
-							_root->info(cbss.str());
-
-							tfSensor->registerCallback();
-						}
-					}
+					std::lock_guard<std::mutex> lock(_enumerationMutex);
+					_enumeratedUIDs.clear();
+					_enumerating = (_bricklets.size() > 0);
+					_timestamp_enumerationStart = _root->currentTimestamp();
 				}
-				_root->info("Registration of Tinkerforge callbacks done.");
-				*/
+				ipcon_register_callback(_ipcon, IPCON_CALLBACK_ENUMERATE, (void (*)(void))enumerateTFSensors, this);
+				ipcon_enumerate(_ipcon);
 
 				return true;
 			}
@@ -140,12 +610,104 @@ bool tinkerforge::reconnect()
 			return false;
 		}
 
+		checkEnumeration();
 		return true;
 	}
 
 	return false;
 }
 
+static bool measureSensor(sensorTinkerforge* s, uint64_t currentTimestamp, logger* root)
+{
+	try
+	{
+		return s->measure(currentTimestamp);
+	}
+	catch(int e)
+	{
+		root->error("Error " + std::to_string(e) + " when measuring at sensor \'" + s->getSensorID() + "\'.");
+	}
+
+	return false;
+}
+
+void tinkerforge::pollSensors(uint64_t currentTimestamp, std::vector<sensorTinkerforge*> &measured)
+{
+	measured.clear();
+	if((_bricklets.size() == 0) || recovering())
+		return;
+
+	// Keeps the connection up, also for sensors that
+	// are not bound yet and wait for the enumeration:
+	bool connected = reconnect();
+
+	// While the enumeration is running, a Bricklet is only read once the
+	// callback thread has finished setting up its sensors (daemon, device
+	// type). Asking for it also reports a timeout if no Bricklet shows up.
+	bool enumerating = enumerationPending();
+
+	// Sensors that share a Bricklet are read one after the other,
+	// because they share its device handle.
+	std::vector<const std::vector<sensorTinkerforge*>*> due;
+	for(std::unordered_map<std::string, tfBricklet*>::const_iterator it = _bricklets.begin(); it != _bricklets.end(); ++it)
+	{
+		if(enumerating && !isEnumerated(it->first))
+			continue;
+
+		const std::vector<sensorTinkerforge*> &sensors = it->second->sensors;
+		for(size_t i=0; i<sensors.size(); ++i)
+		{
+			if((sensors.at(i)->getDaemon() == this) && sensors.at(i)->isDue(currentTimestamp))
+			{
+				due.push_back(&sensors);
+				break;
+			}
+		}
+	}
+
+	if(due.size() == 0)
+		return;
+
+	TRACE_SCOPE("tinkerforge.poll", getName());
+	std::vector<std::vector<char> > hasNewValue(due.size());
+	std::function<void(size_t)> pollBricklet = [&](size_t b)
+	{
+		const std::vector<sensorTinkerforge*> &sensors = *due.at(b);
+		hasNewValue.at(b).assign(sensors.size(), 0);
+
+		for(size_t i=0; i<sensors.size(); ++i)
+		{
+			if((sensors.at(i)->getDaemon() == this) && sensors.at(i)->isDue(currentTimestamp))
+				hasNewValue.at(b).at(i) = measureSensor(sensors.at(i), currentTimestamp, _root);
+		}
+	};
+
+	if((due.size() > 1) && (_pollThreads > 1) && connected)
+	{
+		if(_pollPool == NULL)
+			_pollPool = new workerPool(_pollThreads);
+
+		_pollingConcurrently = true;
+		_pollPool->run(due.size(), pollBricklet);
+		_pollingConcurrently = false;
+	}
+	else
+	{
+		// Without a connection, each sensor tries to reconnect as before.
+		for(size_t b=0; b<due.size(); ++b)
+			pollBricklet(b);
+	}
+
+	for(size_t b=0; b<due.size(); ++b)
+	{
+		for(size_t i=0; i<hasNewValue.at(b).size(); ++i)
+		{
+			if(hasNewValue.at(b).at(i))
+				measured.push_back(due.at(b)->at(i));
+		}
+	}
+}
+
 std::string getTFConnectionErrorText(int e)
 {
 	switch(e)
@@ -198,6 +760,9 @@ std::string getTFConnectionErrorText(int e)
 		case(E_WRONG_RESPONSE_LENGTH):
 			return "Wrong Response Length";
 			break;
+		case(E_NO_SENSOR_CONNECTED):
+			return "No Sensor Connected";
+			break;
 	}
 
 	return "Unknown Error";
@@ -331,36 +896,9 @@ std::string getDeviceType_nice(uint16_t device_identifier)
 
 
 
-void enumerateTFSensors(const char *uid, const char *connected_uid, char position, uint8_t hardware_version[3], uint8_t firmware_version[3], uint16_t device_identifier, uint8_t enumeration_type, logger* _root)
+void enumerateTFSensors(const char *uid, const char *connected_uid, char position, uint8_t hardware_version[3], uint8_t firmware_version[3], uint16_t device_identifier, uint8_t enumeration_type, tinkerforge* tinkerMan)
 {
-	if(device_identifier > 20)
-	{
-		std::stringstream ss;
-		ss<<"Found Bricklet \'"<<std::string(uid)<<"\' with device identifier "<<getDeviceType_nice(device_identifier) <<".";
-		_root->info(ss.str());
-
-		for(size_t s=0; s<_root->nSensors(); ++s)
-		{
-			// Check if this is a Tinkerforge sensor:
-			if(_root->getSensor(s)->type() == sensor_tinkerforge)
-			{
-				sensorTinkerforge* tfsensor = dynamic_cast<sensorTinkerforge*>(_root->getSensor(s));
-
-				if(tfsensor->getUID() == std::string(uid))
-				{
-					tfsensor->setDeviceType(static_cast<unsigned>(device_identifier));
-					if(tfsensor->getTriggerEvent() != periodic)
-					{
-						std::stringstream cbss;
-						cbss << "  Register callback for Bricklet \'" << tfsensor->getUID() << "\' (" << getDeviceType_name(tfsensor->getDeviceType()) << "), debounce period: "<< tfsensor->getDebounceTime() << " ms.";
-						_root->info(cbss.str());
-
-						tfsensor->registerCallback();
-					}
-				}
-			}
-		}
-	}
+	tinkerMan->deviceEnumerated(std::string(uid), device_identifier, enumeration_type);
 }
 
 #endif
\ No newline at end of file
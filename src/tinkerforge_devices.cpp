@@ -0,0 +1,992 @@
+#ifdef OPTION_TINKERFORGE
+
+#include "tinkerforge_devices.h"
+
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+
+#include "sensor_tinkerforge.h"
+#include "logger.h"
+
+// Raw values are read as integers in the Bricklet's unit and scaled to the logged unit:
+template<typename T> static double scaled(T raw, double divisor)
+{
+	return static_cast<double>(static_cast<int>(raw)) / divisor;
+}
+
+template<typename H, typename T> static int readScaled(int (*getter)(H*, T*), H* device, double divisor, double &value)
+{
+	T raw;
+	int result = getter(device, &raw);
+	if(result < 0)
+		return result;
+
+	value = scaled(raw, divisor);
+	return TF_VALUE;
+}
+
+#define TF_DEVICE_HANDLE(type, prefix) \
+	typedef type handle; \
+	static void create(handle* device, const char* uid, IPConnection* ipcon) { prefix##_create(device, uid, ipcon); } \
+	static void destroy(handle* device) { prefix##_destroy(device); }
+
+// Bricklets with one value, read by a single getter:
+#define TF_SIMPLE_DEVICE(id, type, prefix, getter, divisor) \
+	template<> struct tfDevice<id> : tfDeviceDefaults \
+	{ \
+		TF_DEVICE_HANDLE(type, prefix) \
+		static int read(handle* device, const tfChannel &c, double &value) \
+		{ \
+			return readScaled(getter, device, divisor, value); \
+		} \
+	};
+
+TF_SIMPLE_DEVICE(AMBIENT_LIGHT_DEVICE_IDENTIFIER,        AmbientLight,      ambient_light,        ambient_light_get_illuminance,             10.0)
+TF_SIMPLE_DEVICE(AMBIENT_LIGHT_V2_DEVICE_IDENTIFIER,     AmbientLightV2,    ambient_light_v2,     ambient_light_v2_get_illuminance,          100.0)
+TF_SIMPLE_DEVICE(AMBIENT_LIGHT_V3_DEVICE_IDENTIFIER,     AmbientLightV3,    ambient_light_v3,     ambient_light_v3_get_illuminance,          100.0)
+TF_SIMPLE_DEVICE(BAROMETER_DEVICE_IDENTIFIER,            Barometer,         barometer,            barometer_get_air_pressure,                1000.0)
+TF_SIMPLE_DEVICE(BAROMETER_V2_DEVICE_IDENTIFIER,         BarometerV2,       barometer_v2,         barometer_v2_get_air_pressure,             1000.0)
+TF_SIMPLE_DEVICE(CO2_DEVICE_IDENTIFIER,                  CO2,               co2,                  co2_get_co2_concentration,                 1.0)
+TF_SIMPLE_DEVICE(CURRENT12_DEVICE_IDENTIFIER,            Current12,         current12,            current12_get_current,                     1000.0)
+TF_SIMPLE_DEVICE(CURRENT25_DEVICE_IDENTIFIER,            Current25,         current25,            current25_get_current,                     1000.0)
+TF_SIMPLE_DEVICE(DISTANCE_IR_DEVICE_IDENTIFIER,          DistanceIR,        distance_ir,          distance_ir_get_distance,                  10.0)
+TF_SIMPLE_DEVICE(DISTANCE_IR_V2_DEVICE_IDENTIFIER,       DistanceIRV2,      distance_ir_v2,       distance_ir_v2_get_distance,               10.0)
+TF_SIMPLE_DEVICE(DISTANCE_US_DEVICE_IDENTIFIER,          DistanceUS,        distance_us,          distance_us_get_distance_value,            1.0)
+TF_SIMPLE_DEVICE(DISTANCE_US_V2_DEVICE_IDENTIFIER,       DistanceUSV2,      distance_us_v2,       distance_us_v2_get_distance,               10.0)
+TF_SIMPLE_DEVICE(DUST_DETECTOR_DEVICE_IDENTIFIER,        DustDetector,      dust_detector,        dust_detector_get_dust_density,            1.0)
+TF_SIMPLE_DEVICE(HALL_EFFECT_V2_DEVICE_IDENTIFIER,       HallEffectV2,      hall_effect_v2,       hall_effect_v2_get_magnetic_flux_density,  1.0)
+TF_SIMPLE_DEVICE(HUMIDITY_DEVICE_IDENTIFIER,             Humidity,          humidity,             humidity_get_humidity,                     10.0)
+TF_SIMPLE_DEVICE(HUMIDITY_V2_DEVICE_IDENTIFIER,          HumidityV2,        humidity_v2,          humidity_v2_get_humidity,                  100.0)
+TF_SIMPLE_DEVICE(LINE_DEVICE_IDENTIFIER,                 Line,              line,                 line_get_reflectivity,                     1.0)
+TF_SIMPLE_DEVICE(MOISTURE_DEVICE_IDENTIFIER,             Moisture,          moisture,             moisture_get_moisture_value,               1.0)
+TF_SIMPLE_DEVICE(SOUND_INTENSITY_DEVICE_IDENTIFIER,      SoundIntensity,    sound_intensity,      sound_intensity_get_intensity,             1.0)
+TF_SIMPLE_DEVICE(SOUND_PRESSURE_LEVEL_DEVICE_IDENTIFIER, SoundPressureLevel, sound_pressure_level, sound_pressure_level_get_decibel,        10.0)
+TF_SIMPLE_DEVICE(TEMPERATURE_DEVICE_IDENTIFIER,          Temperature,       temperature,          temperature_get_temperature,               100.0)
+TF_SIMPLE_DEVICE(TEMPERATURE_V2_DEVICE_IDENTIFIER,       TemperatureV2,     temperature_v2,       temperature_v2_get_temperature,            100.0)
+TF_SIMPLE_DEVICE(UV_LIGHT_DEVICE_IDENTIFIER,             UVLight,           uv_light,             uv_light_get_uv_light,                     10.0)
+TF_SIMPLE_DEVICE(VOLTAGE_DEVICE_IDENTIFIER,              Voltage,           voltage,              voltage_get_voltage,                       100.0)
+
+
+// Analog inputs that can average on the device. A polled value is then
+// the mean of many samples, and the rest period can be much longer.
+
+// Settings are mapped to the nearest step the Bricklet supports:
+static unsigned limited(unsigned value, unsigned min, unsigned max)
+{
+	if(value < min)
+		return min;
+	if(value > max)
+		return max;
+
+	return value;
+}
+
+// Index of the first step (ascending) that is at least the value:
+static uint8_t stepAtLeast(unsigned value, const unsigned* steps, size_t nSteps)
+{
+	size_t i = 0;
+	while((i+1 < nSteps) && (steps[i] < value))
+		++i;
+
+	return static_cast<uint8_t>(i);
+}
+
+// Index of the fastest rate (descending) that is not above the value:
+static uint8_t rateAtMost(unsigned value, const unsigned* rates, size_t nRates)
+{
+	size_t i = 0;
+	while((i+1 < nRates) && (rates[i] > value))
+		++i;
+
+	return static_cast<uint8_t>(i);
+}
+
+static const unsigned tfIndustrialDualAnalogInRates[] = {976, 488, 244, 122, 61, 4, 2, 1};
+static const unsigned tfIndustrialDual020mARates[]    = {240, 60, 15, 4};
+static const unsigned tfVoltageCurrentAveraging[]     = {1, 4, 16, 64, 128, 256, 512, 1024};
+static const unsigned tfAnalogInV3Oversampling[]      = {32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384};
+
+template<> struct tfDevice<ANALOG_IN_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(AnalogIn, analog_in)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		return readScaled(analog_in_get_voltage, device, 1000.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.sampleRate > 0)
+			return E_NOT_SUPPORTED;
+
+		return analog_in_set_averaging(device, static_cast<uint8_t>(limited(oversampling.averaging, 1, 255)));
+	}
+};
+
+template<> struct tfDevice<ANALOG_IN_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(AnalogInV2, analog_in_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		return readScaled(analog_in_v2_get_voltage, device, 1000.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.sampleRate > 0)
+			return E_NOT_SUPPORTED;
+
+		return analog_in_v2_set_moving_average(device, static_cast<uint8_t>(limited(oversampling.averaging, 1, 50)));
+	}
+};
+
+template<> struct tfDevice<ANALOG_IN_V3_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(AnalogInV3, analog_in_v3)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		return readScaled(analog_in_v3_get_voltage, device, 1000.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.sampleRate > 0)
+			return E_NOT_SUPPORTED;
+
+		return analog_in_v3_set_oversampling(device, stepAtLeast(oversampling.averaging, tfAnalogInV3Oversampling, 10));
+	}
+};
+
+template<> struct tfDevice<LOAD_CELL_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(LoadCell, load_cell)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		return readScaled(load_cell_get_weight, device, 1.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+		{
+			int result = load_cell_set_moving_average(device, static_cast<uint8_t>(limited(oversampling.averaging, 1, 40)));
+			if(result < 0)
+				return result;
+		}
+
+		if(oversampling.sampleRate > 0)
+		{
+			uint8_t rate, gain;
+			int result = load_cell_get_configuration(device, &rate, &gain);
+			if(result < 0)
+				return result;
+
+			rate = (oversampling.sampleRate >= 80) ? LOAD_CELL_RATE_80HZ : LOAD_CELL_RATE_10HZ;
+			return load_cell_set_configuration(device, rate, gain);
+		}
+
+		return E_OK;
+	}
+};
+
+template<> struct tfDevice<LOAD_CELL_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(LoadCellV2, load_cell_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		return readScaled(load_cell_v2_get_weight, device, 1.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+		{
+			int result = load_cell_v2_set_moving_average(device, static_cast<uint16_t>(limited(oversampling.averaging, 1, 100)));
+			if(result < 0)
+				return result;
+		}
+
+		if(oversampling.sampleRate > 0)
+		{
+			uint8_t rate, gain;
+			int result = load_cell_v2_get_configuration(device, &rate, &gain);
+			if(result < 0)
+				return result;
+
+			rate = (oversampling.sampleRate >= 80) ? LOAD_CELL_V2_RATE_80HZ : LOAD_CELL_V2_RATE_10HZ;
+			return load_cell_v2_set_configuration(device, rate, gain);
+		}
+
+		return E_OK;
+	}
+};
+
+
+// Bricklets with several values, selected by the channel:
+
+template<> struct tfDevice<AIR_QUALITY_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(AirQuality, air_quality)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t iaq_index, temperature, humidity, air_pressure;
+		uint8_t iaq_index_accuracy;
+		int result = air_quality_get_all_values(device, &iaq_index, &iaq_index_accuracy, &temperature, &humidity, &air_pressure);
+		if(result < 0)
+			return result;
+
+		switch(c.channel)
+		{
+			case(1):  value = scaled(temperature, 100.0); break;
+			case(2):  value = scaled(humidity, 100.0); break;
+			case(3):  value = scaled(air_pressure, 100.0); break;
+			default:  value = scaled(iaq_index, 1.0); break;
+		}
+
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<CO2_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(CO2V2, co2_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint16_t co2_concentration, humidity;
+		int16_t temperature;
+		int result = co2_v2_get_all_values(device, &co2_concentration, &temperature, &humidity);
+		if(result < 0)
+			return result;
+
+		switch(c.channel)
+		{
+			case(1):  value = scaled(temperature, 100.0); break;
+			case(2):  value = scaled(humidity, 100.0); break;
+			default:  value = scaled(co2_concentration, 1.0); break;
+		}
+
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<ENERGY_MONITOR_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(EnergyMonitor, energy_monitor)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t voltage, current, energy, real_power, apparent_power, reactive_power;
+		uint16_t power_factor, frequency;
+		int result = energy_monitor_get_energy_data(device, &voltage, &current, &energy, &real_power, &apparent_power, &reactive_power, &power_factor, &frequency);
+		if(result < 0)
+			return result;
+
+		switch(c.channel)
+		{
+			case(1):  value = scaled(current, 100.0); break;
+			case(2):  value = scaled(energy, 100.0); break;
+			case(3):  value = scaled(real_power, 100.0); break;
+			case(4):  value = scaled(apparent_power, 100.0); break;
+			case(5):  value = scaled(reactive_power, 100.0); break;
+			case(6):  value = scaled(power_factor, 1000.0); break;
+			case(7):  value = scaled(frequency, 100.0); break;
+			default:  value = scaled(voltage, 100.0); break;
+		}
+
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<INDUSTRIAL_DUAL_0_20MA_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDual020mA, industrial_dual_0_20ma)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t current;
+		int result = industrial_dual_0_20ma_get_current(device, (c.channel == 1) ? 1 : 0, &current);
+		if(result < 0)
+			return result;
+
+		value = scaled(current, 1000000.0);
+		return TF_VALUE;
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+			return E_NOT_SUPPORTED;
+
+		return industrial_dual_0_20ma_set_sample_rate(device, rateAtMost(oversampling.sampleRate, tfIndustrialDual020mARates, 4));
+	}
+};
+
+template<> struct tfDevice<INDUSTRIAL_DUAL_0_20MA_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDual020mAV2, industrial_dual_0_20ma_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t current;
+		int result = industrial_dual_0_20ma_v2_get_current(device, (c.channel == 1) ? 1 : 0, &current);
+		if(result < 0)
+			return result;
+
+		value = scaled(current, 1000000.0);
+		return TF_VALUE;
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+			return E_NOT_SUPPORTED;
+
+		return industrial_dual_0_20ma_v2_set_sample_rate(device, rateAtMost(oversampling.sampleRate, tfIndustrialDual020mARates, 4));
+	}
+};
+
+template<> struct tfDevice<INDUSTRIAL_DUAL_ANALOG_IN_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDualAnalogIn, industrial_dual_analog_in)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t voltage;
+		int result = industrial_dual_analog_in_get_voltage(device, (c.channel == 1) ? 1 : 0, &voltage);
+		if(result < 0)
+			return result;
+
+		value = scaled(voltage, 1000.0);
+		return TF_VALUE;
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+			return E_NOT_SUPPORTED;
+
+		return industrial_dual_analog_in_set_sample_rate(device, rateAtMost(oversampling.sampleRate, tfIndustrialDualAnalogInRates, 8));
+	}
+};
+
+template<> struct tfDevice<INDUSTRIAL_DUAL_ANALOG_IN_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDualAnalogInV2, industrial_dual_analog_in_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		int32_t voltage;
+		int result = industrial_dual_analog_in_v2_get_voltage(device, (c.channel == 1) ? 1 : 0, &voltage);
+		if(result < 0)
+			return result;
+
+		value = scaled(voltage, 1000.0);
+		return TF_VALUE;
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.averaging > 0)
+			return E_NOT_SUPPORTED;
+
+		return industrial_dual_analog_in_v2_set_sample_rate(device, rateAtMost(oversampling.sampleRate, tfIndustrialDualAnalogInRates, 8));
+	}
+};
+
+template<> struct tfDevice<LASER_RANGE_FINDER_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(LaserRangeFinder, laser_range_finder)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		laser_range_finder_enable_laser(device);
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+		uint16_t distance;
+		int result = laser_range_finder_get_distance(device, &distance);
+		laser_range_finder_disable_laser(device);
+		if(result < 0)
+			return result;
+
+		value = scaled(distance, 1.0);
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<LASER_RANGE_FINDER_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(LaserRangeFinderV2, laser_range_finder_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		laser_range_finder_v2_set_enable(device, true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+		int16_t distance;
+		int result = laser_range_finder_v2_get_distance(device, &distance);
+		laser_range_finder_v2_set_enable(device, false);
+		if(result < 0)
+			return result;
+
+		value = scaled(distance, 1.0);
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<PARTICULATE_MATTER_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(ParticulateMatter, particulate_matter)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint16_t pm10, pm25, pm100;
+		int result = particulate_matter_get_pm_concentration(device, &pm10, &pm25, &pm100);
+		if(result < 0)
+			return result;
+
+		switch(c.channel)
+		{
+			case(2):
+			case(25):  value = scaled(pm25, 1.0); break;
+			case(3):
+			case(100): value = scaled(pm100, 1.0); break;
+			default:   value = scaled(pm10, 1.0); break;
+		}
+
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<PTC_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(PTC, ptc)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		bool connected = false;
+		ptc_is_sensor_connected(device, &connected);
+		if(!connected)
+			return E_NO_SENSOR_CONNECTED;
+
+		return readScaled(ptc_get_temperature, device, 100.0, value);
+	}
+};
+
+template<> struct tfDevice<PTC_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(PTCV2, ptc_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		bool connected = false;
+		ptc_v2_is_sensor_connected(device, &connected);
+		if(!connected)
+			return E_NO_SENSOR_CONNECTED;
+
+		return readScaled(ptc_v2_get_temperature, device, 100.0, value);
+	}
+};
+
+template<> struct tfDevice<TEMPERATURE_IR_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(TemperatureIR, temperature_ir)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel == 1)
+			return readScaled(temperature_ir_get_object_temperature, device, 10.0, value);
+
+		return readScaled(temperature_ir_get_ambient_temperature, device, 10.0, value);
+	}
+};
+
+template<> struct tfDevice<TEMPERATURE_IR_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(TemperatureIRV2, temperature_ir_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel == 1)
+			return readScaled(temperature_ir_v2_get_object_temperature, device, 10.0, value);
+
+		return readScaled(temperature_ir_v2_get_ambient_temperature, device, 10.0, value);
+	}
+};
+
+template<> struct tfDevice<UV_LIGHT_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(UVLightV2, uv_light_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel == 1)  // UV-B
+			return readScaled(uv_light_v2_get_uvb, device, 10.0, value);
+		if(c.channel == 2)  // UV index
+			return readScaled(uv_light_v2_get_uvi, device, 10.0, value);
+
+		return readScaled(uv_light_v2_get_uva, device, 10.0, value);
+	}
+};
+
+template<> struct tfDevice<VOLTAGE_CURRENT_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(VoltageCurrent, voltage_current)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel == 1)
+			return readScaled(voltage_current_get_current, device, 1000.0, value);
+
+		return readScaled(voltage_current_get_voltage, device, 1000.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.sampleRate > 0)
+			return E_NOT_SUPPORTED;
+
+		// Keeps the conversion times:
+		uint8_t averaging, voltageConversionTime, currentConversionTime;
+		int result = voltage_current_get_configuration(device, &averaging, &voltageConversionTime, &currentConversionTime);
+		if(result < 0)
+			return result;
+
+		averaging = stepAtLeast(oversampling.averaging, tfVoltageCurrentAveraging, 8);
+		return voltage_current_set_configuration(device, averaging, voltageConversionTime, currentConversionTime);
+	}
+};
+
+template<> struct tfDevice<VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(VoltageCurrentV2, voltage_current_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel == 1)
+			return readScaled(voltage_current_v2_get_current, device, 1000.0, value);
+
+		return readScaled(voltage_current_v2_get_voltage, device, 1000.0, value);
+	}
+
+	static int configure(handle* device, const tfOversampling &oversampling)
+	{
+		if(oversampling.sampleRate > 0)
+			return E_NOT_SUPPORTED;
+
+		// Keeps the conversion times:
+		uint8_t averaging, voltageConversionTime, currentConversionTime;
+		int result = voltage_current_v2_get_configuration(device, &averaging, &voltageConversionTime, &currentConversionTime);
+		if(result < 0)
+			return result;
+
+		averaging = stepAtLeast(oversampling.averaging, tfVoltageCurrentAveraging, 8);
+		return voltage_current_v2_set_configuration(device, averaging, voltageConversionTime, currentConversionTime);
+	}
+};
+
+
+// GPS: channels 0 and 1 are latitude and longitude, southern and western ones negative.
+
+static double coordinate(uint32_t raw, bool negative)
+{
+	double value = scaled(raw, 1000000.0);
+	return negative ? -value : value;
+}
+
+template<> struct tfDevice<GPS_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(GPS, gps)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint32_t latitude, longitude;
+		char ns, ew;
+		uint16_t pdop, hdop, vdop, epe;
+		int result = gps_get_coordinates(device, &latitude, &ns, &longitude, &ew, &pdop, &hdop, &vdop, &epe);
+		if(result < 0)
+			return result;
+
+		switch(c.channel)
+		{
+			case(0):  value = coordinate(latitude, ns == 'S'); break;
+			case(1):  value = coordinate(longitude, ew == 'W'); break;
+			case(6):  value = scaled(pdop, 100.0); break;
+			case(7):  value = scaled(hdop, 100.0); break;
+			case(8):  value = scaled(vdop, 100.0); break;
+			case(9):  value = scaled(epe, 100.0); break;
+			default:  value = 0; break;
+		}
+
+		return TF_VALUE;
+	}
+};
+
+// GPS 2.0 and 3.0 have the same getters, with their own prefix.
+#define TF_GPS_DEVICE(id, type, prefix, satelliteSystem) \
+	template<> struct tfDevice<id> : tfDeviceDefaults \
+	{ \
+		TF_DEVICE_HANDLE(type, prefix) \
+		\
+		static int read(handle* device, const tfChannel &c, double &value) \
+		{ \
+			int result = TF_NO_VALUE; \
+			if(c.channel <= 1) \
+			{ \
+				uint32_t latitude, longitude; \
+				char ns, ew; \
+				result = prefix##_get_coordinates(device, &latitude, &ns, &longitude, &ew); \
+				if(result >= 0) \
+					value = (c.channel == 0) ? coordinate(latitude, ns == 'S') : coordinate(longitude, ew == 'W'); \
+			} \
+			else if(c.channel <= 3) \
+			{ \
+				int32_t altitude, geoidal_separation; \
+				result = prefix##_get_altitude(device, &altitude, &geoidal_separation); \
+				if(result >= 0) \
+					value = scaled((c.channel == 2) ? altitude : geoidal_separation, 100.0); \
+			} \
+			else if(c.channel <= 5) \
+			{ \
+				uint32_t course, speed; \
+				result = prefix##_get_motion(device, &course, &speed); \
+				if(result >= 0) \
+					value = scaled((c.channel == 4) ? speed : course, 100.0); \
+			} \
+			else if(c.channel <= 8) \
+			{ \
+				uint8_t satNumbers[12]; \
+				uint8_t satNumbersLength, fix; \
+				uint16_t pdop, hdop, vdop; \
+				result = prefix##_get_satellite_system_status(device, satelliteSystem, satNumbers, &satNumbersLength, &fix, &pdop, &hdop, &vdop); \
+				if(result >= 0) \
+					value = scaled((c.channel == 6) ? pdop : ((c.channel == 7) ? hdop : vdop), 100.0); \
+			} \
+			\
+			return result; \
+		} \
+	};
+
+TF_GPS_DEVICE(GPS_V2_DEVICE_IDENTIFIER, GPSV2, gps_v2, GPS_V2_SATELLITE_SYSTEM_GPS)
+TF_GPS_DEVICE(GPS_V3_DEVICE_IDENTIFIER, GPSV3, gps_v3, GPS_V3_SATELLITE_SYSTEM_GPS)
+
+
+// Digital inputs. Sensors with a trigger event other than 'periodic'
+// are called back on input changes instead of being polled.
+
+// One callback is registered per UID. It serves all sensors
+// that are read from this Bricklet. The time of the edge is taken
+// first thing, before any sensor is served, so that counters get
+// the distance between pulses as the callback thread saw them.
+static void eventTime(const tfBricklet* bricklet, uint64_t &timestamp, uint64_t &monotonic)
+{
+	logger* root = bricklet->daemon->ptLogger();
+	monotonic = root->monotonicTimestamp();
+	timestamp = root->currentTimestamp();
+}
+
+static void callback_io4(uint8_t interrupt_mask, uint8_t value_mask, tfBricklet* bricklet)
+{
+	uint64_t timestamp, monotonic;
+	eventTime(bricklet, timestamp, monotonic);
+
+	for(size_t i=0; i<bricklet->sensors.size(); ++i)
+	{
+		sensorTinkerforge* s = bricklet->sensors.at(i);
+		if((s->getDaemon() == bricklet->daemon) && (interrupt_mask == s->getBitMask()))
+			s->inputChanged((value_mask & s->getBitMask()) != 0, timestamp, monotonic);
+	}
+}
+
+static void callback_io16(char port, uint8_t interrupt_mask, uint8_t value_mask, tfBricklet* bricklet)
+{
+	uint64_t timestamp, monotonic;
+	eventTime(bricklet, timestamp, monotonic);
+
+	for(size_t i=0; i<bricklet->sensors.size(); ++i)
+	{
+		sensorTinkerforge* s = bricklet->sensors.at(i);
+		if((s->getDaemon() == bricklet->daemon) && (port == s->getIOPort()) && (interrupt_mask == s->getBitMask()))
+			s->inputChanged((value_mask & s->getBitMask()) != 0, timestamp, monotonic);
+	}
+}
+
+// For IO-4 2.0 and IO-16 2.0 Bricklet
+static void callback_io_v2(uint8_t channel, bool changed, bool value, tfBricklet* bricklet)
+{
+	uint64_t timestamp, monotonic;
+	eventTime(bricklet, timestamp, monotonic);
+
+	for(size_t i=0; i<bricklet->sensors.size(); ++i)
+	{
+		sensorTinkerforge* s = bricklet->sensors.at(i);
+		if((s->getDaemon() == bricklet->daemon) && (channel == s->getChannel()))
+			s->inputChanged(value, timestamp, monotonic);
+	}
+}
+
+template<> struct tfDevice<INDUSTRIAL_DIGITAL_IN_4_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDigitalIn4, industrial_digital_in_4)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint16_t value_mask;
+		int result = industrial_digital_in_4_get_value(device, &value_mask);
+		if(result < 0)
+			return result;
+
+		value = ((value_mask & c.bitMask) > 0) ? 1 : 0;
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<INDUSTRIAL_DIGITAL_IN_4_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IndustrialDigitalIn4V2, industrial_digital_in_4_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel >= 4)
+			return TF_NO_VALUE;
+
+		bool values[4];
+		int result = industrial_digital_in_4_v2_get_value(device, values);
+		if(result < 0)
+			return result;
+
+		value = values[c.channel] ? 1 : 0;
+		return TF_VALUE;
+	}
+};
+
+template<> struct tfDevice<IO4_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IO4, io4)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint8_t value_mask;
+		int result = io4_get_value(device, &value_mask);
+		if(result < 0)
+			return result;
+
+		value = ((value_mask & c.bitMask) > 0) ? 1 : 0;
+		return TF_VALUE;
+	}
+
+	static int enableCallback(handle* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+	{
+		int result = io4_set_debounce_period(device, settings.debounceTime);
+		if(result < 0)
+			return result;
+
+		io4_register_callback(device, IO4_CALLBACK_INTERRUPT, (void (*)(void))callback_io4, bricklet);
+		return io4_set_interrupt(device, 15);  // Register callback on all channels. Sort out upon call receival.
+	}
+};
+
+template<> struct tfDevice<IO4_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IO4V2, io4_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel >= 4)
+			return TF_NO_VALUE;
+
+		bool values[4];
+		int result = io4_v2_get_value(device, values);
+		if(result < 0)
+			return result;
+
+		value = values[c.channel] ? 1 : 0;
+		return TF_VALUE;
+	}
+
+	static int enableCallback(handle* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+	{
+		int result = io4_v2_set_edge_count_configuration(device, settings.channel, IO4_V2_EDGE_TYPE_BOTH, settings.debounceTime);
+		if(result < 0)
+			return result;
+
+		io4_v2_register_callback(device, IO4_V2_CALLBACK_INPUT_VALUE, (void (*)(void))callback_io_v2, bricklet);
+		return io4_v2_set_input_value_callback_configuration(device, settings.channel, settings.period, true);
+	}
+};
+
+template<> struct tfDevice<IO16_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IO16, io16)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		uint8_t value_mask;
+		int result = io16_get_port(device, c.ioPort, &value_mask);
+		if(result < 0)
+			return result;
+
+		value = ((value_mask & c.bitMask) > 0) ? 1 : 0;
+		return TF_VALUE;
+	}
+
+	static int enableCallback(handle* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+	{
+		int result = io16_set_debounce_period(device, settings.debounceTime);
+		if(result < 0)
+			return result;
+
+		io16_register_callback(device, IO16_CALLBACK_INTERRUPT, (void (*)(void))callback_io16, bricklet);
+
+		// Enable interrupt on all pins. Bit mask will be applied upon callback.
+		return io16_set_port_interrupt(device, settings.ioPort, 15);
+	}
+};
+
+template<> struct tfDevice<IO16_V2_DEVICE_IDENTIFIER> : tfDeviceDefaults
+{
+	TF_DEVICE_HANDLE(IO16V2, io16_v2)
+
+	static int read(handle* device, const tfChannel &c, double &value)
+	{
+		if(c.channel >= 16)
+			return TF_NO_VALUE;
+
+		bool values[16];
+		int result = io16_v2_get_value(device, values);
+		if(result < 0)
+			return result;
+
+		value = values[c.channel] ? 1 : 0;
+		return TF_VALUE;
+	}
+
+	static int enableCallback(handle* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+	{
+		int result = io16_v2_set_edge_count_configuration(device, settings.channel, IO16_V2_EDGE_TYPE_BOTH, settings.debounceTime);
+		if(result < 0)
+			return result;
+
+		io16_v2_register_callback(device, IO16_V2_CALLBACK_INPUT_VALUE, (void (*)(void))callback_io_v2, bricklet);
+		return io16_v2_set_input_value_callback_configuration(device, settings.channel, settings.period, true);
+	}
+};
+
+
+// Registry: the descriptors' functions behind type-erased handles.
+
+template<uint16_t id> static void* createDevice(const char* uid, IPConnection* ipcon)
+{
+	typename tfDevice<id>::handle* device = new typename tfDevice<id>::handle();
+	tfDevice<id>::create(device, uid, ipcon);
+	return device;
+}
+
+template<uint16_t id> static void destroyDevice(void* device)
+{
+	typename tfDevice<id>::handle* d = static_cast<typename tfDevice<id>::handle*>(device);
+	tfDevice<id>::destroy(d);
+	delete d;
+}
+
+template<uint16_t id> static int readDevice(void* device, const tfChannel &channel, double &value)
+{
+	return tfDevice<id>::read(static_cast<typename tfDevice<id>::handle*>(device), channel, value);
+}
+
+template<uint16_t id> static int configureDevice(void* device, const tfOversampling &oversampling)
+{
+	return tfDevice<id>::configure(static_cast<typename tfDevice<id>::handle*>(device), oversampling);
+}
+
+template<uint16_t id> static int enableDeviceCallback(void* device, const tfCallbackSettings &settings, tfBricklet* bricklet)
+{
+	return tfDevice<id>::enableCallback(static_cast<typename tfDevice<id>::handle*>(device), settings, bricklet);
+}
+
+#define TF_DRIVER(id) {id, createDevice<id>, destroyDevice<id>, readDevice<id>, configureDevice<id>, enableDeviceCallback<id>}
+
+static const tfDeviceDriver tfDeviceDrivers[] = {
+	TF_DRIVER(AIR_QUALITY_DEVICE_IDENTIFIER),
+	TF_DRIVER(AMBIENT_LIGHT_DEVICE_IDENTIFIER),
+	TF_DRIVER(AMBIENT_LIGHT_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(AMBIENT_LIGHT_V3_DEVICE_IDENTIFIER),
+	TF_DRIVER(ANALOG_IN_DEVICE_IDENTIFIER),
+	TF_DRIVER(ANALOG_IN_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(ANALOG_IN_V3_DEVICE_IDENTIFIER),
+	TF_DRIVER(BAROMETER_DEVICE_IDENTIFIER),
+	TF_DRIVER(BAROMETER_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(CO2_DEVICE_IDENTIFIER),
+	TF_DRIVER(CO2_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(CURRENT12_DEVICE_IDENTIFIER),
+	TF_DRIVER(CURRENT25_DEVICE_IDENTIFIER),
+	TF_DRIVER(DISTANCE_IR_DEVICE_IDENTIFIER),
+	TF_DRIVER(DISTANCE_IR_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(DISTANCE_US_DEVICE_IDENTIFIER),
+	TF_DRIVER(DISTANCE_US_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(DUST_DETECTOR_DEVICE_IDENTIFIER),
+	TF_DRIVER(ENERGY_MONITOR_DEVICE_IDENTIFIER),
+	TF_DRIVER(GPS_DEVICE_IDENTIFIER),
+	TF_DRIVER(GPS_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(GPS_V3_DEVICE_IDENTIFIER),
+	TF_DRIVER(HALL_EFFECT_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(HUMIDITY_DEVICE_IDENTIFIER),
+	TF_DRIVER(HUMIDITY_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DIGITAL_IN_4_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DIGITAL_IN_4_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DUAL_0_20MA_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DUAL_0_20MA_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DUAL_ANALOG_IN_DEVICE_IDENTIFIER),
+	TF_DRIVER(INDUSTRIAL_DUAL_ANALOG_IN_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(IO4_DEVICE_IDENTIFIER),
+	TF_DRIVER(IO4_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(IO16_DEVICE_IDENTIFIER),
+	TF_DRIVER(IO16_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(LASER_RANGE_FINDER_DEVICE_IDENTIFIER),
+	TF_DRIVER(LASER_RANGE_FINDER_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(LINE_DEVICE_IDENTIFIER),
+	TF_DRIVER(LOAD_CELL_DEVICE_IDENTIFIER),
+	TF_DRIVER(LOAD_CELL_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(MOISTURE_DEVICE_IDENTIFIER),
+	TF_DRIVER(PARTICULATE_MATTER_DEVICE_IDENTIFIER),
+	TF_DRIVER(PTC_DEVICE_IDENTIFIER),
+	TF_DRIVER(PTC_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(SOUND_INTENSITY_DEVICE_IDENTIFIER),
+	TF_DRIVER(SOUND_PRESSURE_LEVEL_DEVICE_IDENTIFIER),
+	TF_DRIVER(TEMPERATURE_DEVICE_IDENTIFIER),
+	TF_DRIVER(TEMPERATURE_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(TEMPERATURE_IR_DEVICE_IDENTIFIER),
+	TF_DRIVER(TEMPERATURE_IR_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(UV_LIGHT_DEVICE_IDENTIFIER),
+	TF_DRIVER(UV_LIGHT_V2_DEVICE_IDENTIFIER),
+	TF_DRIVER(VOLTAGE_DEVICE_IDENTIFIER),
+	TF_DRIVER(VOLTAGE_CURRENT_DEVICE_IDENTIFIER),
+	TF_DRIVER(VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER)
+};
+
+const tfDeviceDriver* getTFDeviceDriver(uint16_t deviceIdentifier)
+{
+	// Built once, on first use:
+	static const std::unordered_map<uint16_t, const tfDeviceDriver*> index = []
+	{
+		std::unordered_map<uint16_t, const tfDeviceDriver*> drivers;
+		for(size_t i=0; i<sizeof(tfDeviceDrivers)/sizeof(tfDeviceDrivers[0]); ++i)
+			drivers[tfDeviceDrivers[i].deviceIdentifier] = &tfDeviceDrivers[i];
+		return drivers;
+	}();
+
+	std::unordered_map<uint16_t, const tfDeviceDriver*>::const_iterator it = index.find(deviceIdentifier);
+	if(it == index.end())
+		return NULL;
+
+	return it->second;
+}
+
+#endif
@@ -0,0 +1,248 @@
+#include "trace.h"
+
+#ifdef OPTION_TRACE
+
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_set>
+#include <chrono>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+struct traceEvent
+{
+	long        tid;    // a buffer is reused by later threads
+	const char* name;
+	char        detail[TRACE_DETAIL_SIZE];
+	uint64_t    start;  // µs
+	uint64_t    duration;
+};
+
+/* Ring buffer of one thread. Only its own thread writes; a dump copies
+   the events and afterwards discards those that the writer may have
+   overwritten in the meantime. Threads of the worker pools and the
+   Tinkerforge callbacks come and go with their connections: when a
+   thread ends, its buffer is handed on to the next new thread, which
+   continues the ring, so the last events of the old thread are kept
+   until they are overwritten. Buffers are never freed. */
+struct traceBuffer
+{
+	std::atomic<uint64_t> written;  // events since the start
+	traceEvent events[TRACE_BUFFER_EVENTS];
+};
+
+static std::mutex                _buffersMutex;  // to add, hand on and dump buffers
+static std::vector<traceBuffer*> _buffers;
+static std::vector<traceBuffer*> _freeBuffers;   // of threads that have ended
+static volatile sig_atomic_t     _dumpRequested = 0;
+
+struct threadBuffer
+{
+	traceBuffer* buffer;
+	long         tid;
+
+	~threadBuffer()
+	{
+		if(buffer != NULL)
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			_freeBuffers.push_back(buffer);
+		}
+	}
+};
+
+static thread_local threadBuffer _threadBuffer = {NULL, 0};
+
+static threadBuffer& ownBuffer()
+{
+	if(_threadBuffer.buffer == NULL)
+	{
+		_threadBuffer.tid = syscall(SYS_gettid);
+
+		std::lock_guard<std::mutex> lock(_buffersMutex);
+		if(_freeBuffers.size() > 0)
+		{
+			_threadBuffer.buffer = _freeBuffers.back();
+			_freeBuffers.pop_back();
+		}
+		else
+		{
+			traceBuffer* b = new traceBuffer();
+			b->written = 0;
+			_buffers.push_back(b);
+			_threadBuffer.buffer = b;
+		}
+	}
+
+	return _threadBuffer;
+}
+
+static void copyDetail(char* target, const char* detail)
+{
+	if(detail != NULL)
+	{
+		strncpy(target, detail, TRACE_DETAIL_SIZE - 1);
+		target[TRACE_DETAIL_SIZE - 1] = 0;
+	}
+	else
+	{
+		target[0] = 0;
+	}
+}
+
+uint64_t tracer::now()
+{
+	const auto t = std::chrono::steady_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count());
+}
+
+void tracer::record(const char* name, const char* detail, uint64_t start, uint64_t end)
+{
+	threadBuffer &t = ownBuffer();
+	traceBuffer* b = t.buffer;
+	uint64_t n = b->written.load(std::memory_order_relaxed);
+
+	traceEvent &e = b->events[n % TRACE_BUFFER_EVENTS];
+	e.tid  = t.tid;
+	e.name = name;
+	copyDetail(e.detail, detail);
+	e.start = start;
+	e.duration = end - start;
+
+	b->written.store(n + 1, std::memory_order_release);
+}
+
+static void requestDump(int signal)
+{
+	_dumpRequested = 1;
+}
+
+void tracer::installSignalHandler()
+{
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = requestDump;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &action, NULL);
+}
+
+bool tracer::dumpRequested()
+{
+	if(_dumpRequested != 0)
+	{
+		_dumpRequested = 0;
+		return true;
+	}
+
+	return false;
+}
+
+static void writeEscaped(FILE* f, const char* text)
+{
+	for(const char* c = text; *c != 0; ++c)
+	{
+		if((*c == '"') || (*c == '\\'))
+			fputc('\\', f);
+
+		if(static_cast<unsigned char>(*c) >= 0x20)
+			fputc(*c, f);
+	}
+}
+
+size_t tracer::dump(const std::string &filename)
+{
+	FILE* f = fopen(filename.c_str(), "w");
+	if(f == NULL)
+		return 0;
+
+	long pid = static_cast<long>(getpid());
+	size_t nEvents = 0;
+	std::vector<traceEvent> events;
+	std::unordered_set<long> namedThreads;
+
+	std::lock_guard<std::mutex> lock(_buffersMutex);
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for(size_t i=0; i<_buffers.size(); ++i)
+	{
+		traceBuffer* b = _buffers.at(i);
+
+		uint64_t last  = b->written.load(std::memory_order_acquire);
+		uint64_t first = (last > TRACE_BUFFER_EVENTS) ? (last - TRACE_BUFFER_EVENTS) : 0;
+
+		events.clear();
+		for(uint64_t n=first; n<last; ++n)
+			events.push_back(b->events[n % TRACE_BUFFER_EVENTS]);
+
+		// Events that were overwritten while they were copied,
+		// including the one that might be being written:
+		uint64_t lastAfterCopy = b->written.load(std::memory_order_acquire);
+		uint64_t nOverwritten = 0;
+		if((lastAfterCopy + 1) > (first + TRACE_BUFFER_EVENTS))
+			nOverwritten = lastAfterCopy + 1 - (first + TRACE_BUFFER_EVENTS);
+
+		for(size_t k=nOverwritten; k<events.size(); ++k)
+		{
+			const traceEvent &e = events.at(k);
+			if(namedThreads.insert(e.tid).second)
+			{
+				const char* threadName = (e.tid == pid) ? "main" : "thread";
+				fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s %ld\"}}",
+					(namedThreads.size() > 1) ? ",\n" : "", pid, e.tid, threadName, e.tid);
+			}
+
+			fprintf(f, ",\n{\"name\":\"");
+			writeEscaped(f, e.name);
+			fprintf(f, "\",\"cat\":\"sensorlogger\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%ld,\"tid\":%ld",
+				static_cast<unsigned long long>(e.start), static_cast<unsigned long long>(e.duration), pid, e.tid);
+
+			if(e.detail[0] != 0)
+			{
+				fprintf(f, ",\"args\":{\"detail\":\"");
+				writeEscaped(f, e.detail);
+				fprintf(f, "\"}");
+			}
+
+			fprintf(f, "}");
+			++nEvents;
+		}
+	}
+	fprintf(f, "\n]}\n");
+
+	fclose(f);
+	return nEvents;
+}
+
+
+traceScope::traceScope(const char* name)
+{
+	_name = name;
+	_detail[0] = 0;
+	_start = tracer::now();
+}
+
+traceScope::traceScope(const char* name, const char* detail)
+{
+	_name = name;
+	copyDetail(_detail, detail);
+	_start = tracer::now();
+}
+
+traceScope::traceScope(const char* name, const std::string &detail)
+{
+	_name = name;
+	copyDetail(_detail, detail.c_str());
+	_start = tracer::now();
+}
+
+traceScope::~traceScope()
+{
+	tracer::record(_name, _detail, _start, tracer::now());
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "workerpool.h"
+
+workerPool::workerPool(unsigned nThreads)
+{
+	_task     = NULL;
+	_nTasks   = 0;
+	_nextTask = 0;
+	_nBusy    = 0;
+	_stop     = false;
+
+	for(unsigned i=1; i<nThreads; ++i)
+		_threads.push_back(new std::thread(&workerPool::work, this));
+}
+
+workerPool::~workerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wakeUp.notify_all();
+
+	for(size_t i=0; i<_threads.size(); ++i)
+	{
+		_threads.at(i)->join();
+		delete _threads.at(i);
+	}
+}
+
+unsigned workerPool::nThreads() const
+{
+	return static_cast<unsigned>(_threads.size() + 1);
+}
+
+// Takes tasks of the current batch until none are left. Called with the lock held.
+void workerPool::runTasks(std::unique_lock<std::mutex> &lock)
+{
+	while(_nextTask < _nTasks)
+	{
+		size_t i = _nextTask++;
+		++_nBusy;
+
+		lock.unlock();
+		(*_task)(i);
+		lock.lock();
+
+		--_nBusy;
+	}
+
+	if(_nBusy == 0)
+		_done.notify_all();
+}
+
+void workerPool::work()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(true)
+	{
+		_wakeUp.wait(lock, [this]{ return _stop || (_nextTask < _nTasks); });
+		if(_stop)
+			return;
+
+		runTasks(lock);
+	}
+}
+
+void workerPool::run(size_t nTasks, const std::function<void(size_t)> &task)
+{
+	if(nTasks == 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_task     = &task;
+	_nTasks   = nTasks;
+	_nextTask = 0;
+
+	if(nTasks > 1)
+		_wakeUp.notify_all();
+
+	runTasks(lock);
+	_done.wait(lock, [this]{ return (_nextTask >= _nTasks) && (_nBusy == 0); });
+
+	_task   = NULL;
+	_nTasks = 0;
+	_nextTask = 0;
+}